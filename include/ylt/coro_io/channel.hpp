@@ -16,9 +16,17 @@
 #pragma once
 #include <async_simple/coro/Lazy.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "client_pool.hpp"
 #include "io_context_pool.hpp"
@@ -26,9 +34,28 @@ namespace coro_io {
 
 enum class load_blance_algorithm {
   RR = 0,  // round-robin
-  random = 1
+  random = 1,
+  // power of two choices, pick the one with less in-flight requests and
+  // lower latency of two random hosts.
+  least_loaded = 2,
+  // route the requests with the same key to the same host, see
+  // channel::send_request(op, key).
+  consistent_hash = 3
 };
 
+namespace detail {
+// the finalizer of splitmix64.
+inline uint64_t mix_hash(uint64_t h) {
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+inline uint64_t hash_key(std::string_view key) {
+  // std::hash may be an identity-like function, so mix it.
+  return mix_hash(std::hash<std::string_view>{}(key));
+}
+}  // namespace detail
+
 template <typename client_t, typename io_context_pool_t = io_context_pool>
 class channel {
   using client_pool_t = client_pool<client_t, io_context_pool_t>;
@@ -46,20 +73,75 @@ class channel {
     std::unique_ptr<std::atomic<uint32_t>> index =
         std::make_unique<std::atomic<uint32_t>>();
     async_simple::coro::Lazy<std::shared_ptr<client_pool_t>> operator()(
-        const channel& channel) {
+        const channel& channel, std::optional<uint64_t>) {
       auto i = index->fetch_add(1, std::memory_order_relaxed);
       co_return channel.client_pools_[i % channel.client_pools_.size()];
     }
   };
   struct RandomLoadBlancer {
     async_simple::coro::Lazy<std::shared_ptr<client_pool_t>> operator()(
-        const channel& channel) {
+        const channel& channel, std::optional<uint64_t>) {
       static thread_local std::default_random_engine e;
       std::uniform_int_distribution rnd{std::size_t{0},
                                         channel.client_pools_.size() - 1};
       co_return channel.client_pools_[rnd(e)];
     }
   };
+  struct LeastLoadedBlancer {
+    async_simple::coro::Lazy<std::shared_ptr<client_pool_t>> operator()(
+        const channel& channel, std::optional<uint64_t>) {
+      static thread_local std::default_random_engine e;
+      auto& pools = channel.client_pools_;
+      std::uniform_int_distribution rnd1{std::size_t{0}, pools.size() - 1};
+      std::uniform_int_distribution rnd2{std::size_t{0}, pools.size() - 2};
+      auto i = rnd1(e), j = rnd2(e);
+      if (j >= i) {
+        ++j;
+      }
+      co_return cost(*pools[i]) <= cost(*pools[j]) ? pools[i] : pools[j];
+    }
+    static uint64_t cost(const client_pool_t& pool) {
+      // an untried host has no latency, so it gets requests soon.
+      return (uint64_t{pool.in_flight_count()} + 1) *
+             (static_cast<uint64_t>(pool.latency().count()) + 1);
+    }
+  };
+  struct ConsistentHashLoadBlancer {
+    static constexpr std::size_t virtual_node_count = 160;
+    // the hash ring: (hash of the virtual node, index of the client pool).
+    std::vector<std::pair<uint64_t, std::size_t>> ring;
+    ConsistentHashLoadBlancer(
+        const std::vector<std::shared_ptr<client_pool_t>>& client_pools) {
+      ring.reserve(client_pools.size() * virtual_node_count);
+      for (std::size_t i = 0; i < client_pools.size(); ++i) {
+        std::string node{client_pools[i]->get_host_name()};
+        node.push_back('#');
+        auto host_len = node.size();
+        for (std::size_t j = 0; j < virtual_node_count; ++j) {
+          node.resize(host_len);
+          node.append(std::to_string(j));
+          ring.emplace_back(detail::hash_key(node), i);
+        }
+      }
+      std::sort(ring.begin(), ring.end());
+    }
+    async_simple::coro::Lazy<std::shared_ptr<client_pool_t>> operator()(
+        const channel& channel, std::optional<uint64_t> key_hash) {
+      if (!key_hash) {
+        static thread_local std::mt19937_64 e{std::random_device{}()};
+        key_hash = e();
+      }
+      auto iter = std::lower_bound(
+          ring.begin(), ring.end(), *key_hash,
+          [](const std::pair<uint64_t, std::size_t>& node, uint64_t hash) {
+            return node.first < hash;
+          });
+      if (iter == ring.end()) {
+        iter = ring.begin();
+      }
+      co_return channel.client_pools_[iter->second];
+    }
+  };
   channel() = default;
 
  public:
@@ -75,28 +157,27 @@ class channel {
   channel(const channel& o) = delete;
   channel& operator=(const channel& o) = delete;
 
-  auto send_request(auto op, typename client_t::config& config)
-      -> decltype(std::declval<client_pool_t>().send_request(std::move(op),
-                                                             std::string_view{},
-                                                             config)) {
-    std::shared_ptr<client_pool_t> client_pool;
-    if (client_pools_.size() > 1) {
-      client_pool = co_await std::visit(
-          [this](auto& worker) {
-            return worker(*this);
-          },
-          lb_worker);
-    }
-    else {
-      client_pool = client_pools_[0];
-    }
-    co_return co_await client_pool->send_request(
-        std::move(op), client_pool->get_host_name(), config);
+  auto send_request(auto op, typename client_t::config& config) {
+    return send_request_impl(std::move(op), std::nullopt, config);
   }
   auto send_request(auto op) {
     return send_request(std::move(op), config_.pool_config.client_config);
   }
 
+  /*!
+   * Send a request with a key, the requests with the same key are sent to the
+   * same host if the load balance algorithm is consistent_hash. The other
+   * algorithms ignore the key.
+   */
+  auto send_request(auto op, std::string_view key,
+                    typename client_t::config& config) {
+    return send_request_impl(std::move(op), detail::hash_key(key), config);
+  }
+  auto send_request(auto op, std::string_view key) {
+    return send_request(std::move(op), key,
+                        config_.pool_config.client_config);
+  }
+
   static channel create(const std::vector<std::string_view>& hosts,
                         const channel_config& config = {},
                         client_pools_t& client_pools =
@@ -107,6 +188,37 @@ class channel {
   }
 
  private:
+  auto send_request_impl(auto op, std::optional<uint64_t> key_hash,
+                         typename client_t::config& config)
+      -> decltype(std::declval<client_pool_t>().send_request(std::move(op),
+                                                             std::string_view{},
+                                                             config)) {
+    std::shared_ptr<client_pool_t> client_pool;
+    bool is_probe = false;
+    if (client_pools_.size() > 1) {
+      // skip the ejected hosts, if all of them are ejected, use the last one
+      // chosen by the load balancer.
+      for (std::size_t i = 0; i < client_pools_.size(); ++i) {
+        client_pool = co_await std::visit(
+            [this, key_hash](auto& worker) {
+              return worker(*this, key_hash);
+            },
+            lb_worker);
+        if (client_pool->try_select(is_probe)) {
+          break;
+        }
+        if (key_hash) {
+          key_hash = detail::mix_hash(*key_hash);
+        }
+      }
+    }
+    else {
+      client_pool = client_pools_[0];
+    }
+    co_return co_await client_pool->send_request(
+        std::move(op), client_pool->get_host_name(), config, is_probe);
+  }
+
   void init(const std::vector<std::string_view>& hosts,
             const channel_config& config, client_pools_t& client_pools) {
     config_ = config;
@@ -118,6 +230,12 @@ class channel {
       case load_blance_algorithm::RR:
         lb_worker = RRLoadBlancer{};
         break;
+      case load_blance_algorithm::least_loaded:
+        lb_worker = LeastLoadedBlancer{};
+        break;
+      case load_blance_algorithm::consistent_hash:
+        lb_worker = ConsistentHashLoadBlancer{client_pools_};
+        break;
       case load_blance_algorithm::random:
       default:
         lb_worker = RandomLoadBlancer{};
@@ -125,7 +243,9 @@ class channel {
     return;
   }
   channel_config config_;
-  std::variant<RRLoadBlancer, RandomLoadBlancer> lb_worker;
+  std::variant<RRLoadBlancer, RandomLoadBlancer, LeastLoadedBlancer,
+               ConsistentHashLoadBlancer>
+      lb_worker;
   std::vector<std::shared_ptr<client_pool_t>> client_pools_;
 };
 
@@ -23,6 +23,8 @@
 #include <async_simple/coro/Sleep.h>
 #include <async_simple/coro/SpinLock.h>
 
+#include <algorithm>
+#include <array>
 #include <asio/io_context.hpp>
 #include <asio/steady_timer.hpp>
 #include <atomic>
@@ -370,6 +372,16 @@ class client_pool : public std::enable_shared_from_this<
     std::chrono::milliseconds idle_timeout{30000};
     std::chrono::milliseconds short_connect_idle_timeout{1000};
     std::chrono::milliseconds max_connection_time{60000};
+    // passive health checking: the pool is ejected from the load balancer of
+    // coro_io::channel when a limit is exceeded (0 disables a limit), and
+    // re-admitted after a successful probe request once the ejection time,
+    // which doubles on every failed probe, has passed. All the limits are
+    // disabled by default.
+    uint32_t max_consecutive_failures = 0;
+    double max_error_rate = 0;
+    std::chrono::milliseconds max_p99_latency{0};
+    std::chrono::milliseconds base_ejection_time{1000};
+    std::chrono::milliseconds max_ejection_time{30000};
     typename client_t::config client_config;
   };
 
@@ -406,6 +418,7 @@ class client_pool : public std::enable_shared_from_this<
       T op, typename client_t::config& client_config) {
     // return type: Lazy<expected<T::returnType,std::errc>>
     ELOG_TRACE << "try send request to " << host_name_;
+    request_tracker tracker(this);
     auto client = co_await get_client(client_config);
     if (!client) {
       ELOG_WARN << "send request to " << host_name_
@@ -414,11 +427,13 @@ class client_pool : public std::enable_shared_from_this<
     }
     if constexpr (std::is_same_v<typename return_type<T>::value_type, void>) {
       co_await op(*client);
+      tracker.failed_ = client->has_closed();
       collect_free_client(std::move(client));
       co_return return_type<T>{};
     }
     else {
       auto ret = co_await op(*client);
+      tracker.failed_ = client->has_closed() || is_call_error(ret);
       collect_free_client(std::move(client));
       co_return std::move(ret);
     }
@@ -435,7 +450,245 @@ class client_pool : public std::enable_shared_from_this<
 
   std::string_view get_host_name() const noexcept { return host_name_; }
 
+  /*!
+   * The number of requests which are being sent by this pool.
+   */
+  uint32_t in_flight_count() const noexcept {
+    return in_flight_.load(std::memory_order_relaxed);
+  }
+
+  /*!
+   * The EWMA of the latency of recent requests. It halves every
+   * `latency_decay_window` without a finished request, so that a host which
+   * was slow will be tried again by the load balancer.
+   */
+  std::chrono::nanoseconds latency() const noexcept {
+    auto latency = ewma_latency_ns_.load(std::memory_order_relaxed);
+    auto idle_time = std::chrono::steady_clock::now().time_since_epoch() -
+                     std::chrono::nanoseconds{latency_update_time_ns_.load(
+                         std::memory_order_relaxed)};
+    auto halves = static_cast<int64_t>(idle_time / latency_decay_window);
+    if (halves >= 63) {
+      return std::chrono::nanoseconds{0};
+    }
+    return std::chrono::nanoseconds{latency >> (std::max)(halves, int64_t{0})};
+  }
+
+  static constexpr std::chrono::seconds latency_decay_window{1};
+
+  /*!
+   * Whether the pool is ejected by the passive health checking.
+   */
+  bool is_ejected() const noexcept {
+    return ejected_until_ns_.load(std::memory_order_relaxed) != 0;
+  }
+
+  uint32_t consecutive_failures() const noexcept {
+    return consecutive_failures_.load(std::memory_order_relaxed);
+  }
+
+  /*!
+   * The EWMA of the failure ratio of recent requests, in [0, 1].
+   */
+  double error_rate() const noexcept {
+    return double(error_rate_.load(std::memory_order_relaxed)) /
+           error_rate_one;
+  }
+
+  /*!
+   * The latency percentile of the recent (at most latency_sample_count)
+   * requests, 0 if there is no request yet.
+   */
+  std::chrono::microseconds latency_percentile(double p) const {
+    auto cnt = (std::min)(sample_cnt_.load(std::memory_order_relaxed),
+                          latency_sample_count);
+    if (cnt == 0) {
+      return std::chrono::microseconds{0};
+    }
+    std::array<uint32_t, latency_sample_count> samples;
+    for (std::size_t i = 0; i < cnt; ++i) {
+      samples[i] = latency_samples_[i].load(std::memory_order_relaxed);
+    }
+    auto nth = samples.begin() + (std::min)(std::size_t(cnt * p), cnt - 1);
+    std::nth_element(samples.begin(), nth, samples.begin() + cnt);
+    return std::chrono::microseconds{*nth};
+  }
+
+  static constexpr std::size_t latency_sample_count = 128;
+
  private:
+  struct request_tracker {
+    request_tracker(client_pool* self, bool is_probe = false)
+        : self_(self),
+          start_(std::chrono::steady_clock::now()),
+          is_probe_(is_probe) {
+      self_->in_flight_.fetch_add(1, std::memory_order_relaxed);
+    }
+    ~request_tracker() {
+      self_->in_flight_.fetch_sub(1, std::memory_order_relaxed);
+      self_->record_result(std::chrono::steady_clock::now() - start_, failed_,
+                           is_probe_);
+    }
+    client_pool* self_;
+    std::chrono::steady_clock::time_point start_;
+    // the request failed if there was no client, the client was closed or
+    // the call failed in the transport, see is_call_error.
+    bool failed_ = true;
+    // the probe of an ejected pool, see try_select.
+    bool is_probe_;
+  };
+
+  // the client tells whether the result of `op` is a failed call, e.g. a
+  // timeout. The results it doesn't know, and the errors returned by the
+  // server, don't count.
+  template <typename R>
+  static bool is_call_error(const R& ret) {
+    if constexpr (requires { client_t::is_call_error(ret); }) {
+      return client_t::is_call_error(ret);
+    }
+    else {
+      return false;
+    }
+  }
+
+  static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void record_result(std::chrono::steady_clock::duration cost, bool failed,
+                     bool is_probe) {
+    update_latency(cost);
+
+    auto cnt = sample_cnt_.fetch_add(1, std::memory_order_relaxed) + 1;
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(cost);
+    latency_samples_[(cnt - 1) % latency_sample_count].store(
+        static_cast<uint32_t>((std::min)(us.count(), int64_t{UINT32_MAX})),
+        std::memory_order_relaxed);
+
+    constexpr uint32_t error_weight = 16;
+    uint32_t old = error_rate_.load(std::memory_order_relaxed), val;
+    do {
+      val = old - old / error_weight + (failed ? error_rate_one / error_weight
+                                                : 0);
+    } while (!error_rate_.compare_exchange_weak(old, val,
+                                                std::memory_order_relaxed));
+    if (failed) {
+      consecutive_failures_.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+      consecutive_failures_.store(0, std::memory_order_relaxed);
+    }
+
+    if (is_ejected()) {
+      // only the probe decides, the requests sent before the ejection don't.
+      if (is_probe) {
+        if (failed) {
+          eject();
+        }
+        else {
+          readmit();
+        }
+        probing_.store(false, std::memory_order_relaxed);
+      }
+      return;
+    }
+
+    if (is_unhealthy(cnt)) {
+      eject();
+    }
+  }
+
+  bool is_unhealthy(std::size_t cnt) const {
+    // don't judge the error rate and latency by a few requests.
+    constexpr std::size_t min_samples = 16;
+    if (pool_config_.max_consecutive_failures != 0 &&
+        consecutive_failures() >= pool_config_.max_consecutive_failures) {
+      return true;
+    }
+    if (cnt < min_samples) {
+      return false;
+    }
+    if (pool_config_.max_error_rate > 0 &&
+        error_rate() > pool_config_.max_error_rate) {
+      return true;
+    }
+    // computing the percentile costs more, so check it every min_samples.
+    if (pool_config_.max_p99_latency.count() > 0 && cnt % min_samples == 0 &&
+        latency_percentile(0.99) > pool_config_.max_p99_latency) {
+      return true;
+    }
+    return false;
+  }
+
+  // eject the pool, or extend the ejection after a failed probe.
+  void eject() {
+    auto cnt = ejection_cnt_.load(std::memory_order_relaxed);
+    auto ejection_time = pool_config_.base_ejection_time *
+                         (int64_t{1} << (std::min)(cnt, uint32_t{16}));
+    ejection_time = (std::min)(ejection_time, pool_config_.max_ejection_time);
+    auto ejected_until =
+        now_ns() +
+        std::chrono::duration_cast<std::chrono::nanoseconds>(ejection_time)
+            .count();
+    auto old = ejected_until_ns_.load(std::memory_order_relaxed);
+    // the pool may have been ejected by another request concurrently.
+    if (old != 0 && now_ns() < old) {
+      return;
+    }
+    if (!ejected_until_ns_.compare_exchange_strong(old, ejected_until)) {
+      return;
+    }
+    ejection_cnt_.fetch_add(1, std::memory_order_relaxed);
+    ELOG_WARN << "client pool of {" << host_name_ << "} is ejected for "
+              << ejection_time.count() << "ms, consecutive failures "
+              << consecutive_failures() << ", error rate " << error_rate();
+  }
+
+  void readmit() {
+    ELOG_INFO << "client pool of {" << host_name_ << "} is re-admitted";
+    consecutive_failures_.store(0, std::memory_order_relaxed);
+    error_rate_.store(0, std::memory_order_relaxed);
+    sample_cnt_.store(0, std::memory_order_relaxed);
+    ejection_cnt_.store(0, std::memory_order_relaxed);
+    ejected_until_ns_.store(0, std::memory_order_relaxed);
+  }
+
+  // used by the channel to skip the ejected pools. When the ejection time has
+  // passed, only one request is let through as the probe, and `is_probe` is
+  // set for it.
+  bool try_select(bool& is_probe) {
+    is_probe = false;
+    auto ejected_until = ejected_until_ns_.load(std::memory_order_relaxed);
+    if (ejected_until == 0) {
+      return true;
+    }
+    if (now_ns() < ejected_until) {
+      return false;
+    }
+    bool expected = false;
+    is_probe = probing_.compare_exchange_strong(expected, true);
+    return is_probe;
+  }
+
+  void update_latency(std::chrono::steady_clock::duration cost) {
+    constexpr int64_t ewma_weight = 8;
+    int64_t sample =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(cost).count();
+    int64_t old = ewma_latency_ns_.load(std::memory_order_relaxed);
+    int64_t val;
+    do {
+      val = old == 0 ? sample : old + (sample - old) / ewma_weight;
+    } while (!ewma_latency_ns_.compare_exchange_weak(
+        old, val, std::memory_order_relaxed));
+    latency_update_time_ns_.store(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count(),
+        std::memory_order_relaxed);
+  }
+
   template <typename, typename>
   friend class client_pools;
 
@@ -445,9 +698,10 @@ class client_pool : public std::enable_shared_from_this<
   template <typename T>
   async_simple::coro::Lazy<return_type_with_host<T>> send_request(
       T op, std::string_view endpoint,
-      typename client_t::config& client_config) {
+      typename client_t::config& client_config, bool is_probe = false) {
     // return type: Lazy<expected<T::returnType,std::errc>>
     ELOG_TRACE << "try send request to " << endpoint;
+    request_tracker tracker(this, is_probe);
     auto client = co_await get_client(client_config);
     if (!client) {
       ELOG_WARN << "send request to " << endpoint
@@ -458,11 +712,13 @@ class client_pool : public std::enable_shared_from_this<
     if constexpr (std::is_same_v<typename return_type_with_host<T>::value_type,
                                  void>) {
       co_await op(*client, endpoint);
+      tracker.failed_ = client->has_closed();
       collect_free_client(std::move(client));
       co_return return_type_with_host<T>{};
     }
     else {
       auto ret = co_await op(*client, endpoint);
+      tracker.failed_ = client->has_closed() || is_call_error(ret);
       collect_free_client(std::move(client));
       co_return std::move(ret);
     }
@@ -483,6 +739,18 @@ class client_pool : public std::enable_shared_from_this<
   std::string host_name_;
   pool_config pool_config_;
   io_context_pool_t& io_context_pool_;
+  std::atomic<uint32_t> in_flight_ = 0;
+  std::atomic<int64_t> ewma_latency_ns_ = 0;
+  std::atomic<int64_t> latency_update_time_ns_ = 0;
+  static constexpr uint32_t error_rate_one = 1 << 16;
+  std::atomic<uint32_t> error_rate_ = 0;
+  std::atomic<uint32_t> consecutive_failures_ = 0;
+  std::atomic<std::size_t> sample_cnt_ = 0;
+  std::array<std::atomic<uint32_t>, latency_sample_count> latency_samples_{};
+  // 0 if the pool is healthy, otherwise the end of the ejection.
+  std::atomic<int64_t> ejected_until_ns_ = 0;
+  std::atomic<uint32_t> ejection_cnt_ = 0;
+  std::atomic<bool> probing_ = false;
 };
 
 template <typename client_t,
@@ -391,4 +391,80 @@ inline std::error_code connect(executor_t &executor,
   return error;
 }
 
+/*!
+ * Enable SO_REUSEPORT on an acceptor before bind.
+ *
+ * The kernel balances the incoming connections between all the acceptors
+ * bound to the same port, so every io thread can accept by itself.
+ *
+ * @return false if the platform doesn't balance by SO_REUSEPORT
+ */
+inline bool set_reuse_port(asio::ip::tcp::acceptor &acceptor) {
+#if defined(__linux__) && defined(SO_REUSEPORT)
+  asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> option(true);
+  std::error_code error;
+  acceptor.set_option(option, error);
+  return !error;
+#else
+  return false;
+#endif
+}
+
+/*!
+ * Get the cpu which handles the incoming packets of the socket.
+ *
+ * @return -1 if unknown
+ */
+inline int get_incoming_cpu(asio::ip::tcp::socket &socket) {
+#ifdef SO_INCOMING_CPU
+  asio::detail::socket_option::integer<SOL_SOCKET, SO_INCOMING_CPU> option;
+  std::error_code error;
+  socket.get_option(option, error);
+  if (!error) {
+    return option.value();
+  }
+#endif
+  return -1;
+}
+
+/*!
+ * Move an accepted socket to a thread on the NUMA node where its packets
+ * arrive.
+ *
+ * @return the executor which the socket belongs to now
+ */
+template <typename Pool>
+inline coro_io::ExecutorWrapper<> *steer_to_numa_node(
+    Pool &pool, asio::ip::tcp::socket &socket,
+    coro_io::ExecutorWrapper<> *executor) {
+  auto cpu = get_incoming_cpu(socket);
+  auto node = pool.get_numa_node(cpu);
+  // only pick another executor if the socket is not on its node yet.
+  if (node < 0 || pool.get_numa_node(executor) == node) {
+    return executor;
+  }
+  auto local_executor = pool.get_executor_by_cpu(cpu);
+  if (local_executor == executor ||
+      &local_executor->context() == &executor->context()) {
+    return executor;
+  }
+  std::error_code error;
+  auto protocol = socket.local_endpoint(error).protocol();
+  if (error) {
+    return executor;
+  }
+  auto fd = socket.release(error);
+  if (error) {
+    return executor;
+  }
+  asio::ip::tcp::socket local_socket(local_executor->get_asio_executor());
+  local_socket.assign(protocol, fd, error);
+  if (error) {
+    socket.assign(protocol, fd, error);
+    return executor;
+  }
+  socket = std::move(local_socket);
+  return local_executor;
+}
+
 }  // namespace coro_io
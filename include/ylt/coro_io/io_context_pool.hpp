@@ -21,13 +21,23 @@
 #include <asio/post.hpp>
 #include <asio/steady_timer.hpp>
 #include <atomic>
+#include <cctype>
+#include <deque>
+#include <filesystem>
+#include <fstream>
 #include <future>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <string_view>
 #include <thread>
 #include <type_traits>
 #include <vector>
 #include <ylt/easylog.hpp>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 namespace coro_io {
 
@@ -97,6 +107,92 @@ class ExecutorWrapper : public async_simple::Executor {
   }
 };
 
+/*!
+ * Placement of the threads of an executor pool
+ */
+struct thread_affinity_config {
+  // The i-th thread is pinned to `cpus[i % cpus.size()]`, a core or a core
+  // list. Empty means no pinning.
+  std::vector<std::vector<int>> cpus;
+  // Group the threads by NUMA node. If `cpus` is empty, the threads are pinned
+  // to the nodes round-robin. The servers steer an accepted connection to the
+  // threads on the node where its packets arrive.
+  bool numa_aware = false;
+};
+
+namespace detail {
+// parse the cpu list format of linux, e.g. "0-3,8,10-11"
+inline std::vector<int> parse_cpu_list(std::string_view str) {
+  std::vector<int> cpus;
+  while (!str.empty()) {
+    auto pos = str.find(',');
+    auto item = str.substr(0, pos);
+    str = pos == std::string_view::npos ? std::string_view{}
+                                        : str.substr(pos + 1);
+    while (!item.empty() && std::isspace((unsigned char)item.back())) {
+      item.remove_suffix(1);
+    }
+    if (item.empty()) {
+      continue;
+    }
+    auto dash = item.find('-');
+    try {
+      int first = std::stoi(std::string{item.substr(0, dash)});
+      int last = dash == std::string_view::npos
+                     ? first
+                     : std::stoi(std::string{item.substr(dash + 1)});
+      for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    } catch (...) {
+      ELOGV(WARN, "bad cpu list: %s", std::string{item}.data());
+    }
+  }
+  return cpus;
+}
+
+// the cpus of each NUMA node, indexed by node id. Empty if unknown.
+inline std::vector<std::vector<int>> get_numa_nodes() {
+  std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+  std::error_code ec;
+  std::filesystem::directory_iterator it("/sys/devices/system/node", ec);
+  for (; !ec && it != std::filesystem::directory_iterator{};
+       it.increment(ec)) {
+    auto name = it->path().filename().string();
+    if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+        name.find_first_not_of("0123456789", 4) != std::string::npos) {
+      continue;
+    }
+    std::size_t id = std::stoul(name.substr(4));
+    std::ifstream file(it->path() / "cpulist");
+    std::string cpu_list;
+    std::getline(file, cpu_list);
+    if (nodes.size() <= id) {
+      nodes.resize(id + 1);
+    }
+    nodes[id] = parse_cpu_list(cpu_list);
+  }
+#endif
+  return nodes;
+}
+
+inline bool pin_current_thread(const std::vector<int> &cpus) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+}  // namespace detail
+
 template <typename ExecutorImpl = asio::io_context>
 inline async_simple::coro::Lazy<typename ExecutorImpl::executor_type>
 get_current_executor() {
@@ -125,6 +221,58 @@ class io_context_pool {
     }
   }
 
+  io_context_pool(std::size_t pool_size,
+                  const thread_affinity_config &affinity)
+      : io_context_pool(pool_size) {
+    set_thread_affinity(affinity);
+  }
+
+  /*!
+   * Set where the threads run, it takes effect when the pool runs.
+   */
+  void set_thread_affinity(const thread_affinity_config &affinity) {
+    auto size = io_contexts_.size();
+    thread_cpus_.assign(size, {});
+    node_threads_.clear();
+    cpu_nodes_.clear();
+    std::vector<std::vector<int>> nodes;
+    if (affinity.numa_aware) {
+      nodes = detail::get_numa_nodes();
+      std::erase_if(nodes, [](auto &cpus) {
+        return cpus.empty();
+      });
+    }
+    for (std::size_t i = 0; i < size; ++i) {
+      if (!affinity.cpus.empty()) {
+        thread_cpus_[i] = affinity.cpus[i % affinity.cpus.size()];
+      }
+      else if (!nodes.empty()) {
+        thread_cpus_[i] = nodes[i % nodes.size()];
+      }
+    }
+    if (nodes.empty()) {
+      return;
+    }
+    for (std::size_t node = 0; node < nodes.size(); ++node) {
+      for (auto cpu : nodes[node]) {
+        if (cpu >= 0) {
+          if (cpu_nodes_.size() <= (std::size_t)cpu) {
+            cpu_nodes_.resize(cpu + 1, -1);
+          }
+          cpu_nodes_[cpu] = node;
+        }
+      }
+    }
+    node_threads_.resize(nodes.size());
+    for (std::size_t i = 0; i < size; ++i) {
+      if (auto node = get_numa_node(
+              thread_cpus_[i].empty() ? -1 : thread_cpus_[i].front());
+          node >= 0) {
+        node_threads_[node].push_back(i);
+      }
+    }
+  }
+
   void run() {
     bool has_run_or_stop = false;
     bool ok = has_run_or_stop_.compare_exchange_strong(has_run_or_stop, true);
@@ -134,13 +282,20 @@ class io_context_pool {
 
     std::vector<std::shared_ptr<std::thread>> threads;
     for (std::size_t i = 0; i < io_contexts_.size(); ++i) {
+      std::vector<int> cpus;
+      if (i < thread_cpus_.size()) {
+        cpus = thread_cpus_[i];
+      }
       threads.emplace_back(std::make_shared<std::thread>(
-          [](io_context_ptr svr) {
+          [](io_context_ptr svr, std::vector<int> cpus) {
+            if (!cpus.empty() && !detail::pin_current_thread(cpus)) {
+              ELOGV(WARN, "failed to set the cpu affinity of io_context");
+            }
             auto ctx = get_current();
             *ctx = svr.get();
             svr->run();
           },
-          io_contexts_[i]));
+          io_contexts_[i], std::move(cpus)));
     }
 
     for (std::size_t i = 0; i < threads.size(); ++i) {
@@ -185,6 +340,65 @@ class io_context_pool {
     return ret;
   }
 
+  /*!
+   * Get the executor of the `index`-th thread.
+   */
+  coro_io::ExecutorWrapper<> *get_executor(std::size_t index) {
+    return executors[index % io_contexts_.size()].get();
+  }
+
+  /*!
+   * Whether the threads are grouped by NUMA node.
+   */
+  bool numa_aware() const noexcept { return !node_threads_.empty(); }
+
+  /*!
+   * Get the NUMA node of a cpu.
+   *
+   * @return -1 if unknown or the pool is not NUMA aware.
+   */
+  int get_numa_node(int cpu) const noexcept {
+    if (cpu < 0 || (std::size_t)cpu >= cpu_nodes_.size()) {
+      return -1;
+    }
+    return cpu_nodes_[cpu];
+  }
+
+  /*!
+   * Get the NUMA node of the thread which runs `executor`.
+   *
+   * @return -1 if unknown or the pool is not NUMA aware.
+   */
+  int get_numa_node(
+      const coro_io::ExecutorWrapper<> *executor) const noexcept {
+    for (std::size_t i = 0; i < thread_cpus_.size(); ++i) {
+      if (executors[i].get() == executor) {
+        if (thread_cpus_[i].empty()) {
+          return -1;
+        }
+        return get_numa_node(thread_cpus_[i].front());
+      }
+    }
+    return -1;
+  }
+
+  /*!
+   * Get the executor of a thread on the same NUMA node as `cpu`, round-robin.
+   *
+   * Fall back to `get_executor()` if the node of `cpu` is unknown or has no
+   * thread.
+   */
+  coro_io::ExecutorWrapper<> *get_executor_by_cpu(int cpu) {
+    if (auto node = get_numa_node(cpu); node >= 0) {
+      auto &threads = node_threads_[node];
+      if (!threads.empty()) {
+        auto i = next_io_context_.fetch_add(1, std::memory_order::relaxed);
+        return executors[threads[i % threads.size()]].get();
+      }
+    }
+    return get_executor();
+  }
+
   template <typename T>
   friend io_context_pool &g_io_context_pool();
 
@@ -199,6 +413,9 @@ class io_context_pool {
   std::promise<void> promise_;
   std::atomic<bool> has_run_or_stop_ = false;
   std::once_flag flag_;
+  std::vector<std::vector<int>> thread_cpus_;
+  std::vector<int> cpu_nodes_;
+  std::vector<std::vector<std::size_t>> node_threads_;
 };
 
 class multithread_context_pool {
@@ -210,9 +427,24 @@ class multithread_context_pool {
 
   ~multithread_context_pool() { stop(); }
 
+  /*!
+   * Set where the threads run, it takes effect when the pool runs. All the
+   * threads share one io_context, so `numa_aware` is ignored.
+   */
+  void set_thread_affinity(const thread_affinity_config &affinity) {
+    cpus_ = affinity.cpus;
+  }
+
   void run() {
     for (std::size_t i = 0; i < thd_num_; i++) {
-      thds_.emplace_back([this] {
+      std::vector<int> cpus;
+      if (!cpus_.empty()) {
+        cpus = cpus_[i % cpus_.size()];
+      }
+      thds_.emplace_back([this, cpus = std::move(cpus)] {
+        if (!cpus.empty() && !detail::pin_current_thread(cpus)) {
+          ELOGV(WARN, "failed to set the cpu affinity of io_context");
+        }
         ioc_.run();
       });
     }
@@ -242,6 +474,267 @@ class multithread_context_pool {
   size_t thd_num_;
   std::vector<std::thread> thds_;
   std::promise<void> promise_;
+  std::vector<std::vector<int>> cpus_;
+};
+
+/*!
+ * A pool of io_context threads which balances the CPU tasks between threads.
+ *
+ * Like io_context_pool, every thread runs its own io_context and
+ * `get_executor()` picks them round-robin, so the IO of a connection always
+ * stays in one thread. Besides, the tasks scheduled to `get_cpu_executor()`
+ * are pushed to the local queue of the current thread, and the idle threads
+ * steal them from the busy ones. A CPU-heavy handler can offload its work by
+ * `co_await work().via(pool.get_cpu_executor())`.
+ *
+ * The local queues are mutex-protected deques, the tasks are expected to be
+ * coarse enough that the lock is not the bottleneck.
+ */
+class work_stealing_context_pool {
+ public:
+  using executor_type = asio::io_context::executor_type;
+
+  class stealing_executor : public async_simple::Executor {
+   public:
+    stealing_executor(work_stealing_context_pool *pool)
+        : async_simple::Executor("work_stealing"), pool_(pool) {}
+
+    bool schedule(Func func) override {
+      pool_->push(std::move(func));
+      return true;
+    }
+
+    bool currentThreadInExecutor() const override {
+      return current_worker().pool == pool_;
+    }
+
+    size_t currentContextId() const override {
+      return currentThreadInExecutor() ? current_worker().index + 1 : 0;
+    }
+
+   private:
+    void schedule(Func func, Duration dur) override {
+      auto &ioc = pool_->local_io_context();
+      auto timer = std::make_unique<asio::steady_timer>(ioc, dur);
+      auto tm = timer.get();
+      tm->async_wait([this, fn = std::move(func),
+                      timer = std::move(timer)](auto) mutable {
+        pool_->push(std::move(fn));
+      });
+    }
+
+    work_stealing_context_pool *pool_;
+  };
+
+  explicit work_stealing_context_pool(std::size_t pool_size)
+      : cpu_executor_(this) {
+    if (pool_size == 0) {
+      pool_size = 1;  // set default value as 1
+    }
+
+    easylog::logger<>::instance();
+    for (std::size_t i = 0; i < pool_size; ++i) {
+      auto w = std::make_unique<worker>();
+      w->io_context = std::make_unique<asio::io_context>(1);
+      w->work = std::make_unique<asio::io_context::work>(*w->io_context);
+      w->executor = std::make_unique<coro_io::ExecutorWrapper<>>(
+          w->io_context->get_executor());
+      workers_.push_back(std::move(w));
+    }
+  }
+
+  void run() {
+    bool has_run_or_stop = false;
+    bool ok = has_run_or_stop_.compare_exchange_strong(has_run_or_stop, true);
+    if (!ok) {
+      return;
+    }
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+      threads.emplace_back([this, i] {
+        worker_loop(i);
+      });
+    }
+
+    for (auto &thd : threads) {
+      thd.join();
+    }
+    promise_.set_value();
+  }
+
+  void stop() {
+    std::call_once(flag_, [this] {
+      bool has_run_or_stop = false;
+      bool ok = has_run_or_stop_.compare_exchange_strong(has_run_or_stop, true);
+
+      stop_ = true;
+      for (auto &w : workers_) {
+        w->work.reset();
+        asio::post(*w->io_context, [] {
+        });
+      }
+
+      if (ok) {
+        // clear all unfinished work
+        for (std::size_t i = 0; i < workers_.size(); ++i) {
+          worker_loop(i);
+        }
+        return;
+      }
+
+      promise_.get_future().wait();
+    });
+  }
+
+  ~work_stealing_context_pool() {
+    if (!has_stop())
+      stop();
+  }
+
+  std::size_t pool_size() const noexcept { return workers_.size(); }
+
+  bool has_stop() const { return stop_; }
+
+  /*!
+   * Get the IO executor of one thread, round-robin.
+   */
+  coro_io::ExecutorWrapper<> *get_executor() {
+    auto i = next_io_context_.fetch_add(1, std::memory_order::relaxed);
+    return workers_[i % workers_.size()]->executor.get();
+  }
+
+  /*!
+   * Get the IO executor of the `index`-th thread.
+   */
+  coro_io::ExecutorWrapper<> *get_executor(std::size_t index) {
+    return workers_[index % workers_.size()]->executor.get();
+  }
+
+  /*!
+   * Get the executor whose tasks may be stolen by any thread of the pool.
+   */
+  async_simple::Executor *get_cpu_executor() { return &cpu_executor_; }
+
+  /*!
+   * The number of the tasks run by a thread other than the one they were
+   * scheduled to.
+   */
+  std::size_t steal_count() const noexcept { return steal_cnt_; }
+
+ private:
+  struct worker {
+    std::unique_ptr<asio::io_context> io_context;
+    std::unique_ptr<asio::io_context::work> work;
+    std::unique_ptr<coro_io::ExecutorWrapper<>> executor;
+    std::mutex mtx;
+    std::deque<async_simple::Executor::Func> tasks;
+    std::atomic<bool> idle = false;
+  };
+
+  struct worker_info {
+    work_stealing_context_pool *pool = nullptr;
+    std::size_t index = 0;
+  };
+
+  static worker_info &current_worker() {
+    static thread_local worker_info info;
+    return info;
+  }
+
+  asio::io_context &local_io_context() {
+    auto &info = current_worker();
+    if (info.pool == this) {
+      return *workers_[info.index]->io_context;
+    }
+    return get_executor()->context();
+  }
+
+  void push(async_simple::Executor::Func func) {
+    auto &info = current_worker();
+    std::size_t index = info.index;
+    if (info.pool != this) {
+      index = next_io_context_.fetch_add(1, std::memory_order::relaxed) %
+              workers_.size();
+    }
+    {
+      auto &w = *workers_[index];
+      std::lock_guard lock(w.mtx);
+      w.tasks.push_back(std::move(func));
+    }
+    // wake up one idle thread, which will run or steal the task.
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+      auto &w = *workers_[(index + i) % workers_.size()];
+      if (w.idle.exchange(false)) {
+        asio::post(*w.io_context, [] {
+        });
+        break;
+      }
+    }
+  }
+
+  async_simple::Executor::Func pop(std::size_t index) {
+    async_simple::Executor::Func func;
+    {
+      auto &w = *workers_[index];
+      std::lock_guard lock(w.mtx);
+      if (!w.tasks.empty()) {
+        func = std::move(w.tasks.front());
+        w.tasks.pop_front();
+        return func;
+      }
+    }
+    for (std::size_t i = 1; i < workers_.size(); ++i) {
+      auto &w = *workers_[(index + i) % workers_.size()];
+      std::lock_guard lock(w.mtx);
+      if (!w.tasks.empty()) {
+        func = std::move(w.tasks.front());
+        w.tasks.pop_front();
+        steal_cnt_.fetch_add(1, std::memory_order::relaxed);
+        return func;
+      }
+    }
+    return func;
+  }
+
+  void worker_loop(std::size_t index) {
+    auto &w = *workers_[index];
+    *get_current() = w.io_context.get();
+    current_worker() = {this, index};
+    while (!stop_) {
+      // the IO handlers are polled between the CPU tasks, so the connections
+      // of this thread are not starved by a long queue.
+      w.io_context->poll();
+      if (auto func = pop(index)) {
+        func();
+        continue;
+      }
+      w.idle = true;
+      // check again, a task may be pushed before the flag is set.
+      if (auto func = pop(index)) {
+        w.idle = false;
+        func();
+        continue;
+      }
+      w.io_context->run_one();
+      w.idle = false;
+    }
+    w.io_context->run();
+    while (auto func = pop(index)) {
+      func();
+    }
+    current_worker() = {};
+    *get_current() = nullptr;
+  }
+
+  std::vector<std::unique_ptr<worker>> workers_;
+  stealing_executor cpu_executor_;
+  std::atomic<std::size_t> next_io_context_ = 0;
+  std::atomic<std::size_t> steal_cnt_ = 0;
+  std::atomic<bool> stop_ = false;
+  std::promise<void> promise_;
+  std::atomic<bool> has_run_or_stop_ = false;
+  std::once_flag flag_;
 };
 
 template <typename T = io_context_pool>
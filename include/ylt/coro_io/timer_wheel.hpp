@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <algorithm>
+#include <array>
+#include <asio/dispatch.hpp>
+#include <asio/error.hpp>
+#include <asio/io_context.hpp>
+#include <asio/steady_timer.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace coro_io {
+
+/*!
+ * A hierarchical timing wheel bound to an io_context.
+ *
+ * Every io_context owns at most one wheel (it is an asio service, see
+ * `timer_wheel::get`), driven by a single steady_timer which only ticks while
+ * there are pending timeouts. Arming and cancelling a timeout are O(1), which
+ * makes the wheel suitable for the coarse-grained keep-alive and call
+ * timeouts that are re-armed on every request, where a per-connection
+ * steady_timer would churn the timer heap of the io_context.
+ *
+ * A timeout never fires before it expires, and fires at most one tick late.
+ * `add` and `cancel` may be called from any thread; callbacks are invoked in
+ * the io_context thread with an empty error code. Like the handlers of a
+ * steady_timer, the timeouts still pending when the io_context is destroyed
+ * are invoked with `asio::error::operation_aborted` instead.
+ */
+class timer_wheel : public asio::execution_context::service {
+ public:
+  using clock_type = std::chrono::steady_clock;
+  using duration = clock_type::duration;
+  using callback_type = std::function<void(const std::error_code &)>;
+  static constexpr uint32_t npos = UINT32_MAX;
+  static constexpr std::chrono::milliseconds default_tick{10};
+
+  struct timer_id {
+    uint32_t index = npos;
+    uint32_t generation = 0;
+  };
+
+  inline static asio::execution_context::id id;
+
+  explicit timer_wheel(asio::execution_context &ctx)
+      : asio::execution_context::service(ctx),
+        timer_(static_cast<asio::io_context &>(ctx)) {
+    for (auto &level : slots_) {
+      level.fill(npos);
+    }
+  }
+
+  static timer_wheel &get(asio::io_context &ctx) {
+    return asio::use_service<timer_wheel>(
+        static_cast<asio::execution_context &>(ctx));
+  }
+
+  template <typename Executor>
+  static timer_wheel &get(const Executor &executor) {
+    return get(executor.context());
+  }
+
+  /*!
+   * Arm a timeout, the callback is invoked in the io_context thread once
+   * `timeout` has elapsed, unless it is cancelled before.
+   */
+  template <typename Rep, typename Period>
+  timer_id add(std::chrono::duration<Rep, Period> timeout,
+               callback_type callback) {
+    auto now = clock_type::now();
+    bool start_ticking = false;
+    timer_id tid;
+    {
+      std::lock_guard lock(mtx_);
+      if (!ticking_) {
+        // the wheel was idle, let the current tick begin now.
+        base_ = now - tick_ * static_cast<int64_t>(current_tick_);
+        ticking_ = true;
+        start_ticking = true;
+      }
+      auto deadline =
+          now + std::chrono::duration_cast<duration>(timeout) - base_;
+      uint64_t expire_tick = deadline <= duration::zero()
+                                 ? 0
+                                 : (deadline + tick_ - duration{1}) / tick_;
+      expire_tick = (std::max)(expire_tick, current_tick_ + 1);
+
+      tid.index = allocate();
+      auto &n = nodes_[tid.index];
+      n.callback = std::move(callback);
+      n.expire_tick = expire_tick;
+      tid.generation = n.generation;
+      insert(tid.index);
+    }
+    if (start_ticking) {
+      asio::dispatch(timer_.get_executor(), [this] {
+        schedule_tick();
+      });
+    }
+    return tid;
+  }
+
+  /*!
+   * Cancel a timeout.
+   *
+   * @return false if the timeout has already fired (or is firing), or has
+   * been cancelled before.
+   */
+  bool cancel(timer_id tid) {
+    callback_type callback;
+    {
+      std::lock_guard lock(mtx_);
+      if (tid.index >= nodes_.size()) {
+        return false;
+      }
+      auto &n = nodes_[tid.index];
+      if (!n.active || n.generation != tid.generation) {
+        return false;
+      }
+      unlink(tid.index);
+      callback = std::move(n.callback);
+      release(tid.index);
+    }
+    return true;
+  }
+
+  std::size_t size() {
+    std::lock_guard lock(mtx_);
+    return count_;
+  }
+
+  duration tick_duration() const { return tick_; }
+
+ private:
+  static constexpr uint32_t slot_bits = 6;
+  static constexpr uint32_t slot_count = 1 << slot_bits;
+  static constexpr uint32_t slot_mask = slot_count - 1;
+  static constexpr uint32_t level_count = 4;
+  static constexpr uint64_t max_delta =
+      (uint64_t{1} << (slot_bits * level_count)) - 1;
+
+  struct node {
+    callback_type callback;
+    uint64_t expire_tick = 0;
+    uint32_t prev = npos;
+    uint32_t next = npos;
+    uint32_t generation = 0;
+    uint8_t level = 0;
+    uint8_t slot = 0;
+    bool active = false;
+  };
+
+  void shutdown() override {
+    std::vector<callback_type> callbacks;
+    {
+      std::lock_guard lock(mtx_);
+      for (auto &n : nodes_) {
+        if (n.active) {
+          callbacks.push_back(std::move(n.callback));
+        }
+      }
+      nodes_.clear();
+      free_head_ = npos;
+      count_ = 0;
+      for (auto &level : slots_) {
+        level.fill(npos);
+      }
+    }
+    for (auto &callback : callbacks) {
+      callback(asio::error::operation_aborted);
+    }
+  }
+
+  uint32_t allocate() {
+    uint32_t index;
+    if (free_head_ != npos) {
+      index = free_head_;
+      free_head_ = nodes_[index].next;
+    }
+    else {
+      index = static_cast<uint32_t>(nodes_.size());
+      nodes_.emplace_back();
+    }
+    nodes_[index].active = true;
+    ++count_;
+    return index;
+  }
+
+  void release(uint32_t index) {
+    auto &n = nodes_[index];
+    n.active = false;
+    ++n.generation;
+    n.prev = npos;
+    n.next = free_head_;
+    free_head_ = index;
+    --count_;
+  }
+
+  // put the node into the slot of the lowest level which can hold it.
+  void insert(uint32_t index) {
+    auto &n = nodes_[index];
+    auto expire_tick = n.expire_tick;
+    uint64_t delta = expire_tick - current_tick_;
+    if (delta > max_delta) {
+      expire_tick = current_tick_ + max_delta;
+      delta = max_delta;
+    }
+    uint32_t level = 0;
+    while (delta >= (uint64_t{1} << (slot_bits * (level + 1)))) {
+      ++level;
+    }
+    uint32_t slot = (expire_tick >> (slot_bits * level)) & slot_mask;
+    n.level = static_cast<uint8_t>(level);
+    n.slot = static_cast<uint8_t>(slot);
+    n.prev = npos;
+    n.next = slots_[level][slot];
+    if (n.next != npos) {
+      nodes_[n.next].prev = index;
+    }
+    slots_[level][slot] = index;
+  }
+
+  void unlink(uint32_t index) {
+    auto &n = nodes_[index];
+    if (n.prev != npos) {
+      nodes_[n.prev].next = n.next;
+    }
+    else {
+      slots_[n.level][n.slot] = n.next;
+    }
+    if (n.next != npos) {
+      nodes_[n.next].prev = n.prev;
+    }
+  }
+
+  // move the timeouts of the current slot of `level` down to lower levels.
+  void cascade(uint32_t level) {
+    uint32_t slot = (current_tick_ >> (slot_bits * level)) & slot_mask;
+    if (slot == 0 && level + 1 < level_count) {
+      cascade(level + 1);
+    }
+    auto index = std::exchange(slots_[level][slot], npos);
+    while (index != npos) {
+      auto next = nodes_[index].next;
+      insert(index);
+      index = next;
+    }
+  }
+
+  void advance(std::vector<callback_type> &expired) {
+    ++current_tick_;
+    uint32_t slot = current_tick_ & slot_mask;
+    if (slot == 0) {
+      cascade(1);
+    }
+    auto index = std::exchange(slots_[0][slot], npos);
+    while (index != npos) {
+      auto next = nodes_[index].next;
+      expired.push_back(std::move(nodes_[index].callback));
+      release(index);
+      index = next;
+    }
+  }
+
+  void schedule_tick() {
+    clock_type::time_point deadline;
+    {
+      std::lock_guard lock(mtx_);
+      deadline = base_ + tick_ * static_cast<int64_t>(current_tick_ + 1);
+    }
+    timer_.expires_at(deadline);
+    timer_.async_wait([this](const asio::error_code &ec) {
+      if (!ec) {
+        on_tick();
+      }
+    });
+  }
+
+  void on_tick() {
+    std::vector<callback_type> expired;
+    bool rearm;
+    {
+      std::lock_guard lock(mtx_);
+      uint64_t target = (clock_type::now() - base_) / tick_;
+      while (current_tick_ < target) {
+        advance(expired);
+      }
+      if (count_ == 0) {
+        ticking_ = false;
+      }
+      rearm = ticking_;
+    }
+    for (auto &callback : expired) {
+      callback({});
+    }
+    if (rearm) {
+      schedule_tick();
+    }
+  }
+
+  std::mutex mtx_;
+  asio::steady_timer timer_;
+  duration tick_ = default_tick;
+  clock_type::time_point base_;
+  uint64_t current_tick_ = 0;
+  bool ticking_ = false;
+  std::size_t count_ = 0;
+  uint32_t free_head_ = npos;
+  std::vector<node> nodes_;
+  std::array<std::array<uint32_t, slot_count>, level_count> slots_;
+};
+
+}  // namespace coro_io
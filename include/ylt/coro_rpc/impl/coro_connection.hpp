@@ -27,9 +27,11 @@
 #include <string_view>
 #include <system_error>
 #include <utility>
+#include <vector>
 #include <ylt/easylog.hpp>
 
 #include "ylt/coro_io/coro_io.hpp"
+#include "ylt/coro_io/timer_wheel.hpp"
 #include "ylt/coro_rpc/impl/errno.h"
 #ifdef UNIT_TEST_INJECT
 #include "inject_action.hpp"
@@ -50,6 +52,9 @@ struct context_info_t {
   };
   std::atomic<bool> has_response_ = false;
   bool is_delay_ = false;
+  // bytes reserved before the rpc result for the response header, 0 if the
+  // protocol doesn't write the header in place.
+  std::size_t resp_head_len_ = 0;
   context_info_t(std::shared_ptr<coro_connection> &&conn)
       : conn_(std::move(conn)) {}
 };
@@ -90,7 +95,8 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
       : executor_(executor),
         socket_(std::move(socket)),
         resp_err_(),
-        timer_(executor->get_asio_executor()) {
+        timer_wheel_(
+            &coro_io::timer_wheel::get(executor->get_asio_executor())) {
     if (timeout_duration == std::chrono::seconds(0)) {
       return;
     }
@@ -148,8 +154,7 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
   template <typename rpc_protocol, typename Socket>
   async_simple::coro::Lazy<void> start_impl(
       typename rpc_protocol::router &router, Socket &socket) noexcept {
-    auto context_info =
-        std::make_shared<context_info_t<rpc_protocol>>(shared_from_this());
+    auto context_info = make_context_info<rpc_protocol>();
     std::string resp_error_msg;
     while (true) {
       auto &req_head = context_info->req_head_;
@@ -230,6 +235,9 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
         case rpc_call_type::callback_with_delay:
           ++delay_resp_cnt;
           rpc_call_type_ = rpc_call_type::non_callback;
+          // the delayed context still refers to the request header, so the
+          // next request (maybe pipelined by client) needs a new one.
+          context_info = make_context_info<rpc_protocol>();
           continue;
         case rpc_call_type::callback_finished:
           continue;
@@ -246,11 +254,24 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
           rpc_call_type_ = rpc_call_type::non_callback;
           continue;
       }
-      resp_error_msg.clear();
-      if (!!resp_err)
-        AS_UNLIKELY { std::swap(resp_buf, resp_error_msg); }
-      std::string header_buf = rpc_protocol::prepare_response(
-          resp_buf, req_head, 0, resp_err, resp_error_msg);
+      std::string header_buf;
+      std::size_t body_offset = 0;
+      if constexpr (has_prepare_response_in_place<rpc_protocol>) {
+        if (!resp_err)
+          AS_LIKELY {
+            // the header is written before the result in the same buffer.
+            resp_err =
+                rpc_protocol::prepare_response_in_place(resp_buf, req_head);
+            body_offset = rpc_protocol::RESP_HEAD_LEN;
+          }
+      }
+      if (body_offset == 0) {
+        resp_error_msg.clear();
+        if (!!resp_err)
+          AS_UNLIKELY { std::swap(resp_buf, resp_error_msg); }
+        header_buf = rpc_protocol::prepare_response(resp_buf, req_head, 0,
+                                                    resp_err, resp_error_msg);
+      }
 
 #ifdef UNIT_TEST_INJECT
       if (g_action == inject_action::close_socket_after_send_length) {
@@ -258,6 +279,9 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
               "inject action: close_socket_after_send_length conn_id %d, "
               "client_id %d",
               conn_id_, client_id_);
+        if (body_offset > 0) {
+          header_buf = resp_buf.substr(0, body_offset);
+        }
         co_await coro_io::async_write(socket, asio::buffer(header_buf));
         close();
         break;
@@ -267,7 +291,7 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
               "inject action: server_send_bad_rpc_result conn_id %d, client_id "
               "%d",
               conn_id_, client_id_);
-        resp_buf[0] = resp_buf[0] + 1;
+        resp_buf[body_offset] = resp_buf[body_offset] + 1;
       }
 #endif
       if (!resp_err_)
@@ -350,6 +374,36 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
 
   void close_coro() {}
 
+  /*!
+   * Statistics of the coalesced response writes
+   *
+   * One write flushes `msg_cnt / write_cnt` responses on average, and at most
+   * `max_batch_size` responses.
+   */
+  struct write_stats {
+    std::atomic<uint64_t> write_cnt = 0;
+    std::atomic<uint64_t> msg_cnt = 0;
+    std::atomic<uint64_t> max_batch_size = 0;
+  };
+
+  /*!
+   * Set the budget of one coalesced write
+   *
+   * All the pending responses are flushed by one scatter/gather write, until
+   * the number of buffers exceeds `max_iovecs` or the bytes exceed
+   * `max_bytes`. At least one response is written each time.
+   *
+   * @param max_iovecs max buffer count of one write
+   * @param max_bytes max bytes of one write
+   * @param stats where to count the writes, nullptr to disable counting
+   */
+  void set_write_batch_limit(std::size_t max_iovecs, std::size_t max_bytes,
+                             std::shared_ptr<write_stats> stats = nullptr) {
+    max_write_iovecs_ = max_iovecs;
+    max_write_bytes_ = max_bytes;
+    write_stats_ = std::move(stats);
+  }
+
   using QuitCallback = std::function<void(const uint64_t &conn_id)>;
   void set_quit_callback(QuitCallback callback, uint64_t conn_id) {
     quit_callback_ = std::move(callback);
@@ -361,7 +415,55 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
 
   auto &get_executor() { return *executor_; }
 
+  /*!
+   * Get a buffer recycled from the sent responses
+   *
+   * It must be called in the executor of the connection.
+   */
+  std::string get_buffer() {
+    if (buffer_pool_.empty()) {
+      return {};
+    }
+    auto buffer = std::move(buffer_pool_.back());
+    buffer_pool_.pop_back();
+    return buffer;
+  }
+
+  /*!
+   * Give back a buffer to be reused by the later responses
+   *
+   * It must be called in the executor of the connection.
+   */
+  void release_buffer(std::string &&buffer) {
+    if (buffer_pool_.size() < max_pooled_buffers &&
+        buffer.capacity() <= max_pooled_buffer_size) {
+      buffer.clear();
+      buffer_pool_.push_back(std::move(buffer));
+    }
+  }
+
  private:
+  template <typename rpc_protocol>
+  static constexpr bool has_prepare_response_in_place =
+      requires(std::string &buffer,
+               const typename rpc_protocol::req_header &req_head) {
+    rpc_protocol::prepare_response_in_place(buffer, req_head);
+    rpc_protocol::RESP_HEAD_LEN;
+  };
+
+  template <typename rpc_protocol>
+  std::shared_ptr<context_info_t<rpc_protocol>> make_context_info() {
+    auto context_info =
+        std::make_shared<context_info_t<rpc_protocol>>(shared_from_this());
+    if constexpr (has_prepare_response_in_place<rpc_protocol>) {
+      context_info->resp_head_len_ = rpc_protocol::RESP_HEAD_LEN;
+    }
+    // the request bodies are read into a recycled buffer too, a new context
+    // is made for each delayed response.
+    context_info->req_body_ = get_buffer();
+    return context_info;
+  }
+
   async_simple::coro::Lazy<void> response(
       std::string header_buf, std::string body_buf,
       std::function<std::string_view()> resp_attachment, rpc_conn self,
@@ -403,7 +505,6 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
   async_simple::coro::Lazy<void> send_data() {
     std::pair<std::error_code, size_t> ret;
     while (!write_queue_.empty()) {
-      auto &msg = write_queue_.front();
 #ifdef UNIT_TEST_INJECT
       if (g_action == inject_action::force_inject_connection_close_socket) {
         ELOGV(
@@ -415,38 +516,42 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
         co_return;
       }
 #endif
-      auto attachment = std::get<2>(msg)();
-      if (attachment.empty()) {
-        std::array<asio::const_buffer, 2> buffers{
-            asio::buffer(std::get<0>(msg)), asio::buffer(std::get<1>(msg))};
-#ifdef YLT_ENABLE_SSL
-        if (use_ssl_) {
-          assert(ssl_stream_);
-          ret = co_await coro_io::async_write(*ssl_stream_, buffers);
+      // Responses queued while the previous write was in flight are flushed
+      // together by one writev.
+      write_buffers_.clear();
+      std::size_t batch_size = 0, batch_bytes = 0;
+      for (auto &msg : write_queue_) {
+        auto attachment = std::get<2>(msg)();
+        auto iov_cnt =
+            1 + !std::get<0>(msg).empty() + !attachment.empty();
+        auto bytes = std::get<0>(msg).size() + std::get<1>(msg).size() +
+                     attachment.size();
+        if (batch_size > 0 &&
+            (write_buffers_.size() + iov_cnt > max_write_iovecs_ ||
+             batch_bytes + bytes > max_write_bytes_)) {
+          break;
         }
-        else {
-#endif
-          ret = co_await coro_io::async_write(socket_, buffers);
-#ifdef YLT_ENABLE_SSL
+        if (!std::get<0>(msg).empty()) {
+          write_buffers_.push_back(asio::buffer(std::get<0>(msg)));
         }
-#endif
+        write_buffers_.push_back(asio::buffer(std::get<1>(msg)));
+        if (!attachment.empty()) {
+          write_buffers_.push_back(asio::buffer(attachment));
+        }
+        ++batch_size;
+        batch_bytes += bytes;
       }
-      else {
-        std::array<asio::const_buffer, 3> buffers{
-            asio::buffer(std::get<0>(msg)), asio::buffer(std::get<1>(msg)),
-            asio::buffer(attachment)};
 #ifdef YLT_ENABLE_SSL
-        if (use_ssl_) {
-          assert(ssl_stream_);
-          ret = co_await coro_io::async_write(*ssl_stream_, buffers);
-        }
-        else {
+      if (use_ssl_) {
+        assert(ssl_stream_);
+        ret = co_await coro_io::async_write(*ssl_stream_, write_buffers_);
+      }
+      else {
 #endif
-          ret = co_await coro_io::async_write(socket_, buffers);
+        ret = co_await coro_io::async_write(socket_, write_buffers_);
 #ifdef YLT_ENABLE_SSL
-        }
-#endif
       }
+#endif
       if (ret.first)
         AS_UNLIKELY {
           ELOGV(ERROR, "%s, %s", ret.first.message().data(),
@@ -454,7 +559,22 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
           close();
           co_return;
         }
-      write_queue_.pop_front();
+      if (write_stats_)
+        AS_UNLIKELY {
+          write_stats_->write_cnt.fetch_add(1, std::memory_order_relaxed);
+          write_stats_->msg_cnt.fetch_add(batch_size,
+                                          std::memory_order_relaxed);
+          auto max_size =
+              write_stats_->max_batch_size.load(std::memory_order_relaxed);
+          while (max_size < batch_size &&
+                 !write_stats_->max_batch_size.compare_exchange_weak(
+                     max_size, batch_size, std::memory_order_relaxed))
+            ;
+        }
+      for (std::size_t i = 0; i < batch_size; ++i) {
+        release_buffer(std::move(std::get<1>(write_queue_.front())));
+        write_queue_.pop_front();
+      }
     }
     if (!!resp_err_)
       AS_UNLIKELY {
@@ -494,19 +614,25 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
       return;
     }
 
-    timer_.expires_from_now(keep_alive_timeout_duration_);
-    timer_.async_wait(
-        [this, self = shared_from_this()](asio::error_code const &ec) {
-          if (!ec) {
+    timer_wheel_->cancel(timer_id_);
+    timer_id_ = timer_wheel_->add(
+        keep_alive_timeout_duration_,
+        [this, weak = weak_from_this()](const std::error_code &ec) {
+          if (ec) {
+            return;
+          }
+          auto self = weak.lock();
+          if (!self) {
+            return;
+          }
 #ifdef UNIT_TEST_INJECT
-            ELOGV(INFO, "close timeout client_id %d conn_id %d", client_id_,
-                  conn_id_);
+          ELOGV(INFO, "close timeout client_id %d conn_id %d", client_id_,
+                conn_id_);
 #else
-            ELOGV(INFO, "close timeout client conn_id %d", conn_id_);
+          ELOGV(INFO, "close timeout client conn_id %d", conn_id_);
 #endif
 
-            close();
-          }
+          close();
         });
   }
 
@@ -515,8 +641,7 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
       return;
     }
 
-    asio::error_code ec;
-    timer_.cancel(ec);
+    timer_wheel_->cancel(timer_id_);
   }
 
   coro_io::callback_awaitor<void>::awaitor_handler callback_awaitor_handler_{
@@ -527,6 +652,14 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
   std::deque<
       std::tuple<std::string, std::string, std::function<std::string_view()>>>
       write_queue_;
+  std::vector<asio::const_buffer> write_buffers_;
+  std::size_t max_write_iovecs_ = 256;
+  std::size_t max_write_bytes_ = 1024 * 1024;
+  std::shared_ptr<write_stats> write_stats_;
+  // the buffers of sent responses, reused by the later responses.
+  std::vector<std::string> buffer_pool_;
+  static constexpr std::size_t max_pooled_buffers = 16;
+  static constexpr std::size_t max_pooled_buffer_size = 64 * 1024;
   coro_rpc::errc resp_err_;
   rpc_call_type rpc_call_type_{non_callback};
 
@@ -534,7 +667,10 @@ class coro_connection : public std::enable_shared_from_this<coro_connection> {
   // will be closed when enable_check_timeout_ is true.
   std::chrono::steady_clock::duration keep_alive_timeout_duration_;
   bool enable_check_timeout_{false};
-  asio::steady_timer timer_;
+  // keep-alive timeouts are re-armed around every read_head, so they live in
+  // the timer wheel of the io_context rather than in a steady_timer each.
+  coro_io::timer_wheel *timer_wheel_;
+  coro_io::timer_wheel::timer_id timer_id_;
   std::atomic<bool> has_closed_{false};
 
   QuitCallback quit_callback_{nullptr};
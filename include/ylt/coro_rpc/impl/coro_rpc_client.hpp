@@ -25,14 +25,17 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <system_error>
 #include <thread>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <ylt/easylog.hpp>
@@ -46,6 +49,7 @@
 #include "protocol/coro_rpc_protocol.hpp"
 #include "ylt/coro_io/coro_io.hpp"
 #include "ylt/coro_io/io_context_pool.hpp"
+#include "ylt/coro_io/timer_wheel.hpp"
 #include "ylt/coro_rpc/impl/errno.h"
 #include "ylt/struct_pack.hpp"
 #include "ylt/struct_pack/util.h"
@@ -117,6 +121,12 @@ class coro_rpc_client {
         std::chrono::milliseconds{5000};
     std::string host;
     std::string port;
+    // If true, concurrent calls share one connection. Every request gets its
+    // own seq_num and responses are dispatched to the callers by seq_num, so
+    // they may arrive out of order. Not supported with ssl. The attachments
+    // of the concurrent calls are passed by call_with_attachment_for, since
+    // set_req_attachment/get_resp_attachment are shared by the client.
+    bool enable_multiplexing = false;
 #ifdef YLT_ENABLE_SSL
     std::filesystem::path ssl_cert_path;
     std::string ssl_domain;
@@ -130,7 +140,10 @@ class coro_rpc_client {
   coro_rpc_client(asio::io_context::executor_type executor,
                   uint32_t client_id = 0)
       : executor(executor),
-        socket_(std::make_shared<asio::ip::tcp::socket>(executor)) {
+        socket_(std::make_shared<asio::ip::tcp::socket>(executor)),
+        multiplexing_(
+            std::make_shared<multiplexing_control>(
+            socket_, this->executor.get_asio_executor())) {
     config_.client_id = client_id;
   }
 
@@ -143,7 +156,10 @@ class coro_rpc_client {
       uint32_t client_id = 0)
       : executor(executor.get_asio_executor()),
         socket_(std::make_shared<asio::ip::tcp::socket>(
-            executor.get_asio_executor())) {
+            executor.get_asio_executor())),
+        multiplexing_(
+            std::make_shared<multiplexing_control>(
+            socket_, this->executor.get_asio_executor())) {
     config_.client_id = client_id;
   }
 
@@ -168,6 +184,20 @@ class coro_rpc_client {
    */
   [[nodiscard]] bool has_closed() { return has_closed_; }
 
+  /*!
+   * Check whether a call failed in the transport, by a timeout, an io error
+   * or a lost connection, rather than by an error of the rpc function.
+   */
+  template <typename T>
+  static bool is_call_error(const rpc_result<T, coro_rpc_protocol> &ret) {
+    if (ret.has_value()) {
+      return false;
+    }
+    auto ec = ret.error().code.ec;
+    return ec == errc::io_error || ec == errc::not_connected ||
+           ec == errc::timed_out;
+  }
+
   /*!
    * Reconnect server
    *
@@ -280,6 +310,89 @@ class coro_rpc_client {
   async_simple::coro::Lazy<
       rpc_result<decltype(get_return_type<func>()), coro_rpc_protocol>>
   call_for(auto duration, Args... args) {
+    return call_for_impl<func>(duration, {}, nullptr, std::move(args)...);
+  }
+
+  /*!
+   * Get inner executor
+   */
+  auto &get_executor() { return executor; }
+
+  uint32_t get_client_id() const { return config_.client_id; }
+
+  void close() {
+    if (has_closed_) {
+      return;
+    }
+    has_closed_ = true;
+    ELOGV(INFO, "client_id %d close", config_.client_id);
+    close_socket(socket_);
+  }
+
+  bool set_req_attachment(std::string_view attachment) {
+    if (attachment.size() > UINT32_MAX) {
+      ELOGV(ERROR, "too large rpc attachment");
+      return false;
+    }
+    req_attachment_ = attachment;
+    return true;
+  }
+
+  std::string_view get_resp_attachment() const { return resp_attachment_buf_; }
+
+  std::string release_resp_attachment() {
+    return std::move(resp_attachment_buf_);
+  }
+
+  /*!
+   * Call RPC function with the attachments of this call. The request
+   * attachment must be alive until the call is finished, and the response
+   * attachment is stored to resp_attachment. Unlike set_req_attachment and
+   * get_resp_attachment, it's safe for the concurrent calls of a multiplexed
+   * client.
+   *
+   * @tparam func the address of RPC function
+   * @param duration RPC call timeout
+   * @param req_attachment the request attachment
+   * @param resp_attachment the response attachment
+   * @param args RPC function arguments
+   * @return RPC call result
+   */
+  template <auto func, typename... Args>
+  async_simple::coro::Lazy<
+      rpc_result<decltype(get_return_type<func>()), coro_rpc_protocol>>
+  call_with_attachment_for(auto duration, std::string_view req_attachment,
+                           std::string &resp_attachment, Args... args) {
+    using R = decltype(get_return_type<func>());
+    if (req_attachment.size() > UINT32_MAX)
+      AS_UNLIKELY {
+        co_return rpc_result<R, coro_rpc_protocol>{
+            unexpect_t{},
+            coro_rpc_protocol::rpc_error{errc::message_too_large,
+                                         "too large rpc attachment"}};
+      }
+    if (!config_.enable_multiplexing) {
+      // one call at a time, the attachments of the client are per call.
+      req_attachment_ = req_attachment;
+      auto ret = co_await call_for<func>(duration, std::move(args)...);
+      resp_attachment = release_resp_attachment();
+      co_return ret;
+    }
+    co_return co_await call_for_impl<func>(
+        duration, req_attachment, &resp_attachment, std::move(args)...);
+  }
+
+  template <typename T, typename U>
+  friend class coro_io::client_pool;
+
+ private:
+  // the attachments are passed to the multiplexed calls, the others use the
+  // attachments of the client.
+  template <auto func, typename... Args>
+  async_simple::coro::Lazy<
+      rpc_result<decltype(get_return_type<func>()), coro_rpc_protocol>>
+  call_for_impl(auto duration, std::string_view req_attachment,
+                std::string *resp_attachment, Args... args) {
     using R = decltype(get_return_type<func>());
 
     if (has_closed_)
@@ -306,11 +419,33 @@ class coro_rpc_client {
 
     static_check<func, Args...>();
 
+    if (config_.enable_multiplexing) {
+#ifdef YLT_ENABLE_SSL
+      if (!config_.ssl_cert_path.empty()) {
+        ret = rpc_result<R, coro_rpc_protocol>{
+            unexpect_t{},
+            coro_rpc_protocol::rpc_error{
+                errc::invalid_argument,
+                "multiplexing is not supported with ssl"}};
+        co_return ret;
+      }
+#endif
+      if (resp_attachment == nullptr && !req_attachment_.empty())
+        AS_UNLIKELY {
+          ret = rpc_result<R, coro_rpc_protocol>{
+              unexpect_t{},
+              coro_rpc_protocol::rpc_error{
+                  errc::invalid_argument,
+                  "use call_with_attachment_for with multiplexing"}};
+          co_return ret;
+        }
+      ret = co_await multiplexing_call_impl<func>(
+          duration, req_attachment, resp_attachment, std::move(args)...);
+      co_return ret;
+    }
+
     async_simple::Promise<async_simple::Unit> promise;
-    coro_io::period_timer timer(&executor);
-    timeout(timer, duration, promise, "rpc call timer canceled")
-        .via(&executor)
-        .detach();
+    auto timer_id = arm_timeout(duration, promise, "rpc call timeout");
 
 #ifdef YLT_ENABLE_SSL
     if (!config_.ssl_cert_path.empty()) {
@@ -324,8 +459,7 @@ class coro_rpc_client {
     }
 #endif
 
-    std::error_code err_code;
-    timer.cancel(err_code);
+    co_await disarm_timeout(timer_id, promise);
 
     if (is_timeout_) {
       ret = rpc_result<R, coro_rpc_protocol>{
@@ -333,7 +467,6 @@ class coro_rpc_client {
           coro_rpc_protocol::rpc_error{errc::timed_out, "rpc call timed out"}};
     }
 
-    co_await promise.getFuture();
 #ifdef UNIT_TEST_INJECT
     ELOGV(INFO, "client_id %d call %s %s", config_.client_id,
           get_func_name<func>().data(), ret ? "ok" : "failed");
@@ -341,41 +474,6 @@ class coro_rpc_client {
     co_return ret;
   }
 
-  /*!
-   * Get inner executor
-   */
-  auto &get_executor() { return executor; }
-
-  uint32_t get_client_id() const { return config_.client_id; }
-
-  void close() {
-    if (has_closed_) {
-      return;
-    }
-    has_closed_ = true;
-    ELOGV(INFO, "client_id %d close", config_.client_id);
-    close_socket(socket_);
-  }
-
-  bool set_req_attachment(std::string_view attachment) {
-    if (attachment.size() > UINT32_MAX) {
-      ELOGV(ERROR, "too large rpc attachment");
-      return false;
-    }
-    req_attachment_ = attachment;
-    return true;
-  }
-
-  std::string_view get_resp_attachment() const { return resp_attachment_buf_; }
-
-  std::string release_resp_attachment() {
-    return std::move(resp_attachment_buf_);
-  }
-
-  template <typename T, typename U>
-  friend class coro_io::client_pool;
-
- private:
   // the const char * will convert to bool instead of std::string_view
   // use this struct to prevent it.
   struct is_reconnect_t {
@@ -386,6 +484,8 @@ class coro_rpc_client {
     close_socket(socket_);
     socket_ =
         std::make_shared<asio::ip::tcp::socket>(executor.get_asio_executor());
+    multiplexing_ = std::make_shared<multiplexing_control>(
+        socket_, executor.get_asio_executor());
     is_timeout_ = false;
     has_closed_ = false;
   }
@@ -411,17 +511,12 @@ class coro_rpc_client {
     ELOGV(INFO, "client_id %d begin to connect %s", config_.client_id,
           config_.port.data());
     async_simple::Promise<async_simple::Unit> promise;
-    coro_io::period_timer timer(&executor);
-    timeout(timer, config_.timeout_duration, promise, "connect timer canceled")
-        .via(&executor)
-        .detach();
+    auto timer_id =
+        arm_timeout(config_.timeout_duration, promise, "connect timeout");
 
     std::error_code ec = co_await coro_io::async_connect(
         &executor, *socket_, config_.host, config_.port);
-    std::error_code err_code;
-    timer.cancel(err_code);
-
-    co_await promise.getFuture();
+    co_await disarm_timeout(timer_id, promise);
     if (ec) {
       if (is_timeout_) {
         co_return errc::timed_out;
@@ -478,25 +573,44 @@ class coro_rpc_client {
     return ssl_init_ret_;
   }
 #endif
-  async_simple::coro::Lazy<bool> timeout(auto &timer, auto duration,
-                                         auto &promise, std::string err_msg) {
-    timer.expires_after(duration);
-    bool is_timeout = co_await timer.async_await();
+  /*!
+   * Arm a timeout on the timer wheel of the client's io_context, the socket is
+   * closed when it expires and `promise` is set after that.
+   */
+  coro_io::timer_wheel::timer_id arm_timeout(
+      auto duration, async_simple::Promise<async_simple::Unit> &promise,
+      std::string_view err_msg) {
+    auto &wheel = coro_io::timer_wheel::get(executor.get_asio_executor());
+    return wheel.add(duration, [this, &promise, duration,
+                                err_msg](const std::error_code &ec) {
+      if (ec) {
+        // the io_context is gone, only let `disarm_timeout` go on.
+        promise.setValue(async_simple::Unit());
+        return;
+      }
 #ifdef UNIT_TEST_INJECT
-    ELOGV(INFO, "client_id %d %s, is_timeout_ %d, %d , duration %d ms",
-          config_.client_id, err_msg.data(), is_timeout_, is_timeout,
-          std::chrono::duration_cast<std::chrono::milliseconds>(duration)
-              .count());
+      ELOGV(INFO, "client_id %d %s, duration %d ms", config_.client_id,
+            err_msg.data(),
+            std::chrono::duration_cast<std::chrono::milliseconds>(duration)
+                .count());
 #endif
-    if (!is_timeout) {
+      is_timeout_ = true;
+      close_socket(socket_);
       promise.setValue(async_simple::Unit());
-      co_return false;
-    }
+    });
+  }
 
-    is_timeout_ = is_timeout;
-    close_socket(socket_);
-    promise.setValue(async_simple::Unit());
-    co_return true;
+  /*!
+   * Cancel the timeout, if it has already fired wait until its callback
+   * finished, so that the promise can be released safely.
+   */
+  async_simple::coro::Lazy<void> disarm_timeout(
+      coro_io::timer_wheel::timer_id timer_id,
+      async_simple::Promise<async_simple::Unit> &promise) {
+    auto &wheel = coro_io::timer_wheel::get(executor.get_asio_executor());
+    if (!wheel.cancel(timer_id)) {
+      co_await promise.getFuture();
+    }
   }
 
   template <auto func, typename... Args>
@@ -692,6 +806,232 @@ class coro_rpc_client {
     close();
     co_return r;
   }
+  struct multiplexing_response {
+    std::error_code ec;
+    coro_rpc_protocol::resp_header header;
+    std::string body;
+    std::string attachment;
+  };
+
+  /*
+   * State shared by all the in-flight calls of a multiplexed connection and
+   * its reader/writer coroutines. It is held by shared_ptr so that the
+   * coroutines can outlive the client.
+   */
+  struct multiplexing_control {
+    multiplexing_control(std::shared_ptr<asio::ip::tcp::socket> socket,
+                         asio::io_context::executor_type executor)
+        : socket_(std::move(socket)), executor_(executor) {}
+
+    // complete the call `seq_num` if it is still waiting.
+    void finish(uint32_t seq_num, multiplexing_response &&resp) {
+      async_simple::Promise<multiplexing_response> promise;
+      {
+        std::lock_guard lock(mtx_);
+        auto iter = pending_.find(seq_num);
+        if (iter == pending_.end()) {
+          return;
+        }
+        promise = std::move(iter->second);
+        pending_.erase(iter);
+      }
+      promise.setValue(std::move(resp));
+    }
+
+    // close the connection and fail all the waiting calls.
+    void close(std::error_code ec) {
+      std::unordered_map<uint32_t, async_simple::Promise<multiplexing_response>>
+          pending;
+      {
+        std::lock_guard lock(mtx_);
+        has_closed_ = true;
+        is_reading_ = false;
+        pending = std::move(pending_);
+        pending_.clear();
+      }
+      asio::dispatch(executor_.get_asio_executor(), [socket = socket_]() {
+        asio::error_code ignored_ec;
+        socket->shutdown(asio::ip::tcp::socket::shutdown_both, ignored_ec);
+        socket->close(ignored_ec);
+      });
+      for (auto &[_, promise] : pending) {
+        promise.setValue(multiplexing_response{
+            .ec = ec, .header = {}, .body = {}, .attachment = {}});
+      }
+    }
+
+    std::shared_ptr<asio::ip::tcp::socket> socket_;
+    coro_io::ExecutorWrapper<> executor_;
+    std::mutex mtx_;
+    std::unordered_map<uint32_t, async_simple::Promise<multiplexing_response>>
+        pending_;
+    std::deque<std::pair<std::vector<std::byte>, std::string_view>>
+        write_queue_;
+    uint32_t seq_num_ = 0;
+    bool is_reading_ = false;
+    bool has_closed_ = false;
+  };
+
+  static async_simple::coro::Lazy<void> multiplexing_send(
+      std::shared_ptr<multiplexing_control> control) {
+    while (true) {
+      std::vector<std::byte> *buffer;
+      std::string_view attachment;
+      {
+        std::lock_guard lock(control->mtx_);
+        auto &msg = control->write_queue_.front();
+        buffer = &msg.first;
+        attachment = msg.second;
+      }
+      std::array<asio::const_buffer, 2> iov{
+          asio::const_buffer{buffer->data(), buffer->size()},
+          asio::const_buffer{attachment.data(), attachment.size()}};
+      auto [ec, _] = co_await coro_io::async_write(*control->socket_, iov);
+      if (ec)
+        AS_UNLIKELY {
+          ELOGV(ERROR, "multiplexing write failed: %s", ec.message().data());
+          control->close(ec);
+          std::lock_guard lock(control->mtx_);
+          control->write_queue_.clear();
+          co_return;
+        }
+      std::lock_guard lock(control->mtx_);
+      control->write_queue_.pop_front();
+      if (control->write_queue_.empty()) {
+        co_return;
+      }
+    }
+  }
+
+  static async_simple::coro::Lazy<void> multiplexing_recv(
+      std::shared_ptr<multiplexing_control> control) {
+    while (true) {
+      {
+        std::lock_guard lock(control->mtx_);
+        if (control->pending_.empty() || control->has_closed_) {
+          control->is_reading_ = false;
+          co_return;
+        }
+      }
+      multiplexing_response resp;
+      auto [ec, _] = co_await coro_io::async_read(
+          *control->socket_, asio::buffer((char *)&resp.header,
+                                          coro_rpc_protocol::RESP_HEAD_LEN));
+      if (!ec) {
+        if (resp.header.magic != coro_rpc_protocol::magic_number)
+          AS_UNLIKELY {
+            ec = std::make_error_code(std::errc::protocol_error);
+          }
+        else {
+          struct_pack::detail::resize(resp.body, resp.header.length);
+          struct_pack::detail::resize(resp.attachment,
+                                      resp.header.attach_length);
+          std::array<asio::mutable_buffer, 2> iov{
+              asio::mutable_buffer{resp.body.data(), resp.body.size()},
+              asio::mutable_buffer{resp.attachment.data(),
+                                   resp.attachment.size()}};
+          std::tie(ec, std::ignore) =
+              co_await coro_io::async_read(*control->socket_, iov);
+        }
+      }
+      if (ec)
+        AS_UNLIKELY {
+          ELOGV(INFO, "multiplexing read failed: %s", ec.message().data());
+          control->close(ec);
+          co_return;
+        }
+      auto seq_num = resp.header.seq_num;
+      control->finish(seq_num, std::move(resp));
+    }
+  }
+
+  template <auto func, typename... Args>
+  async_simple::coro::Lazy<
+      rpc_result<decltype(get_return_type<func>()), coro_rpc_protocol>>
+  multiplexing_call_impl(auto duration, std::string_view req_attachment,
+                         std::string *resp_attachment, Args... args) {
+    using R = decltype(get_return_type<func>());
+
+    auto buffer = prepare_buffer<func>(std::move(args)...);
+    if (buffer.empty()) {
+      co_return rpc_result<R, coro_rpc_protocol>{
+          unexpect_t{},
+          coro_rpc_protocol::rpc_error{errc::message_too_large,
+                                       "rpc body serialize size too big"}};
+    }
+
+    auto control = multiplexing_;
+    async_simple::Promise<multiplexing_response> resp_promise;
+    auto future = resp_promise.getFuture();
+    uint32_t seq_num;
+    bool start_send, start_recv;
+    {
+      std::lock_guard lock(control->mtx_);
+      if (control->has_closed_)
+        AS_UNLIKELY {
+          co_return rpc_result<R, coro_rpc_protocol>{
+              unexpect_t{},
+              coro_rpc_protocol::rpc_error{errc::io_error,
+                                           "client has been closed"}};
+        }
+      seq_num = ++control->seq_num_;
+      auto &header = *(coro_rpc_protocol::req_header *)buffer.data();
+      header.seq_num = seq_num;
+      header.attach_length = req_attachment.size();
+      control->pending_.emplace(seq_num, std::move(resp_promise));
+      control->write_queue_.emplace_back(std::move(buffer), req_attachment);
+      start_send = control->write_queue_.size() == 1;
+      start_recv = !control->is_reading_;
+      control->is_reading_ = true;
+    }
+    // The timeout callback owns the control block, so the caller needn't
+    // wait for it after a failed cancel.
+    auto &wheel =
+        coro_io::timer_wheel::get(control->executor_.get_asio_executor());
+    auto timer_id = wheel.add(duration, [control,
+                                         seq_num](const std::error_code &ec) {
+      control->finish(
+          seq_num,
+          multiplexing_response{
+              .ec = ec ? std::make_error_code(std::errc::operation_canceled)
+                       : std::make_error_code(std::errc::timed_out),
+              .header = {},
+              .body = {},
+              .attachment = {}});
+    });
+    if (start_send) {
+      multiplexing_send(control).via(&control->executor_).detach();
+    }
+    if (start_recv) {
+      multiplexing_recv(control).via(&control->executor_).detach();
+    }
+
+    auto resp = co_await std::move(future);
+    wheel.cancel(timer_id);
+
+    if (resp.ec)
+      AS_UNLIKELY {
+        if (resp.ec == std::errc::timed_out) {
+          co_return rpc_result<R, coro_rpc_protocol>{
+              unexpect_t{}, coro_rpc_protocol::rpc_error{errc::timed_out,
+                                                         "rpc call timed out"}};
+        }
+        close();
+        co_return rpc_result<R, coro_rpc_protocol>{
+            unexpect_t{},
+            coro_rpc_protocol::rpc_error{errc::io_error, resp.ec.message()}};
+      }
+    if (resp_attachment) {
+      *resp_attachment = std::move(resp.attachment);
+    }
+    bool ec = false;
+    auto r = handle_response_buffer<R>(resp.body, resp.header.err_code, ec);
+    if (ec) {
+      close();
+    }
+    co_return r;
+  }
+
   /*
    * buffer layout
    * ┌────────────────┬────────────────┐
@@ -834,6 +1174,7 @@ class coro_rpc_client {
  private:
   coro_io::ExecutorWrapper<> executor;
   std::shared_ptr<asio::ip::tcp::socket> socket_;
+  std::shared_ptr<multiplexing_control> multiplexing_;
   std::string read_buf_, resp_attachment_buf_;
   std::string_view req_attachment_;
   config config_;
@@ -19,6 +19,7 @@
 #include <asio/dispatch.hpp>
 #include <asio/error_code.hpp>
 #include <asio/io_context.hpp>
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
@@ -84,7 +85,19 @@ class coro_rpc_server_base {
         acceptor_(pool_.get_executor()->get_asio_executor()),
         port_(config.port),
         conn_timeout_duration_(config.conn_timeout_duration),
-        flag_{stat::init} {}
+        max_write_iovecs_(config.max_write_iovecs),
+        max_write_bytes_(config.max_write_bytes),
+        reuse_port_(config.reuse_port),
+        flag_{stat::init} {
+    if (config.enable_write_stats) {
+      write_stats_ = std::make_shared<coro_connection::write_stats>();
+    }
+    if constexpr (requires(typename server_config::executor_pool_t & pool) {
+                    pool.set_thread_affinity(config.thread_affinity);
+                  }) {
+      pool_.set_thread_affinity(config.thread_affinity);
+    }
+  }
 
   ~coro_rpc_server_base() {
     ELOGV(INFO, "coro_rpc_server will quit");
@@ -149,14 +162,22 @@ class coro_rpc_server_base {
     if (!ec) {
       async_simple::Promise<coro_rpc::err_code> promise;
       auto future = promise.getFuture();
-      accept().start([p = std::move(promise)](auto &&res) mutable {
-        if (res.hasError()) {
-          p.setValue(coro_rpc::err_code{coro_rpc::errc::io_error});
-        }
-        else {
-          p.setValue(res.value());
-        }
-      });
+      accept(acceptor_, reuse_port_acceptors_.empty()
+                            ? nullptr
+                            : get_acceptor_executor(0))
+          .start([p = std::move(promise)](auto &&res) mutable {
+            if (res.hasError()) {
+              p.setValue(coro_rpc::err_code{coro_rpc::errc::io_error});
+            }
+            else {
+              p.setValue(res.value());
+            }
+          });
+      for (std::size_t i = 0; i < reuse_port_acceptors_.size(); ++i) {
+        accept(*reuse_port_acceptors_[i], get_acceptor_executor(i + 1))
+            .start([](auto &&) {
+            });
+      }
       return std::move(future);
     }
     else {
@@ -179,16 +200,12 @@ class coro_rpc_server_base {
 
     if (flag_ == stat::started) {
       close_acceptor();
-      {
-        std::unique_lock lock(conns_mtx_);
-        for (auto &conn : conns_) {
-          if (!conn.second->has_closed()) {
-            conn.second->async_close();
-          }
+      conns_.for_each([](auto &conn) {
+        if (!conn->has_closed()) {
+          conn->async_close();
         }
-
-        conns_.clear();
-      }
+      });
+      conns_.clear();
 
       ELOGV(INFO, "wait for server's thread-pool finish all work.");
       pool_.stop();
@@ -284,7 +301,83 @@ class coro_rpc_server_base {
 
   auto &get_io_context_pool() noexcept { return pool_; }
 
+  /*!
+   * Get the number of current connections
+   */
+  std::size_t connection_count() const noexcept { return conns_.size(); }
+
+  /*!
+   * Get the statistics of coalesced response writes of all connections
+   *
+   * @return nullptr if enable_write_stats isn't set in the config
+   */
+  const coro_connection::write_stats *get_write_stats() const noexcept {
+    return write_stats_.get();
+  }
+
  private:
+  /*!
+   * The connections of the server
+   *
+   * They are sharded by conn id, so the accept and close of different io
+   * threads rarely contend on one mutex. The count is kept apart to be read
+   * without any lock.
+   */
+  class connection_registry {
+   public:
+    void emplace(uint64_t id, std::shared_ptr<coro_connection> conn) {
+      auto &shard = get_shard(id);
+      std::unique_lock lock(shard.mtx);
+      if (shard.conns.emplace(id, std::move(conn)).second) {
+        size_.fetch_add(1, std::memory_order::relaxed);
+      }
+    }
+
+    void erase(uint64_t id) {
+      auto &shard = get_shard(id);
+      std::unique_lock lock(shard.mtx);
+      if (shard.conns.erase(id)) {
+        size_.fetch_sub(1, std::memory_order::relaxed);
+      }
+    }
+
+    // visit the connections shard by shard, never hold two locks at once.
+    template <typename Func>
+    void for_each(Func &&func) {
+      for (auto &shard : shards_) {
+        std::unique_lock lock(shard.mtx);
+        for (auto &[id, conn] : shard.conns) {
+          func(conn);
+        }
+      }
+    }
+
+    void clear() {
+      for (auto &shard : shards_) {
+        std::unique_lock lock(shard.mtx);
+        size_.fetch_sub(shard.conns.size(), std::memory_order::relaxed);
+        shard.conns.clear();
+      }
+    }
+
+    std::size_t size() const noexcept {
+      return size_.load(std::memory_order::relaxed);
+    }
+
+   private:
+    static constexpr std::size_t shard_num = 64;
+
+    struct alignas(64) shard {
+      std::mutex mtx;
+      std::unordered_map<uint64_t, std::shared_ptr<coro_connection>> conns;
+    };
+
+    shard &get_shard(uint64_t id) { return shards_[id % shard_num]; }
+
+    std::array<shard, shard_num> shards_;
+    std::atomic<std::size_t> size_ = 0;
+  };
+
   coro_rpc::err_code listen() {
     ELOGV(INFO, "begin to listen");
     using asio::ip::tcp;
@@ -293,6 +386,17 @@ class coro_rpc_server_base {
 #ifdef __GNUC__
     acceptor_.set_option(tcp::acceptor::reuse_address(true));
 #endif
+    bool reuse_port = false;
+    if constexpr (requires(typename server_config::executor_pool_t & pool) {
+                    pool.get_executor(std::size_t{});
+                  }) {
+      if (reuse_port_ && pool_.pool_size() > 1) {
+        reuse_port = coro_io::set_reuse_port(acceptor_);
+        if (!reuse_port) {
+          ELOGV(WARN, "SO_REUSEPORT is not supported, use one acceptor");
+        }
+      }
+    }
     asio::error_code ec;
     acceptor_.bind(endpoint, ec);
     if (ec) {
@@ -315,15 +419,75 @@ class coro_rpc_server_base {
     }
     port_ = end_point.port();
 
+    if (reuse_port) {
+      if (auto error = listen_reuse_port(); error) {
+        return error;
+      }
+    }
+    accepting_cnt_ = 1 + reuse_port_acceptors_.size();
+
     ELOGV(INFO, "listen port %d successfully", port_.load());
     return {};
   }
 
-  async_simple::coro::Lazy<coro_rpc::err_code> accept() {
+  // every other io thread listens the same port by its own acceptor.
+  coro_rpc::err_code listen_reuse_port() {
+    using asio::ip::tcp;
+    auto endpoint = tcp::endpoint(tcp::v4(), port_);
+    for (std::size_t i = 1; i < pool_.pool_size(); ++i) {
+      auto acceptor = std::make_unique<tcp::acceptor>(
+          get_acceptor_executor(i)->get_asio_executor());
+      asio::error_code ec;
+      acceptor->open(endpoint.protocol(), ec);
+      if (!ec) {
+        acceptor->set_option(tcp::acceptor::reuse_address(true), ec);
+        coro_io::set_reuse_port(*acceptor);
+        acceptor->bind(endpoint, ec);
+      }
+      if (!ec) {
+        acceptor->listen(asio::socket_base::max_listen_connections, ec);
+      }
+      if (ec) {
+        ELOGV(ERROR, "listen port %d by SO_REUSEPORT error : %s",
+              port_.load(), ec.message().data());
+        acceptor->close(ec);
+        for (auto &acc : reuse_port_acceptors_) {
+          acc->close(ec);
+        }
+        reuse_port_acceptors_.clear();
+        acceptor_.close(ec);
+        return coro_rpc::errc::address_in_use;
+      }
+      reuse_port_acceptors_.push_back(std::move(acceptor));
+    }
+    return {};
+  }
+
+  coro_io::ExecutorWrapper<> *get_acceptor_executor(std::size_t index) {
+    if constexpr (requires(typename server_config::executor_pool_t & pool) {
+                    pool.get_executor(std::size_t{});
+                  }) {
+      return pool_.get_executor(index);
+    }
+    else {
+      return nullptr;
+    }
+  }
+
+  /*!
+   * Accept the connections of an acceptor
+   *
+   * @param acceptor the acceptor
+   * @param executor the executor of the accepted connections, nullptr to pick
+   * them round-robin.
+   */
+  async_simple::coro::Lazy<coro_rpc::err_code> accept(
+      asio::ip::tcp::acceptor &acceptor,
+      coro_io::ExecutorWrapper<> *fixed_executor) {
     for (;;) {
-      auto executor = pool_.get_executor();
+      auto executor = fixed_executor ? fixed_executor : pool_.get_executor();
       asio::ip::tcp::socket socket(executor->get_asio_executor());
-      auto error = co_await coro_io::async_accept(acceptor_, socket);
+      auto error = co_await coro_io::async_accept(acceptor, socket);
 #ifdef UNIT_TEST_INJECT
       if (g_action == inject_action::force_inject_server_accept_error) {
         asio::error_code ignored_ec;
@@ -338,27 +502,35 @@ class coro_rpc_server_base {
         ELOGV(INFO, "accept failed, error: %s", error.message().data());
         if (error == asio::error::operation_aborted ||
             error == asio::error::bad_descriptor) {
-          acceptor_close_waiter_.set_value();
+          if (--accepting_cnt_ == 0) {
+            acceptor_close_waiter_.set_value();
+          }
           co_return coro_rpc::errc::operation_canceled;
         }
         continue;
       }
 
-      int64_t conn_id = ++conn_id_;
+      if constexpr (requires(typename server_config::executor_pool_t & pool) {
+                      pool.get_executor_by_cpu(0);
+                    }) {
+        if (pool_.numa_aware()) {
+          executor = coro_io::steer_to_numa_node(pool_, socket, executor);
+        }
+      }
+
+      uint64_t conn_id = ++conn_id_;
       ELOGV(INFO, "new client conn_id %d coming", conn_id);
       auto conn = std::make_shared<coro_connection>(executor, std::move(socket),
                                                     conn_timeout_duration_);
+      conn->set_write_batch_limit(max_write_iovecs_, max_write_bytes_,
+                                  write_stats_);
       conn->set_quit_callback(
           [this](const uint64_t &id) {
-            std::unique_lock lock(conns_mtx_);
             conns_.erase(id);
           },
           conn_id);
 
-      {
-        std::unique_lock lock(conns_mtx_);
-        conns_.emplace(conn_id, conn);
-      }
+      conns_.emplace(conn_id, conn);
       start_one(conn).via(&conn->get_executor()).detach();
     }
   }
@@ -374,30 +546,43 @@ class coro_rpc_server_base {
   }
 
   void close_acceptor() {
-    asio::dispatch(acceptor_.get_executor(), [this]() {
-      asio::error_code ec;
-      (void)acceptor_.cancel(ec);
-      (void)acceptor_.close(ec);
-    });
+    auto close = [](asio::ip::tcp::acceptor &acceptor) {
+      asio::dispatch(acceptor.get_executor(), [&acceptor]() {
+        asio::error_code ec;
+        (void)acceptor.cancel(ec);
+        (void)acceptor.close(ec);
+      });
+    };
+    close(acceptor_);
+    for (auto &acceptor : reuse_port_acceptors_) {
+      close(*acceptor);
+    }
     acceptor_close_waiter_.get_future().wait();
   }
 
   typename server_config::executor_pool_t pool_;
   asio::ip::tcp::acceptor acceptor_;
+  // the acceptors of the other io threads in SO_REUSEPORT mode.
+  std::vector<std::unique_ptr<asio::ip::tcp::acceptor>> reuse_port_acceptors_;
+  std::atomic<std::size_t> accepting_cnt_ = 0;
   std::promise<void> acceptor_close_waiter_;
 
   std::thread thd_;
   stat flag_;
 
   std::mutex start_mtx_;
-  uint64_t conn_id_ = 0;
-  std::unordered_map<uint64_t, std::shared_ptr<coro_connection>> conns_;
-  std::mutex conns_mtx_;
+  // the accept loops of SO_REUSEPORT mode run in different threads.
+  std::atomic<uint64_t> conn_id_ = 0;
+  connection_registry conns_;
 
   typename server_config::rpc_protocol::router router_;
 
   std::atomic<uint16_t> port_;
   std::chrono::steady_clock::duration conn_timeout_duration_;
+  std::size_t max_write_iovecs_ = 256;
+  std::size_t max_write_bytes_ = 1024 * 1024;
+  bool reuse_port_ = false;
+  std::shared_ptr<coro_connection::write_stats> write_stats_;
 
 #ifdef YLT_ENABLE_SSL
   asio::ssl::context context_{asio::ssl::context::sslv23};
@@ -31,6 +31,18 @@ struct coro_rpc_config_base {
   unsigned thread_num = std::thread::hardware_concurrency();
   std::chrono::steady_clock::duration conn_timeout_duration =
       std::chrono::seconds{0};
+  // budget of one coalesced response write of a connection.
+  std::size_t max_write_iovecs = 256;
+  std::size_t max_write_bytes = 1024 * 1024;
+  // count the coalesced response writes of all connections, see
+  // coro_rpc_server::get_write_stats. The counters are shared by the
+  // connections, so they're disabled by default.
+  bool enable_write_stats = false;
+  // cpu pinning and NUMA grouping of the io threads.
+  coro_io::thread_affinity_config thread_affinity;
+  // open one SO_REUSEPORT acceptor per io thread, the kernel balances the
+  // connections between them. Only for linux.
+  bool reuse_port = false;
 };
 
 struct coro_rpc_default_config : public coro_rpc_config_base {
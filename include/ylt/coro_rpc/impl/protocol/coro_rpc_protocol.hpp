@@ -94,7 +94,6 @@ struct coro_rpc_protocol {
   template <typename Socket>
   static async_simple::coro::Lazy<std::error_code> read_head(
       Socket& socket, req_header& req_head) {
-    // TODO: add a connection-level buffer in parameter to reuse memory
     auto [ec, _] = co_await coro_io::async_read(
         socket, asio::buffer((char*)&req_head, sizeof(req_header)));
     if (ec)
@@ -180,6 +179,39 @@ struct coro_rpc_protocol {
     return header_buf;
   }
 
+  /*!
+   * Write the response header in place
+   *
+   * The first RESP_HEAD_LEN bytes of `rpc_result` are reserved for the header
+   * and the rest is the serialized result, so the response can be sent as one
+   * buffer without allocating a header.
+   *
+   * @return coro_rpc::errc::message_too_large if the result is too large,
+   * then `rpc_result` holds the error message instead.
+   */
+  static coro_rpc::errc prepare_response_in_place(
+      std::string& rpc_result, const req_header& req_header) {
+    coro_rpc::errc rpc_err_code{};
+    if (rpc_result.size() - RESP_HEAD_LEN > UINT32_MAX)
+      AS_UNLIKELY {
+        auto sz = rpc_result.size() - RESP_HEAD_LEN;
+        ELOGV(ERROR, "body larger than 4G:%d", sz);
+        rpc_err_code = coro_rpc::errc::message_too_large;
+        rpc_result.resize(RESP_HEAD_LEN);
+        struct_pack::serialize_to(
+            rpc_result, "body larger than 4G:" + std::to_string(sz) + "B");
+      }
+    auto& resp_head = *(resp_header*)rpc_result.data();
+    resp_head.magic = magic_number;
+    resp_head.version = VERSION_NUMBER;
+    resp_head.err_code = static_cast<uint8_t>(rpc_err_code);
+    resp_head.msg_type = 0;
+    resp_head.seq_num = req_header.seq_num;
+    resp_head.length = rpc_result.size() - RESP_HEAD_LEN;
+    resp_head.attach_length = 0;
+    return rpc_err_code;
+  }
+
   /*!
    * The RPC error for client
    *
@@ -48,6 +48,35 @@ template <typename rpc_protocol>
 using rpc_context = std::shared_ptr<context_info_t<rpc_protocol>>;
 
 using rpc_conn = std::shared_ptr<coro_connection>;
+
+// The buffer of rpc result is recycled by the connection. If the protocol
+// writes the response header in place, the header bytes are reserved before
+// the result.
+template <typename rpc_protocol>
+inline std::string get_result_buffer(rpc_context<rpc_protocol> &context_info) {
+  std::string buffer;
+  if (context_info->resp_head_len_ > 0)
+    AS_LIKELY {
+      buffer = context_info->conn_->get_buffer();
+      buffer.resize(context_info->resp_head_len_);
+    }
+  return buffer;
+}
+
+template <typename serialize_proto, typename... Args>
+inline std::string serialize_result(std::string buffer, const Args &...args) {
+  if constexpr (requires { serialize_proto::serialize_to(buffer, args...); }) {
+    serialize_proto::serialize_to(buffer, args...);
+  }
+  else {
+    if (buffer.empty()) {
+      return serialize_proto::serialize(args...);
+    }
+    buffer.append(serialize_proto::serialize(args...));
+  }
+  return buffer;
+}
+
 template <typename rpc_protocol, typename serialize_proto, auto func,
           typename Self = void>
 inline std::optional<std::string> execute(
@@ -112,19 +141,29 @@ inline std::optional<std::string> execute(
                      std::tuple_cat(std::forward_as_tuple(o), std::move(args)));
         }
       }
+      if constexpr (has_coro_conn_v) {
+        // the handler responds by the context, maybe delayed, so the unused
+        // result doesn't take a buffer from the pool.
+        return serialize_result<serialize_proto>(
+            std::string(context_info->resp_head_len_, '\0'));
+      }
     }
     else {
       if constexpr (std::is_void_v<Self>) {
         // call return_type func(args...)
 
-        return serialize_proto::serialize(std::apply(func, std::move(args)));
+        return serialize_result<serialize_proto>(
+            get_result_buffer(context_info),
+            std::apply(func, std::move(args)));
       }
       else {
         auto &o = *self;
         // call return_type o.func(args...)
 
-        return serialize_proto::serialize(std::apply(
-            func, std::tuple_cat(std::forward_as_tuple(o), std::move(args))));
+        return serialize_result<serialize_proto>(
+            get_result_buffer(context_info),
+            std::apply(func, std::tuple_cat(std::forward_as_tuple(o),
+                                            std::move(args))));
       }
     }
   }
@@ -139,14 +178,16 @@ inline std::optional<std::string> execute(
     }
     else {
       if constexpr (std::is_void_v<Self>) {
-        return serialize_proto::serialize(func());
+        return serialize_result<serialize_proto>(
+            get_result_buffer(context_info), func());
       }
       else {
-        return serialize_proto::serialize((self->*func)());
+        return serialize_result<serialize_proto>(
+            get_result_buffer(context_info), (self->*func)());
       }
     }
   }
-  return serialize_proto::serialize();
+  return serialize_result<serialize_proto>(get_result_buffer(context_info));
 }
 
 template <typename rpc_protocol, typename serialize_proto, auto func,
@@ -158,6 +199,8 @@ inline async_simple::coro::Lazy<std::optional<std::string>> execute_coro(
   using param_type = util::function_parameters_t<T>;
   using return_type = typename get_type_t<
       typename util::function_return_type_t<T>::ValueType>::type;
+  // the handler may resume on another executor, get the buffer before it.
+  std::string buffer;
 
   if constexpr (!std::is_void_v<param_type>) {
     using First = std::tuple_element_t<0, param_type>;
@@ -171,6 +214,10 @@ inline async_simple::coro::Lazy<std::optional<std::string>> execute_coro(
     constexpr bool has_coro_conn_v =
         std::is_same_v<context_base<conn_return_type, rpc_protocol>, First>;
     auto args = util::get_args<has_coro_conn_v, param_type>();
+    // the handler which takes the context responds by it, maybe delayed.
+    if constexpr (!has_coro_conn_v) {
+      buffer = get_result_buffer(context_info);
+    }
 
     bool is_ok = true;
     constexpr size_t size = std::tuple_size_v<decltype(args)>;
@@ -211,22 +258,29 @@ inline async_simple::coro::Lazy<std::optional<std::string>> execute_coro(
               func, std::tuple_cat(std::forward_as_tuple(o), std::move(args)));
         }
       }
+      if constexpr (has_coro_conn_v) {
+        co_return serialize_result<serialize_proto>(
+            std::string(context_info->resp_head_len_, '\0'));
+      }
     }
     else {
       if constexpr (std::is_void_v<Self>) {
         // call return_type func(args...)
-        co_return serialize_proto::serialize(
-            co_await std::apply(func, std::move(args)));
+        co_return serialize_result<serialize_proto>(
+            std::move(buffer), co_await std::apply(func, std::move(args)));
       }
       else {
         auto &o = *self;
         // call return_type o.func(args...)
-        co_return serialize_proto::serialize(co_await std::apply(
-            func, std::tuple_cat(std::forward_as_tuple(o), std::move(args))));
+        co_return serialize_result<serialize_proto>(
+            std::move(buffer),
+            co_await std::apply(func, std::tuple_cat(std::forward_as_tuple(o),
+                                                     std::move(args))));
       }
     }
   }
   else {
+    buffer = get_result_buffer(context_info);
     if constexpr (std::is_void_v<return_type>) {
       if constexpr (std::is_void_v<Self>) {
         co_await func();
@@ -239,15 +293,16 @@ inline async_simple::coro::Lazy<std::optional<std::string>> execute_coro(
     }
     else {
       if constexpr (std::is_void_v<Self>) {
-        co_return serialize_proto::serialize(co_await func());
+        co_return serialize_result<serialize_proto>(std::move(buffer),
+                                                    co_await func());
       }
       else {
         // clang-format off
-          co_return serialize_proto::serialize(co_await (self->*func)());
+        co_return serialize_result<serialize_proto>(std::move(buffer), co_await (self->*func)());
         // clang-format on
       }
     }
   }
-  co_return serialize_proto::serialize();
+  co_return serialize_result<serialize_proto>(std::move(buffer));
 }
 }  // namespace coro_rpc::internal
\ No newline at end of file
@@ -22,13 +22,18 @@
 
 #include "struct_pack/alignment.hpp"
 #include "struct_pack/calculate_size.hpp"
+#include "struct_pack/chunked_buffer.hpp"
+#include "struct_pack/column_view.hpp"
 #include "struct_pack/compatible.hpp"
+#include "struct_pack/compression.hpp"
 #include "struct_pack/derived_helper.hpp"
 #include "struct_pack/derived_marco.hpp"
 #include "struct_pack/error_code.hpp"
 #include "struct_pack/md5_constexpr.hpp"
 #include "struct_pack/packer.hpp"
+#include "struct_pack/parallel.hpp"
 #include "struct_pack/reflection.hpp"
+#include "struct_pack/stream_decoder.hpp"
 #include "struct_pack/trivial_view.hpp"
 #include "struct_pack/type_calculate.hpp"
 #include "struct_pack/type_id.hpp"
@@ -270,6 +275,111 @@ serialize_with_offset(std::size_t offset, const Args &...args) {
   return buffer;
 }
 
+/*!
+ * \ingroup struct_pack
+ * Serialize a large container such as `std::vector<T>` in parallel and append
+ * the result to the buffer. The sizes of the parts of the container are
+ * calculated and the parts are serialized by `parallelism` threads at the same
+ * time, the threads are started once and take the parts one by one. The
+ * result is the same as `serialize_to(buffer, t)`, which is used instead if
+ * the container can't be serialized in parallel.
+ * @param buffer the output buffer.
+ * @param t the container.
+ * @param parallelism the count of threads.
+ */
+template <uint64_t conf = sp_config::DEFAULT,
+#if __cpp_concepts >= 201907L
+          detail::struct_pack_buffer Buffer,
+#else
+          typename Buffer,
+#endif
+          typename T>
+void parallel_serialize_to(
+    Buffer &buffer, const T &t,
+    std::size_t parallelism = std::thread::hardware_concurrency()) {
+#if __cpp_concepts < 201907L
+  static_assert(detail::struct_pack_buffer<Buffer>,
+                "The buffer is not satisfied struct_pack_buffer requirement!");
+#endif
+  detail::thread_executor executor(parallelism);
+  detail::parallel_serialize_to<conf>(buffer, t, executor, parallelism);
+}
+
+/*!
+ * \ingroup struct_pack
+ * Serialize a large container in parallel by the tasks scheduled on the
+ * executor, which could be an `async_simple::Executor` or any type that has a
+ * member function `bool schedule(std::function<void()>)`.
+ * @param buffer the output buffer.
+ * @param t the container.
+ * @param executor the executor.
+ * @param parallelism the count of tasks to run at the same time.
+ */
+template <uint64_t conf = sp_config::DEFAULT,
+#if __cpp_concepts >= 201907L
+          detail::struct_pack_buffer Buffer,
+#else
+          typename Buffer,
+#endif
+          typename T, typename Executor,
+          std::enable_if_t<detail::parallel_executor<Executor>, int> = 0>
+void parallel_serialize_to(
+    Buffer &buffer, const T &t, Executor &executor,
+    std::size_t parallelism = std::thread::hardware_concurrency()) {
+#if __cpp_concepts < 201907L
+  static_assert(detail::struct_pack_buffer<Buffer>,
+                "The buffer is not satisfied struct_pack_buffer requirement!");
+#endif
+  detail::parallel_serialize_to<conf>(buffer, t, executor, parallelism);
+}
+
+template <
+#if __cpp_concepts >= 201907L
+    detail::struct_pack_buffer Buffer = std::vector<char>,
+#else
+    typename Buffer = std::vector<char>,
+#endif
+    typename T>
+[[nodiscard]] Buffer parallel_serialize(
+    const T &t, std::size_t parallelism = std::thread::hardware_concurrency()) {
+  Buffer buffer;
+  parallel_serialize_to(buffer, t, parallelism);
+  return buffer;
+}
+
+template <uint64_t conf,
+#if __cpp_concepts >= 201907L
+          detail::struct_pack_buffer Buffer = std::vector<char>,
+#else
+          typename Buffer = std::vector<char>,
+#endif
+          typename T>
+[[nodiscard]] Buffer parallel_serialize(
+    const T &t, std::size_t parallelism = std::thread::hardware_concurrency()) {
+  Buffer buffer;
+  parallel_serialize_to<conf>(buffer, t, parallelism);
+  return buffer;
+}
+
+/*!
+ * \ingroup struct_pack
+ * Serialize the objects into the chunked buffer in one pass, instead of
+ * calculating the size of the objects before serializing them. The metainfo
+ * is written in front of the data after the objects are serialized. The
+ * buffer is cleared first, and the result is the same as `serialize`.
+ *
+ * It's faster than `serialize_to(buffer, args...)`, which serializes into the
+ * chunked buffer in two passes. Serializing into a continuous buffer is still
+ * faster if the chunks are copied to a continuous buffer at last.
+ * @param buffer the output buffer.
+ * @param args the serialized objects.
+ */
+template <uint64_t conf = sp_config::DEFAULT, typename... Args>
+void single_pass_serialize_to(chunked_buffer &buffer, const Args &...args) {
+  static_assert(sizeof...(args) > 0);
+  detail::single_pass_serialize_to<conf>(buffer, args...);
+}
+
 #if __cpp_concepts >= 201907L
 template <uint64_t conf = sp_config::DEFAULT, typename T, typename... Args,
           detail::deserialize_view View>
@@ -295,6 +405,42 @@ template <uint64_t conf = sp_config::DEFAULT, typename T, typename... Args>
   return in.deserialize(t, args...);
 }
 
+#if __cpp_lib_memory_resource >= 201603L
+// Deserialize with a memory resource: every std::pmr container in t (including
+// the nested ones) will allocate from the resource, e.g. a
+// std::pmr::monotonic_buffer_resource, so the whole message can be freed in
+// O(1) by releasing the resource.
+#if __cpp_concepts >= 201907L
+template <uint64_t conf = sp_config::DEFAULT, typename T, typename Resource,
+          detail::deserialize_view View>
+  requires std::is_base_of_v<std::pmr::memory_resource, Resource>
+#else
+template <
+    uint64_t conf = sp_config::DEFAULT, typename T, typename Resource,
+    typename View,
+    typename = std::enable_if_t<
+        struct_pack::detail::deserialize_view<View> &&
+        std::is_base_of_v<std::pmr::memory_resource, Resource>>>
+#endif
+[[nodiscard]] STRUCT_PACK_INLINE struct_pack::errc deserialize_to(
+    T &t, const View &v, Resource *resource) {
+  detail::memory_reader reader{(const char *)v.data(),
+                               (const char *)v.data() + v.size()};
+  detail::unpacker<detail::memory_reader, conf> in(reader, resource);
+  return in.deserialize(t);
+}
+
+template <uint64_t conf = sp_config::DEFAULT, typename T, typename Resource,
+          typename = std::enable_if_t<
+              std::is_base_of_v<std::pmr::memory_resource, Resource>>>
+[[nodiscard]] STRUCT_PACK_INLINE struct_pack::errc deserialize_to(
+    T &t, const char *data, size_t size, Resource *resource) {
+  detail::memory_reader reader{data, data + size};
+  detail::unpacker<detail::memory_reader, conf> in(reader, resource);
+  return in.deserialize(t);
+}
+#endif
+
 #if __cpp_concepts >= 201907L
 template <uint64_t conf = sp_config::DEFAULT, typename T, typename... Args,
           struct_pack::reader_t Reader>
@@ -410,6 +556,41 @@ template <typename... Args>
   }
   return ret;
 }
+
+#if __cpp_lib_memory_resource >= 201603L
+#if __cpp_concepts >= 201907L
+template <typename T, detail::deserialize_view View, typename Resource>
+  requires std::is_base_of_v<std::pmr::memory_resource, Resource>
+#else
+template <typename T, typename View, typename Resource,
+          typename = std::enable_if_t<
+              detail::deserialize_view<View> &&
+              std::is_base_of_v<std::pmr::memory_resource, Resource>>>
+#endif
+[[nodiscard]] STRUCT_PACK_INLINE auto deserialize(const View &v,
+                                                  Resource *resource) {
+  expected<T, struct_pack::errc> ret;
+  auto errc = deserialize_to(ret.value(), v, resource);
+  if SP_UNLIKELY (errc != struct_pack::errc{}) {
+    ret = unexpected<struct_pack::errc>{errc};
+  }
+  return ret;
+}
+
+template <typename T, typename Resource,
+          typename = std::enable_if_t<
+              std::is_base_of_v<std::pmr::memory_resource, Resource>>>
+[[nodiscard]] STRUCT_PACK_INLINE auto deserialize(const char *data,
+                                                  size_t size,
+                                                  Resource *resource) {
+  expected<T, struct_pack::errc> ret;
+  if (auto errc = deserialize_to(ret.value(), data, size, resource);
+      errc != struct_pack::errc{}) {
+    ret = unexpected<struct_pack::errc>{errc};
+  }
+  return ret;
+}
+#endif
 #if __cpp_concepts >= 201907L
 template <typename... Args, struct_pack::reader_t Reader>
 #else
@@ -641,6 +822,259 @@ template <typename T, size_t I, uint64_t conf = sp_config::DEFAULT,
   }
   return ret;
 }
+
+namespace detail {
+template <typename T, size_t I>
+using column_type_t = std::tuple_element_t<
+    I, decltype(detail::get_types<typename T::value_type>())>;
+}
+
+/*!
+ * \ingroup struct_pack
+ * \brief deserialize the Ith column of T, which is a container of the struct
+ * configured with sp_config::ENCODING_WITH_COLUMNAR. The columns before it
+ * are skipped without being decoded into T.
+ *
+ * @tparam T the type of the serialized container, such as std::vector<point>
+ * @tparam I the index of the member
+ * @return expected<std::vector<member type>, struct_pack::errc>
+ */
+#if __cpp_concepts >= 201907L
+template <typename T, size_t I, uint64_t conf = sp_config::DEFAULT,
+          detail::deserialize_view View>
+#else
+template <typename T, size_t I, uint64_t conf = sp_config::DEFAULT,
+          typename View,
+          typename = std::enable_if_t<detail::deserialize_view<View>>>
+#endif
+[[nodiscard]] STRUCT_PACK_INLINE auto get_column(const View &v) {
+  expected<std::vector<detail::column_type_t<T, I>>, struct_pack::errc> ret;
+  detail::memory_reader reader((const char *)v.data(),
+                               (const char *)v.data() + v.size());
+  detail::unpacker<detail::memory_reader, conf> in(reader);
+  auto ec = in.template get_column<T, I>(ret.value());
+  if SP_UNLIKELY (ec != struct_pack::errc{}) {
+    ret = unexpected<struct_pack::errc>{ec};
+  }
+  return ret;
+}
+
+template <typename T, size_t I, uint64_t conf = sp_config::DEFAULT>
+[[nodiscard]] STRUCT_PACK_INLINE auto get_column(const char *data,
+                                                 size_t size) {
+  expected<std::vector<detail::column_type_t<T, I>>, struct_pack::errc> ret;
+  detail::memory_reader reader{data, data + size};
+  detail::unpacker<detail::memory_reader, conf> in(reader);
+  auto ec = in.template get_column<T, I>(ret.value());
+  if SP_UNLIKELY (ec != struct_pack::errc{}) {
+    ret = unexpected<struct_pack::errc>{ec};
+  }
+  return ret;
+}
+
+/*!
+ * \ingroup struct_pack
+ * \brief get the view of the Ith column of T without copy, the member type
+ * should be trivially serializable. See struct_pack::column_view.
+ *
+ * @tparam T the type of the serialized container, such as std::vector<point>
+ * @tparam I the index of the member
+ * @return expected<column_view<member type>, struct_pack::errc>
+ */
+#if __cpp_concepts >= 201907L
+template <typename T, size_t I, uint64_t conf = sp_config::DEFAULT,
+          detail::deserialize_view View>
+#else
+template <typename T, size_t I, uint64_t conf = sp_config::DEFAULT,
+          typename View,
+          typename = std::enable_if_t<detail::deserialize_view<View>>>
+#endif
+[[nodiscard]] STRUCT_PACK_INLINE auto get_column_view(const View &v) {
+  expected<column_view<detail::column_type_t<T, I>>, struct_pack::errc> ret;
+  detail::memory_reader reader((const char *)v.data(),
+                               (const char *)v.data() + v.size());
+  detail::unpacker<detail::memory_reader, conf> in(reader);
+  auto ec = in.template get_column<T, I>(ret.value());
+  if SP_UNLIKELY (ec != struct_pack::errc{}) {
+    ret = unexpected<struct_pack::errc>{ec};
+  }
+  return ret;
+}
+
+template <typename T, size_t I, uint64_t conf = sp_config::DEFAULT>
+[[nodiscard]] STRUCT_PACK_INLINE auto get_column_view(const char *data,
+                                                      size_t size) {
+  expected<column_view<detail::column_type_t<T, I>>, struct_pack::errc> ret;
+  detail::memory_reader reader{data, data + size};
+  detail::unpacker<detail::memory_reader, conf> in(reader);
+  auto ec = in.template get_column<T, I>(ret.value());
+  if SP_UNLIKELY (ec != struct_pack::errc{}) {
+    ret = unexpected<struct_pack::errc>{ec};
+  }
+  return ret;
+}
+
+/*!
+ * \ingroup struct_pack
+ * \brief a lazy accessor of the serialized data of T.
+ *
+ * The members are only deserialized when they are accessed by get/get_to.
+ * If T is configured with sp_config::ENCODING_WITH_FIELD_OFFSET, the Ith
+ * member is located by the field offset table directly and the members before
+ * it are not decoded. get_view returns the view of a nested struct member in
+ * the same way, so a deep member can be read without decoding its parents.
+ *
+ * For example:
+ * ```cpp
+ * struct person {
+ *   std::string name;
+ *   std::vector<std::string> tags;
+ *   int age;
+ *   constexpr static auto struct_pack_config =
+ *       struct_pack::ENCODING_WITH_FIELD_OFFSET;
+ * };
+ * auto buffer = struct_pack::serialize(person{...});
+ * auto view = struct_pack::get_view<person>(buffer);
+ * auto age = view->get<2>();  // skip name and tags
+ * ```
+ *
+ * The view doesn't own the buffer, and T should not have compatible member.
+ * @tparam T the type of the serialized data
+ * @tparam conf the config used to serialize the data
+ */
+template <typename T, uint64_t conf = sp_config::DEFAULT>
+class view {
+  static_assert(!detail::exist_compatible_member<T>,
+                "struct_pack::view doesn't support the type which has "
+                "compatible member.");
+
+ public:
+  template <size_t I>
+  using field_type = std::tuple_element_t<I, decltype(detail::get_types<T>())>;
+
+  view() = default;
+  /*!
+   * \brief construct the view with the payload of T, without metainfo.
+   * Use struct_pack::get_view to create a view from the serialized buffer.
+   */
+  view(const char *data, std::size_t size, unsigned char size_type) noexcept
+      : data_(data), size_(size), size_type_(size_type) {}
+
+  const char *data() const noexcept { return data_; }
+  std::size_t size() const noexcept { return size_; }
+
+  /*!
+   * \brief deserialize the Ith member to dst.
+   */
+  template <size_t I>
+  [[nodiscard]] struct_pack::errc get_to(field_type<I> &dst) const {
+    if constexpr (detail::has_field_offset_table<T>()) {
+      const char *begin, *end;
+      auto ec = locate(I, begin, end);
+      if SP_UNLIKELY (ec != struct_pack::errc{}) {
+        return ec;
+      }
+      detail::memory_reader reader{begin, end};
+      detail::unpacker<detail::memory_reader, conf> in(reader);
+      in.set_size_type(size_type_);
+      return in.template deserialize_member<detail::get_parent_tag<T>()>(dst);
+    }
+    else {
+      detail::memory_reader reader{data_, data_ + size_};
+      detail::unpacker<detail::memory_reader, conf> in(reader);
+      in.set_size_type(size_type_);
+      return in.template get_field_without_metainfo<T, I>(dst);
+    }
+  }
+
+  /*!
+   * \brief deserialize the Ith member.
+   */
+  template <size_t I>
+  [[nodiscard]] expected<field_type<I>, struct_pack::errc> get() const {
+    expected<field_type<I>, struct_pack::errc> ret;
+    auto ec = get_to<I>(ret.value());
+    if SP_UNLIKELY (ec != struct_pack::errc{}) {
+      ret = unexpected<struct_pack::errc>{ec};
+    }
+    return ret;
+  }
+
+  /*!
+   * \brief get the view of the Ith member, which should be a struct.
+   * T should be encoded with the field offset table.
+   */
+  template <size_t I>
+  [[nodiscard]] expected<view<field_type<I>, conf>, struct_pack::errc>
+  get_view() const {
+    static_assert(detail::has_field_offset_table<T>(),
+                  "get_view of member requires T is configured with "
+                  "ENCODING_WITH_FIELD_OFFSET.");
+    static_assert(std::is_class_v<field_type<I>> &&
+                      detail::get_type_id<field_type<I>>() ==
+                          detail::type_id::struct_t,
+                  "The Ith member should be a struct.");
+    const char *begin, *end;
+    auto ec = locate(I, begin, end);
+    if SP_UNLIKELY (ec != struct_pack::errc{}) {
+      return unexpected<struct_pack::errc>{ec};
+    }
+    return view<field_type<I>, conf>{begin, static_cast<size_t>(end - begin),
+                                     size_type_};
+  }
+
+ private:
+  struct_pack::errc locate(std::size_t index, const char *&begin,
+                           const char *&end) const {
+    constexpr std::size_t table_size =
+        sizeof(uint32_t) * struct_pack::members_count<T>;
+    if SP_UNLIKELY (size_ < table_size) {
+      return struct_pack::errc::no_buffer_space;
+    }
+    detail::memory_reader reader{data_, data_ + table_size};
+    uint32_t first = 0, last = 0;
+    if (index > 0) {
+      reader.ignore(sizeof(uint32_t) * (index - 1));
+      detail::read_wrapper<sizeof(uint32_t)>(reader, (char *)&first);
+    }
+    detail::read_wrapper<sizeof(uint32_t)>(reader, (char *)&last);
+    if SP_UNLIKELY (first > last || last > size_ - table_size) {
+      return struct_pack::errc::invalid_buffer;
+    }
+    begin = data_ + table_size + first;
+    end = data_ + table_size + last;
+    return struct_pack::errc{};
+  }
+
+  const char *data_ = nullptr;
+  std::size_t size_ = 0;
+  unsigned char size_type_ = 0;
+};
+
+template <typename T, uint64_t conf = sp_config::DEFAULT>
+[[nodiscard]] STRUCT_PACK_INLINE expected<view<T, conf>, struct_pack::errc>
+get_view(const char *data, size_t size) {
+  detail::memory_reader reader{data, data + size};
+  detail::unpacker<detail::memory_reader, conf> in(reader);
+  auto ec = in.template deserialize_metainfo<T>().first;
+  if SP_UNLIKELY (ec != struct_pack::errc{}) {
+    return unexpected<struct_pack::errc>{ec};
+  }
+  return view<T, conf>{reader.now, static_cast<size_t>(reader.end - reader.now),
+                       in.size_type()};
+}
+
+#if __cpp_concepts >= 201907L
+template <typename T, uint64_t conf = sp_config::DEFAULT,
+          detail::deserialize_view View>
+#else
+template <typename T, uint64_t conf = sp_config::DEFAULT, typename View,
+          typename = std::enable_if_t<detail::deserialize_view<View>>>
+#endif
+[[nodiscard]] STRUCT_PACK_INLINE expected<view<T, conf>, struct_pack::errc>
+get_view(const View &v) {
+  return get_view<T, conf>((const char *)v.data(), v.size());
+}
 #if __cpp_concepts >= 201907L
 template <typename BaseClass, typename... DerivedClasses,
           struct_pack::reader_t Reader>
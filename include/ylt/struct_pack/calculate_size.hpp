@@ -81,6 +81,9 @@ constexpr size_info inline calculate_one_size(const T &item) {
       using value_type = typename type::value_type;
       ret.total = item.size() * sizeof(value_type);
     }
+    else if constexpr (is_bulk_varint_container<type>()) {
+      ret.total = calculate_varint_size_bulk(item.data(), item.size());
+    }
     else {
       for (auto &&i : item) {
         ret += calculate_one_size(i);
@@ -160,6 +163,9 @@ constexpr size_info inline calculate_one_size(const T &item) {
     }
     else {
       constexpr uint64_t tag = get_parent_tag<type>();
+      if constexpr (has_field_offset_table<type>()) {
+        ret.total += sizeof(uint32_t) * struct_pack::members_count<type>;
+      }
       if constexpr (is_enable_fast_varint_coding(tag)) {
         ret.total +=
             visit_members(item, [](auto &&...items) CONSTEXPR_INLINE_LAMBDA {
@@ -384,8 +390,8 @@ calculate_fast_varint_size(const Args &...items) {
 }
 
 template <uint64_t conf, typename... Args>
-STRUCT_PACK_INLINE constexpr serialize_buffer_size get_serialize_runtime_info(
-    const Args &...args);
+STRUCT_PACK_INLINE constexpr serialize_buffer_size
+get_serialize_runtime_info_by_payload(const size_info &sz_info);
 }  // namespace detail
 struct serialize_buffer_size {
  private:
@@ -400,12 +406,15 @@ struct serialize_buffer_size {
 
   template <uint64_t conf, typename... Args>
   friend STRUCT_PACK_INLINE constexpr serialize_buffer_size
-  struct_pack::detail::get_serialize_runtime_info(const Args &...args);
+  struct_pack::detail::get_serialize_runtime_info_by_payload(
+      const size_info &sz_info);
 };
 namespace detail {
+// Get the buffer size and the metainfo from the size info of the payload,
+// which may be calculated in parts.
 template <uint64_t conf, typename... Args>
 [[nodiscard]] STRUCT_PACK_INLINE constexpr serialize_buffer_size
-get_serialize_runtime_info(const Args &...args) {
+get_serialize_runtime_info_by_payload(const size_info &sz_info) {
   using Type = get_args_type<Args...>;
   constexpr bool has_compatible = serialize_static_config<Type>::has_compatible;
   constexpr bool has_type_literal = check_if_add_type_literal<conf, Type>();
@@ -414,7 +423,6 @@ get_serialize_runtime_info(const Args &...args) {
   constexpr bool has_compile_time_determined_meta_info =
       check_has_metainfo<conf, Type>();
   serialize_buffer_size ret;
-  auto sz_info = calculate_payload_size(args...);
   if constexpr (has_compile_time_determined_meta_info) {
     ret.len_ = sizeof(unsigned char);
   }
@@ -471,5 +479,12 @@ get_serialize_runtime_info(const Args &...args) {
   }
   return ret;
 }
+
+template <uint64_t conf, typename... Args>
+[[nodiscard]] STRUCT_PACK_INLINE constexpr serialize_buffer_size
+get_serialize_runtime_info(const Args &...args) {
+  return get_serialize_runtime_info_by_payload<conf, Args...>(
+      calculate_payload_size(args...));
+}
 }  // namespace detail
 }  // namespace struct_pack
\ No newline at end of file
@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "calculate_size.hpp"
+#include "marco.h"
+#include "packer.hpp"
+#include "reflection.hpp"
+#include "type_calculate.hpp"
+#include "util.h"
+
+namespace struct_pack {
+namespace detail {
+class single_pass_writer;
+}
+
+/*!
+ * \ingroup struct_pack
+ * \brief a growable output buffer made of chunks, the data is never moved
+ * when the buffer grows. It satisfies the writer_t requirement.
+ *
+ * clear() keeps the chunks, so a reused buffer doesn't allocate memory once it
+ * has grown to the size of the data. The data can be read chunk by chunk, for
+ * example to send them by a scatter-gather write, or be copied to a
+ * continuous buffer by append_to.
+ */
+class chunked_buffer {
+  struct chunk_storage {
+    std::unique_ptr<char[]> data;
+    std::size_t capacity;
+    std::size_t size;
+  };
+
+ public:
+  static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+  explicit chunked_buffer(std::size_t chunk_size = default_chunk_size)
+      : chunk_size_((std::max)(chunk_size, std::size_t{64})) {}
+  chunked_buffer(chunked_buffer &&) = default;
+  chunked_buffer &operator=(chunked_buffer &&) = default;
+
+  STRUCT_PACK_INLINE void write(const char *data, std::size_t len) {
+    if SP_LIKELY (static_cast<std::size_t>(end_ - pos_) >= len) {
+      std::memcpy(pos_, data, len);
+      pos_ += len;
+    }
+    else {
+      write_slow(data, len);
+    }
+  }
+
+  std::size_t size() const noexcept {
+    return pos_ == nullptr
+               ? 0
+               : committed_ + (pos_ - chunks_[current_].data.get()) - front_;
+  }
+  bool empty() const noexcept { return size() == 0; }
+
+  std::size_t chunk_count() const noexcept {
+    return pos_ == nullptr ? 0 : current_ + 1;
+  }
+  std::string_view chunk(std::size_t i) const noexcept {
+    assert(i < chunk_count());
+    const char *begin = chunks_[i].data.get() + (i == 0 ? front_ : 0);
+    const char *end =
+        i == current_ ? pos_ : chunks_[i].data.get() + chunks_[i].size;
+    return {begin, static_cast<std::size_t>(end - begin)};
+  }
+
+  /*!
+   * \brief copy the data to the end of a continuous buffer.
+   */
+  template <typename Buffer>
+  void append_to(Buffer &buffer) const {
+    auto offset = buffer.size();
+    detail::resize(buffer, offset + size());
+    auto dst = (char *)buffer.data() + offset;
+    for (std::size_t i = 0; i < chunk_count(); ++i) {
+      auto data = chunk(i);
+      std::memcpy(dst, data.data(), data.size());
+      dst += data.size();
+    }
+  }
+
+  void clear() noexcept {
+    current_ = 0;
+    committed_ = 0;
+    front_ = 0;
+    if (chunks_.empty()) {
+      pos_ = end_ = nullptr;
+    }
+    else {
+      pos_ = chunks_[0].data.get();
+      end_ = pos_ + chunks_[0].capacity;
+    }
+  }
+
+  /*!
+   * \brief reserve len bytes at the front of an empty buffer, which could be
+   * filled by write_front later. The reserved bytes are not part of the data.
+   */
+  void reserve_front(std::size_t len) {
+    assert(empty() && current_ == 0);
+    if (chunks_.empty() || chunks_[0].capacity < len) {
+      use_chunk(len);
+    }
+    pos_ = chunks_[0].data.get() + len;
+    front_ = len;
+  }
+  /*!
+   * \brief write the data just before the data written, in the space reserved
+   * by reserve_front.
+   */
+  void write_front(const char *data, std::size_t len) noexcept {
+    assert(len <= front_);
+    front_ -= len;
+    std::memcpy(chunks_[0].data.get() + front_, data, len);
+  }
+
+ private:
+  friend class detail::single_pass_writer;
+
+  void write_slow(const char *data, std::size_t len) {
+    if (pos_ != nullptr) {
+      auto rest = static_cast<std::size_t>(end_ - pos_);
+      std::memcpy(pos_, data, rest);
+      data += rest;
+      len -= rest;
+      auto &c = chunks_[current_];
+      c.size = c.capacity;
+      committed_ += c.size;
+      ++current_;
+    }
+    use_chunk(len);
+    std::memcpy(pos_, data, len);
+    pos_ += len;
+  }
+
+  // End the current chunk at the position and use the next one, which has at
+  // least min_capacity bytes.
+  void next_chunk(std::size_t min_capacity) {
+    auto &c = chunks_[current_];
+    c.size = static_cast<std::size_t>(pos_ - c.data.get());
+    committed_ += c.size;
+    ++current_;
+    use_chunk(min_capacity);
+  }
+
+  void use_chunk(std::size_t min_capacity) {
+    if (current_ == chunks_.size() || chunks_[current_].capacity < min_capacity) {
+      auto capacity = (std::max)(chunk_size_, min_capacity);
+      chunk_storage c{std::unique_ptr<char[]>(new char[capacity]), capacity, 0};
+      if (current_ == chunks_.size()) {
+        chunks_.push_back(std::move(c));
+      }
+      else {
+        chunks_[current_] = std::move(c);
+      }
+    }
+    pos_ = chunks_[current_].data.get();
+    end_ = pos_ + chunks_[current_].capacity;
+  }
+
+  std::vector<chunk_storage> chunks_;
+  std::size_t current_ = 0;
+  std::size_t committed_ = 0;
+  std::size_t front_ = 0;
+  std::size_t chunk_size_;
+  char *pos_ = nullptr;
+  char *end_ = nullptr;
+};
+
+namespace detail {
+// The writer of the single pass serialization, which serializes the payload
+// with a guessed width of container length and finds the max length.
+class single_pass_writer {
+ public:
+  single_pass_writer(chunked_buffer &buffer, std::size_t max_length,
+                     std::size_t width) noexcept
+      : buffer_(buffer),
+        pos_(buffer.pos_),
+        end_(buffer.end_),
+        max_length_(max_length),
+        width_(width) {}
+  // The data written after an overflow is discarded by the retry.
+  STRUCT_PACK_INLINE void write(const char *data, std::size_t len) {
+    if SP_LIKELY (static_cast<std::size_t>(end_ - pos_) >= len) {
+      std::memcpy(pos_, data, len);
+      pos_ += len;
+    }
+    else {
+      write_slow(data, len);
+    }
+  }
+  STRUCT_PACK_INLINE void check_container_length(std::size_t size) noexcept {
+    if SP_UNLIKELY (size > max_length_) {
+      overflow_ = true;
+    }
+    max_seen_ = (std::max)(max_seen_, size);
+  }
+  // The bounds are checked once for an element of a container, nothing is
+  // written after an overflow.
+  STRUCT_PACK_INLINE char *reserve(const size_info &size) {
+    check_container_length(size.max_size);
+    if SP_UNLIKELY (overflow_) {
+      return nullptr;
+    }
+    auto len = size.total + size.size_cnt * width_;
+    if SP_UNLIKELY (static_cast<std::size_t>(end_ - pos_) < len) {
+      buffer_.pos_ = pos_;
+      buffer_.next_chunk(len);
+      pos_ = buffer_.pos_;
+      end_ = buffer_.end_;
+    }
+    return std::exchange(pos_, pos_ + len);
+  }
+  // Give the position back to the buffer.
+  void flush() noexcept { buffer_.pos_ = pos_; }
+  bool overflow() const noexcept { return overflow_; }
+  std::size_t max_seen() const noexcept { return max_seen_; }
+
+ private:
+  void write_slow(const char *data, std::size_t len) {
+    buffer_.pos_ = pos_;
+    buffer_.write_slow(data, len);
+    pos_ = buffer_.pos_;
+    end_ = buffer_.end_;
+  }
+
+  chunked_buffer &buffer_;
+  char *pos_;
+  char *end_;
+  std::size_t max_length_;
+  std::size_t width_;
+  std::size_t max_seen_ = 0;
+  bool overflow_ = false;
+};
+
+template <typename T>
+STRUCT_PACK_INLINE std::size_t top_level_container_length(const T &t) {
+  if constexpr (container<T>) {
+    return t.size();
+  }
+  else {
+    return 0;
+  }
+}
+
+// The length of the containers which are visible without traversal, it's
+// used to guess the width of container length.
+template <typename T>
+STRUCT_PACK_INLINE std::size_t top_level_length(const T &t) {
+  if constexpr (get_type_id<T>() == type_id::struct_t) {
+    return visit_members(t, [](const auto &...items) {
+      return (std::max)({std::size_t{0}, top_level_container_length(items)...});
+    });
+  }
+  else {
+    return top_level_container_length(t);
+  }
+}
+
+template <uint64_t conf, typename... Args>
+constexpr std::size_t max_metainfo_size() {
+  using Type = get_args_type<Args...>;
+  // hash code, metainfo and the length of compatible data.
+  std::size_t ret = sizeof(uint32_t) + 1 + sizeof(uint64_t);
+  if constexpr (check_if_add_type_literal<conf, Type>()) {
+    ret += struct_pack::get_type_literal<Args...>().size() + 1;
+  }
+  return ret;
+}
+
+inline constexpr std::size_t max_container_length(
+    const serialize_buffer_size &info) {
+  switch ((info.metainfo() & 0b11000) >> 3) {
+    case 0:
+      return UINT8_MAX;
+    case 1:
+      return UINT16_MAX;
+    case 2:
+      return UINT32_MAX;
+    default:
+      return SIZE_MAX;
+  }
+}
+
+// Serialize the objects in one pass: the payload is written to the chunked
+// buffer with the width of container length guessed from the top level
+// containers, and the metainfo is back-patched in front of it. If a longer
+// container is found, serialize again with the right width.
+template <uint64_t conf, typename... Args>
+void single_pass_serialize_to(chunked_buffer &buffer, const Args &...args) {
+  using Type = get_args_type<Args...>;
+  constexpr auto metainfo_size = max_metainfo_size<conf, Args...>();
+  std::size_t max_length = (std::max)({top_level_length(args)...});
+  while (true) {
+    buffer.clear();
+    buffer.reserve_front(metainfo_size);
+    auto info = get_serialize_runtime_info_by_payload<conf, Args...>(
+        size_info{0, 0, max_length});
+    auto width = std::size_t{1} << ((info.metainfo() & 0b11000) >> 3);
+    single_pass_writer writer{buffer, max_container_length(info), width};
+    visit_size_type(info, [&](auto size_type) {
+      packer<single_pass_writer, Type> o(writer, info);
+      o.template serialize_payload<decltype(size_type)::value>(args...);
+    });
+    writer.flush();
+    if SP_UNLIKELY (writer.overflow()) {
+      max_length = writer.max_seen();
+      continue;
+    }
+    auto final_info = get_serialize_runtime_info_by_payload<conf, Args...>(
+        size_info{buffer.size(), 0, writer.max_seen()});
+    if SP_UNLIKELY (max_container_length(final_info) !=
+                    max_container_length(info)) {
+      max_length = writer.max_seen();
+      continue;
+    }
+    info = final_info;
+    char metainfo[metainfo_size];
+    memory_writer metainfo_writer{metainfo};
+    visit_size_type(info, [&](auto size_type) {
+      packer<memory_writer, Type> o(metainfo_writer, info);
+      o.template serialize_metainfo<conf, decltype(size_type)::value == 1,
+                                    Args...>();
+    });
+    buffer.write_front(metainfo,
+                       static_cast<std::size_t>(metainfo_writer.buffer - metainfo));
+    assert(buffer.size() == info.size());
+    return;
+  }
+}
+}  // namespace detail
+}  // namespace struct_pack
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+#include "reflection.hpp"
+
+namespace struct_pack {
+/*!
+ * \ingroup struct_pack
+ * \class column_view
+ * \brief
+ * column_view<T> is a view of a column of trivial values in the buffer, which
+ * is returned by struct_pack::get_column_view. It refers to the buffer, so the
+ * buffer should outlive it.
+ *
+ * For example:
+ *
+ * ```cpp
+ * struct point {
+ *   float x, y, z;
+ *   static constexpr auto struct_pack_config =
+ *       struct_pack::ENCODING_WITH_COLUMNAR;
+ * };
+ * std::vector<point> points = ...;
+ * auto buffer = struct_pack::serialize(points);
+ * auto ys = struct_pack::get_column_view<std::vector<point>, 1>(buffer);
+ * float sum = 0;
+ * for (float y : ys.value()) {
+ *   sum += y;
+ * }
+ * ```
+ */
+template <typename T>
+class column_view {
+ public:
+  using value_type = T;
+
+  column_view() = default;
+  column_view(const T* data, std::size_t size) : data_(data), size_(size) {}
+
+  const T* data() const noexcept { return data_; }
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+
+  const T& operator[](std::size_t i) const {
+    assert(i < size_);
+    return data_[i];
+  }
+  const T* begin() const noexcept { return data_; }
+  const T* end() const noexcept { return data_ + size_; }
+
+ private:
+  const T* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+}  // namespace struct_pack
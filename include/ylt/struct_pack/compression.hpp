@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "endian_wrapper.hpp"
+#include "marco.h"
+#include "reflection.hpp"
+#include "varint.hpp"
+
+namespace struct_pack {
+namespace detail {
+// A self-contained block codec in the LZ4 block format: a sequence is a token
+// (4 bits of literal length and 4 bits of match length), the literals, a
+// 2-byte little-endian offset and the extra bytes of the match length. The
+// last sequence only has literals.
+constexpr std::size_t lz_min_match = 4;
+// the last match must start at least 12 bytes before the end of block, and
+// the last 5 bytes are always literals.
+constexpr std::size_t lz_match_start_limit = 12;
+constexpr std::size_t lz_last_literals = 5;
+constexpr std::size_t lz_max_offset = 65535;
+constexpr std::size_t lz_hash_log = 12;
+
+[[nodiscard]] constexpr std::size_t lz_compress_bound(std::size_t size) {
+  return size + size / 255 + 16;
+}
+
+STRUCT_PACK_INLINE uint32_t lz_hash(uint32_t seq) {
+  return (seq * 2654435761u) >> (32 - lz_hash_log);
+}
+
+STRUCT_PACK_INLINE char *lz_write_length(char *op, std::size_t len) {
+  for (; len >= 255; len -= 255) {
+    *op++ = (char)255;
+  }
+  *op++ = (char)len;
+  return op;
+}
+
+STRUCT_PACK_INLINE char *lz_write_sequence(char *op, const char *literals,
+                                           std::size_t literal_len,
+                                           std::size_t offset,
+                                           std::size_t match_len) {
+  char *token = op++;
+  *token = (char)((literal_len >= 15 ? 15 : literal_len) << 4);
+  if (literal_len >= 15) {
+    op = lz_write_length(op, literal_len - 15);
+  }
+  memcpy(op, literals, literal_len);
+  op += literal_len;
+  if (match_len == 0) {
+    return op;
+  }
+  *op++ = (char)(offset & 0xff);
+  *op++ = (char)(offset >> 8);
+  match_len -= lz_min_match;
+  *token |= (char)(match_len >= 15 ? 15 : match_len);
+  if (match_len >= 15) {
+    op = lz_write_length(op, match_len - 15);
+  }
+  return op;
+}
+
+// the count of the same bytes of a and b, a_limit is the end of a.
+STRUCT_PACK_INLINE std::size_t lz_match_length(const char *a, const char *b,
+                                               const char *a_limit) {
+  const char *start = a;
+  while (a + 8 <= a_limit) {
+    uint64_t diff = load_u64(a) ^ load_u64(b);
+    if (diff) {
+      return a - start + countr_zero_u64(diff) / 8;
+    }
+    a += 8;
+    b += 8;
+  }
+  while (a < a_limit && *a == *b) {
+    ++a;
+    ++b;
+  }
+  return a - start;
+}
+
+// Compress size bytes of src into dst, which should have at least
+// lz_compress_bound(size) bytes. Return the size of the compressed data.
+[[nodiscard]] inline std::size_t lz_compress(const char *src, std::size_t size,
+                                             char *dst) {
+  char *op = dst;
+  std::size_t anchor = 0;
+  if (size > lz_match_start_limit) {
+    uint32_t table[1 << lz_hash_log] = {};
+    const std::size_t limit = size - lz_match_start_limit;
+    const std::size_t match_limit = size - lz_last_literals;
+    std::size_t ip = 1;
+    while (ip < limit) {
+      uint32_t seq = (uint32_t)load_u64(src + ip);
+      uint32_t &slot = table[lz_hash(seq)];
+      std::size_t candidate = slot;
+      slot = (uint32_t)ip;
+      if (candidate >= ip || ip - candidate > lz_max_offset ||
+          (uint32_t)load_u64(src + candidate) != seq) {
+        // skip faster in the data which can't be compressed.
+        ip += 1 + ((ip - anchor) >> 6);
+        continue;
+      }
+      while (ip > anchor && candidate > 0 &&
+             src[ip - 1] == src[candidate - 1]) {
+        --ip;
+        --candidate;
+      }
+      std::size_t len =
+          lz_min_match + lz_match_length(src + ip + lz_min_match,
+                                         src + candidate + lz_min_match,
+                                         src + match_limit);
+      op = lz_write_sequence(op, src + anchor, ip - anchor, ip - candidate,
+                             len);
+      ip += len;
+      anchor = ip;
+      if (ip - 2 < limit) {
+        table[lz_hash((uint32_t)load_u64(src + ip - 2))] = (uint32_t)(ip - 2);
+      }
+    }
+  }
+  op = lz_write_sequence(op, src + anchor, size - anchor, 0, 0);
+  return op - dst;
+}
+
+STRUCT_PACK_INLINE bool lz_read_length(const char *&ip, const char *end,
+                                       std::size_t &len) {
+  unsigned char b;
+  do {
+    if SP_UNLIKELY (ip == end) {
+      return false;
+    }
+    b = (unsigned char)*ip++;
+    len += b;
+  } while (b == 255);
+  return true;
+}
+
+// Decompress the block into dst which has exactly raw_size bytes, return false
+// if the block is corrupted.
+[[nodiscard]] inline bool lz_decompress(const char *src, std::size_t size,
+                                        char *dst, std::size_t raw_size) {
+  const char *ip = src, *end = src + size;
+  char *op = dst, *op_end = dst + raw_size;
+  while (true) {
+    if SP_UNLIKELY (ip == end) {
+      return false;
+    }
+    unsigned char token = (unsigned char)*ip++;
+    std::size_t literal_len = token >> 4;
+    if (literal_len == 15 && !lz_read_length(ip, end, literal_len)) {
+      return false;
+    }
+    if SP_UNLIKELY (literal_len > (std::size_t)(end - ip) ||
+                    literal_len > (std::size_t)(op_end - op)) {
+      return false;
+    }
+    memcpy(op, ip, literal_len);
+    ip += literal_len;
+    op += literal_len;
+    if (ip == end) {
+      return op == op_end;
+    }
+    if SP_UNLIKELY (end - ip < 2) {
+      return false;
+    }
+    std::size_t offset =
+        (unsigned char)ip[0] | ((std::size_t)(unsigned char)ip[1] << 8);
+    ip += 2;
+    if SP_UNLIKELY (offset == 0 || offset > (std::size_t)(op - dst)) {
+      return false;
+    }
+    std::size_t match_len = token & 15;
+    if (match_len == 15 && !lz_read_length(ip, end, match_len)) {
+      return false;
+    }
+    match_len += lz_min_match;
+    if SP_UNLIKELY (match_len > (std::size_t)(op_end - op)) {
+      return false;
+    }
+    const char *match = op - offset;
+    if (offset >= match_len) {
+      memcpy(op, match, match_len);
+      op += match_len;
+    }
+    else {
+      // the match overlaps the output, copy the repeated pattern.
+      for (std::size_t i = 0; i < match_len; ++i) {
+        *op++ = match[i];
+      }
+    }
+  }
+}
+
+// The header of each block: the size of raw data and the size of stored data.
+// A block is stored as raw data if it can't be compressed.
+constexpr std::size_t compressed_block_header_size = 2 * sizeof(uint32_t);
+}  // namespace detail
+
+constexpr std::size_t default_compressed_block_size = 64 * 1024;
+
+/*!
+ * \ingroup struct_pack
+ * \brief a writer which compresses the data in blocks before they are written
+ * into the underlying writer, so the data is compressed while serializing:
+ *
+ * ```cpp
+ * std::ofstream ofs("data.bin", std::ios::binary);
+ * struct_pack::compressed_writer writer{ofs};
+ * struct_pack::serialize_to(writer, person);
+ * writer.flush();
+ * ```
+ *
+ * The data is written in frames of [raw size][stored size][block]. Call
+ * flush() to write the last block after serialization. The blocks are
+ * compressed in the LZ4 block format by a codec in struct_pack, so the
+ * block_size should not be larger than 64KB for a better compression ratio.
+ */
+template <typename Writer>
+class compressed_writer {
+  static_assert(writer_t<Writer>, "The Writer must satisfy writer_t.");
+
+ public:
+  explicit compressed_writer(
+      Writer &writer,
+      std::size_t block_size = default_compressed_block_size)
+      : writer_(writer),
+        block_(block_size ? block_size : default_compressed_block_size, '\0'),
+        compressed_(detail::lz_compress_bound(block_.size()), '\0') {}
+
+  compressed_writer(const compressed_writer &) = delete;
+  compressed_writer &operator=(const compressed_writer &) = delete;
+
+  void write(const char *data, std::size_t len) {
+    while (len > 0) {
+      std::size_t n = (std::min)(len, block_.size() - size_);
+      memcpy(block_.data() + size_, data, n);
+      size_ += n;
+      data += n;
+      len -= n;
+      if (size_ == block_.size()) {
+        write_block();
+      }
+    }
+  }
+
+  // Write the data buffered in the current block.
+  void flush() {
+    if (size_ > 0) {
+      write_block();
+    }
+  }
+
+  std::size_t block_size() const noexcept { return block_.size(); }
+
+ private:
+  void write_block() {
+    std::size_t len =
+        detail::lz_compress(block_.data(), size_, compressed_.data());
+    uint32_t header[2] = {(uint32_t)size_, (uint32_t)len};
+    const char *stored = compressed_.data();
+    if (len >= size_) {
+      header[1] = (uint32_t)size_;
+      stored = block_.data();
+    }
+    detail::write_wrapper<sizeof(uint32_t)>(writer_, (char *)&header[0]);
+    detail::write_wrapper<sizeof(uint32_t)>(writer_, (char *)&header[1]);
+    writer_.write(stored, header[1]);
+    size_ = 0;
+  }
+
+  Writer &writer_;
+  std::string block_;
+  std::string compressed_;
+  std::size_t size_ = 0;
+};
+
+/*!
+ * \ingroup struct_pack
+ * \brief a reader which decompresses the blocks written by compressed_writer
+ * lazily, a block is decompressed only when the unpacker reads it:
+ *
+ * ```cpp
+ * std::ifstream ifs("data.bin", std::ios::binary);
+ * struct_pack::compressed_reader reader{ifs};
+ * auto person = struct_pack::deserialize<person>(reader);
+ * ```
+ *
+ * The reader returns false when the block is corrupted or larger than
+ * max_block_size.
+ */
+template <typename Reader>
+class compressed_reader {
+  static_assert(reader_t<Reader>, "The Reader must satisfy reader_t.");
+
+ public:
+  explicit compressed_reader(
+      Reader &reader,
+      std::size_t max_block_size = 64 * default_compressed_block_size)
+      : reader_(reader), max_block_size_(max_block_size) {}
+
+  compressed_reader(const compressed_reader &) = delete;
+  compressed_reader &operator=(const compressed_reader &) = delete;
+
+  bool read(char *data, std::size_t len) {
+    while (len > 0) {
+      if (pos_ == block_.size() && !read_block()) {
+        return false;
+      }
+      std::size_t n = (std::min)(len, block_.size() - pos_);
+      memcpy(data, block_.data() + pos_, n);
+      pos_ += n;
+      consumed_ += n;
+      data += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  bool ignore(std::size_t len) {
+    while (len > 0) {
+      if (pos_ == block_.size() && !read_block()) {
+        return false;
+      }
+      std::size_t n = (std::min)(len, block_.size() - pos_);
+      pos_ += n;
+      consumed_ += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  // the count of the decompressed bytes which have been read.
+  std::size_t tellg() const noexcept { return consumed_; }
+
+ private:
+  bool read_block() {
+    uint32_t raw_size, stored_size;
+    if (!detail::read_wrapper<sizeof(uint32_t)>(reader_, (char *)&raw_size) ||
+        !detail::read_wrapper<sizeof(uint32_t)>(reader_,
+                                                (char *)&stored_size)) {
+      return false;
+    }
+    if SP_UNLIKELY (raw_size == 0 || raw_size > max_block_size_ ||
+                    stored_size > raw_size) {
+      return false;
+    }
+    block_.resize(raw_size);
+    pos_ = 0;
+    if (stored_size == raw_size) {
+      if (!reader_.read(block_.data(), raw_size)) {
+        block_.clear();
+        return false;
+      }
+      return true;
+    }
+    compressed_.resize(stored_size);
+    if (!reader_.read(compressed_.data(), stored_size) ||
+        !detail::lz_decompress(compressed_.data(), stored_size, block_.data(),
+                               raw_size)) {
+      block_.clear();
+      return false;
+    }
+    return true;
+  }
+
+  Reader &reader_;
+  std::size_t max_block_size_;
+  std::string block_;
+  std::string compressed_;
+  std::size_t pos_ = 0;
+  std::size_t consumed_ = 0;
+};
+}  // namespace struct_pack
@@ -17,6 +17,7 @@
 #include <bit>
 #include <cstdint>
 #include <type_traits>
+#include <utility>
 
 #include "reflection.hpp"
 #include "ylt/struct_pack/error_code.hpp"
@@ -235,6 +236,22 @@ STRUCT_PACK_INLINE bool read_bytes_array(reader_t& reader,
                                          std::size_t length) {
   return static_cast<bool>(reader.read(data, length));
 }
+template <std::size_t... I>
+STRUCT_PACK_INLINE void copy_words(char* SP_RESTRICT dst,
+                                   const char* SP_RESTRICT src,
+                                   std::index_sequence<I...>) {
+  (memcpy(dst + I * 8, src + I * 8, 8), ...);
+}
+// Copy a few dozen bytes of a known size by 8-byte words. A memcpy of such a
+// size may be compiled to `rep movs`, whose startup costs more than the copy.
+template <std::size_t size>
+STRUCT_PACK_INLINE void copy_bytes(char* SP_RESTRICT dst,
+                                   const char* SP_RESTRICT src) {
+  copy_words(dst, src, std::make_index_sequence<size / 8>{});
+  if constexpr (size % 8 != 0) {
+    memcpy(dst + size / 8 * 8, src + size / 8 * 8, size % 8);
+  }
+}
 template <std::size_t block_size, typename reader_t, typename T>
 STRUCT_PACK_INLINE bool low_bytes_read_wrapper(reader_t& reader, T& elem) {
   static_assert(sizeof(T) >= block_size);
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "marco.h"
+
+namespace struct_pack {
+/*!
+ * \ingroup struct_pack
+ * \brief a read-only memory mapping of a file.
+ *
+ * The file is not read when it's opened, the pages are loaded by the page
+ * faults when they are accessed. mmap_file has data() and size(), so it can be
+ * passed to deserialize/get_field/get_view directly. If the object is
+ * deserialized into view types, such as std::string_view, std::span,
+ * trivial_view and struct_pack::view, nothing is copied and only the touched
+ * pages are loaded:
+ *
+ * ```cpp
+ * struct snapshot {
+ *   std::string_view name;
+ *   std::span<const int> values;
+ * };
+ * struct_pack::mmap_file file;
+ * if (auto ec = file.open("snapshot.data"); ec) {
+ *   // handle error
+ * }
+ * auto result = struct_pack::deserialize<snapshot>(file);
+ * ```
+ *
+ * The views point to the mapped memory, so the file should outlive them.
+ */
+class mmap_file {
+ public:
+  mmap_file() = default;
+  mmap_file(const mmap_file &) = delete;
+  mmap_file &operator=(const mmap_file &) = delete;
+  mmap_file(mmap_file &&other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        is_open_(std::exchange(other.is_open_, false)) {}
+  mmap_file &operator=(mmap_file &&other) noexcept {
+    if (this != &other) {
+      close();
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      is_open_ = std::exchange(other.is_open_, false);
+    }
+    return *this;
+  }
+  ~mmap_file() { close(); }
+
+  /*!
+   * \brief map the whole file, the file which is opened before is closed.
+   * @return the system error if the file can't be mapped.
+   */
+  std::error_code open(const std::string &path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      return last_error();
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+      auto ec = last_error();
+      CloseHandle(file);
+      return ec;
+    }
+    if (size.QuadPart > 0) {
+      HANDLE mapping =
+          CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping == nullptr) {
+        auto ec = last_error();
+        CloseHandle(file);
+        return ec;
+      }
+      auto data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      auto ec = data ? std::error_code{} : last_error();
+      CloseHandle(mapping);
+      CloseHandle(file);
+      if (ec) {
+        return ec;
+      }
+      data_ = static_cast<const char *>(data);
+      size_ = static_cast<std::size_t>(size.QuadPart);
+    }
+    else {
+      CloseHandle(file);
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return last_error();
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      auto ec = last_error();
+      ::close(fd);
+      return ec;
+    }
+    // mmap doesn't accept an empty range, an empty file has no data.
+    if (st.st_size > 0) {
+      auto data = ::mmap(nullptr, static_cast<std::size_t>(st.st_size),
+                         PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        auto ec = last_error();
+        ::close(fd);
+        return ec;
+      }
+      data_ = static_cast<const char *>(data);
+      size_ = static_cast<std::size_t>(st.st_size);
+    }
+    ::close(fd);
+#endif
+    is_open_ = true;
+    return {};
+  }
+
+  void close() noexcept {
+    if (data_ != nullptr) {
+#ifdef _WIN32
+      UnmapViewOfFile(data_);
+#else
+      ::munmap(const_cast<char *>(data_), size_);
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+    is_open_ = false;
+  }
+
+  /*!
+   * \brief hint the system that the data will be accessed sequentially, so
+   * the pages are read ahead. It's a no-op if not supported.
+   */
+  void advise_sequential() const noexcept {
+#if !defined(_WIN32) && defined(POSIX_MADV_SEQUENTIAL)
+    if (data_ != nullptr) {
+      ::posix_madvise(const_cast<char *>(data_), size_, POSIX_MADV_SEQUENTIAL);
+    }
+#endif
+  }
+
+  bool is_open() const noexcept { return is_open_; }
+  const char *data() const noexcept { return data_; }
+  std::size_t size() const noexcept { return size_; }
+  std::string_view view() const noexcept { return {data_, size_}; }
+
+ private:
+  static std::error_code last_error() noexcept {
+#ifdef _WIN32
+    return {static_cast<int>(GetLastError()), std::system_category()};
+#else
+    return {errno, std::system_category()};
+#endif
+  }
+
+  const char *data_ = nullptr;
+  std::size_t size_ = 0;
+  bool is_open_ = false;
+};
+
+/*!
+ * \ingroup struct_pack
+ * \brief a reader of a memory mapped file, which reads the objects serialized
+ * one after another.
+ *
+ * It supports read_view, so the objects can be deserialized into view types
+ * without copy:
+ *
+ * ```cpp
+ * struct_pack::mmap_reader reader;
+ * if (auto ec = reader.open("records.data"); ec) {
+ *   // handle error
+ * }
+ * record_view record;
+ * while (struct_pack::deserialize_to(record, reader) == struct_pack::errc{}) {
+ *   // ...
+ * }
+ * ```
+ */
+class mmap_reader {
+ public:
+  mmap_reader() = default;
+  explicit mmap_reader(mmap_file file) noexcept : file_(std::move(file)) {}
+  mmap_reader(mmap_reader &&) = default;
+  mmap_reader &operator=(mmap_reader &&) = default;
+
+  std::error_code open(const std::string &path) {
+    pos_ = 0;
+    return file_.open(path);
+  }
+
+  bool read(char *target, std::size_t len) {
+    if SP_UNLIKELY (file_.size() - pos_ < len) {
+      return false;
+    }
+    std::memcpy(target, file_.data() + pos_, len);
+    pos_ += len;
+    return true;
+  }
+  const char *read_view(std::size_t len) {
+    if SP_UNLIKELY (file_.size() - pos_ < len) {
+      return nullptr;
+    }
+    auto ret = file_.data() + pos_;
+    pos_ += len;
+    return ret;
+  }
+  bool check(std::size_t len) const noexcept {
+    return file_.size() - pos_ >= len;
+  }
+  bool ignore(std::size_t len) {
+    if SP_UNLIKELY (file_.size() - pos_ < len) {
+      return false;
+    }
+    pos_ += len;
+    return true;
+  }
+  std::size_t tellg() const noexcept { return pos_; }
+  bool seekg(std::size_t pos) noexcept {
+    if SP_UNLIKELY (pos > file_.size()) {
+      return false;
+    }
+    pos_ = pos;
+    return true;
+  }
+  bool eof() const noexcept { return pos_ == file_.size(); }
+
+  const mmap_file &file() const noexcept { return file_; }
+
+ private:
+  mmap_file file_;
+  std::size_t pos_ = 0;
+};
+}  // namespace struct_pack
@@ -17,6 +17,7 @@
 #include <bitset>
 #include <cstddef>
 #include <cstdint>
+#include <stdexcept>
 #include <type_traits>
 
 #include "calculate_size.hpp"
@@ -26,6 +27,35 @@
 #include "ylt/struct_pack/util.h"
 #include "ylt/struct_pack/varint.hpp"
 namespace struct_pack::detail {
+// A writer which has check_container_length(size) is told the length of every
+// container before it's written, so it can find the length which exceeds the
+// width chosen before serialization.
+template <typename T, typename = void>
+struct length_checked_writer_impl : std::false_type {};
+
+template <typename T>
+struct length_checked_writer_impl<
+    T, std::void_t<decltype(std::declval<T &>().check_container_length(
+           std::size_t{}))>> : std::true_type {};
+
+template <typename T>
+constexpr bool length_checked_writer = length_checked_writer_impl<T>::value;
+
+// A writer which has reserve(size) gives a continuous span for an element of
+// a container by its calculated size, so the element is written by a
+// memory_writer without checking the bounds for every member. It returns
+// nullptr if the element shouldn't be written.
+template <typename T, typename = void>
+struct span_writer_impl : std::false_type {};
+
+template <typename T>
+struct span_writer_impl<T, std::void_t<decltype(std::declval<T &>().reserve(
+                               std::declval<const size_info &>()))>>
+    : std::true_type {};
+
+template <typename T>
+constexpr bool span_writer = span_writer_impl<T>::value;
+
 template <
 #if __cpp_concepts >= 201907L
     writer_t writer,
@@ -68,6 +98,13 @@ class packer {
   template <uint64_t conf, std::size_t size_type, typename T, typename... Args>
   STRUCT_PACK_INLINE void serialize(const T &t, const Args &...args) {
     serialize_metainfo<conf, size_type == 1, T, Args...>();
+    serialize_payload<size_type>(t, args...);
+  }
+
+  // Serialize the objects without metainfo, which could be written later if
+  // it's not known before serialization.
+  template <std::size_t size_type, typename T, typename... Args>
+  STRUCT_PACK_INLINE void serialize_payload(const T &t, const Args &...args) {
     serialize_many<size_type, UINT64_MAX>(t, args...);
     using Type = get_args_type<T, Args...>;
     if constexpr (serialize_static_config<Type>::has_compatible) {
@@ -77,6 +114,22 @@ class packer {
     }
   }
 
+  // Serialize the container `t` in parts: the metainfo and the length first,
+  // then the elements range by range.
+  template <uint64_t conf, std::size_t size_type, typename T>
+  STRUCT_PACK_INLINE void serialize_container_head(const T &t) {
+    static_assert(!serialize_static_config<T>::has_compatible);
+    serialize_metainfo<conf, size_type == 1, T>();
+    write_container_length<size_type>(t.size());
+  }
+
+  template <std::size_t size_type, typename Iterator>
+  STRUCT_PACK_INLINE void serialize_range(Iterator first, Iterator last) {
+    for (; first != last; ++first) {
+      serialize_one<size_type, UINT64_MAX>(*first);
+    }
+  }
+
   template <typename T, typename... Args>
   static constexpr uint32_t STRUCT_PACK_INLINE calculate_raw_hash() {
     if constexpr (sizeof...(Args) == 0) {
@@ -147,6 +200,49 @@ class packer {
       serialize_many<size_type, version, parent_tag>(items...);
     }
   }
+  template <std::size_t size_type, uint64_t version, typename T,
+            typename Tuple, std::size_t... I>
+  constexpr void STRUCT_PACK_INLINE
+  serialize_member_runs(const Tuple &members, std::index_sequence<I...>) {
+    (serialize_member_run<size_type, version, T, I>(members), ...);
+  }
+
+  template <std::size_t size_type, uint64_t version, typename T,
+            std::size_t I, typename Tuple>
+  constexpr void STRUCT_PACK_INLINE serialize_member_run(const Tuple &members) {
+    constexpr auto run = member_runs<T>[I];
+    constexpr uint64_t tag = get_parent_tag<T>();
+    if constexpr (run.length == 1) {
+      serialize_one<size_type, version, tag>(std::get<I>(members));
+    }
+    else if constexpr (run.length > 1) {
+      if SP_LIKELY (is_continuous_members<I>(
+                        members, std::make_index_sequence<run.length - 1>{})) {
+        if constexpr (std::is_same_v<writer, memory_writer>) {
+          copy_bytes<run.size>(writer_.buffer,
+                               (const char *)&std::get<I>(members));
+          writer_.buffer += run.size;
+        }
+        else {
+          write_bytes_array(writer_, (const char *)&std::get<I>(members),
+                            run.size);
+        }
+      }
+      else {
+        serialize_members_one_by_one<size_type, version, tag, I>(
+            members, std::make_index_sequence<run.length>{});
+      }
+    }
+  }
+
+  template <std::size_t size_type, uint64_t version, uint64_t parent_tag,
+            std::size_t Begin, typename Tuple, std::size_t... I>
+  constexpr void STRUCT_PACK_INLINE
+  serialize_members_one_by_one(const Tuple &members, std::index_sequence<I...>) {
+    (serialize_one<size_type, version, parent_tag>(std::get<Begin + I>(members)),
+     ...);
+  }
+
   constexpr void STRUCT_PACK_INLINE write_padding(std::size_t sz) {
     if (sz > 0) {
       constexpr char buf = 0;
@@ -154,6 +250,95 @@ class packer {
     }
   }
 
+  template <std::size_t size_type>
+  constexpr std::size_t STRUCT_PACK_INLINE container_length_width() {
+#ifdef STRUCT_PACK_OPTIMIZE
+    constexpr bool struct_pack_optimize = true;
+#else
+    constexpr bool struct_pack_optimize = false;
+#endif
+    if constexpr (size_type == 1 || force_optimize || struct_pack_optimize) {
+      return size_type;
+    }
+    else {
+      return std::size_t{1} << ((info_.metainfo() & 0b11000) >> 3);
+    }
+  }
+
+  template <typename Writer>
+  static void STRUCT_PACK_INLINE write_field_offset(Writer &out,
+                                                    std::size_t offset) {
+    if SP_UNLIKELY (offset > UINT32_MAX) {
+      throw std::out_of_range{
+          "struct_pack: the struct is too large to be encoded with a field "
+          "offset table."};
+    }
+    uint32_t end = offset;
+    write_wrapper<sizeof(uint32_t)>(out, (char *)&end);
+  }
+
+  // The writer can't seek back, so the end of every member is calculated
+  // before the members are written.
+  template <std::size_t size_type, uint64_t parent_tag, typename... Args>
+  constexpr void STRUCT_PACK_INLINE
+  serialize_field_offset_table(const Args &...items) {
+    const std::size_t width = container_length_width<size_type>();
+    std::size_t offset = 0;
+    auto f = [&](const auto &item) {
+      auto info = calculate_one_size<remove_cvref_t<decltype(item)>,
+                                     parent_tag>(item);
+      offset += info.total + info.size_cnt * width;
+      write_field_offset(writer_, offset);
+    };
+    (f(items), ...);
+  }
+
+  // The memory writer skips the table and fills it after every member is
+  // written, so the nested structs aren't walked once more for their sizes.
+  template <std::size_t size_type, uint64_t version, typename T,
+            typename... Args>
+  void STRUCT_PACK_INLINE
+  serialize_with_field_offset_table(const Args &...items) {
+    constexpr uint64_t tag = get_parent_tag<T>();
+    memory_writer table{writer_.buffer};
+    writer_.buffer += sizeof(uint32_t) * sizeof...(Args);
+    const char *begin = writer_.buffer;
+    auto f = [&](const auto &item) {
+      serialize_one<size_type, version, tag>(item);
+      write_field_offset(table,
+                         static_cast<std::size_t>(writer_.buffer - begin));
+    };
+    (f(items), ...);
+  }
+
+  template <std::size_t size_type, uint64_t version, std::size_t I,
+            typename T>
+  constexpr void STRUCT_PACK_INLINE serialize_column(const T &item) {
+    for (const auto &element : item) {
+      visit_members(element, [this](auto &&...items) CONSTEXPR_INLINE_LAMBDA {
+        constexpr uint64_t tag = get_parent_tag<typename T::value_type>();
+        serialize_one<size_type, version, tag>(
+            std::get<I>(std::forward_as_tuple(items...)));
+      });
+    }
+  }
+
+  template <std::size_t size_type, uint64_t version, typename T,
+            std::size_t... I>
+  constexpr void STRUCT_PACK_INLINE
+  serialize_columns(const T &item, std::index_sequence<I...>) {
+    using value_type = typename T::value_type;
+    constexpr uint64_t tag = get_parent_tag<value_type>();
+    static_assert(!is_enable_fast_varint_coding(tag) &&
+                      !is_enable_field_offset(tag),
+                  "ENCODING_WITH_COLUMNAR can't be used together with "
+                  "USE_FAST_VARINT or ENCODING_WITH_FIELD_OFFSET.");
+    static_assert(!exist_compatible_member<value_type>,
+                  "The struct encoded by columns can't have compatible "
+                  "member.");
+    (serialize_column<size_type, version, I>(item), ...);
+  }
+
   template <uint64_t parent_tag, std::size_t sz, typename Arg,
             typename unsigned_t, typename signed_t>
   static constexpr void STRUCT_PACK_INLINE
@@ -238,6 +423,63 @@ class packer {
     }
   }
 
+  template <std::size_t size_type>
+  constexpr void STRUCT_PACK_INLINE write_container_length(std::size_t size) {
+    if constexpr (length_checked_writer<writer>) {
+      writer_.check_container_length(size);
+    }
+    if constexpr (size_type == 1) {
+      low_bytes_write_wrapper<size_type>(writer_, size);
+    }
+    else {
+#ifdef STRUCT_PACK_OPTIMIZE
+      constexpr bool struct_pack_optimize = true;
+#else
+      constexpr bool struct_pack_optimize = false;
+#endif
+      if constexpr (force_optimize || struct_pack_optimize) {
+        if constexpr (size_type == 2) {
+          low_bytes_write_wrapper<size_type>(writer_, size);
+        }
+        else if constexpr (size_type == 4) {
+          low_bytes_write_wrapper<size_type>(writer_, size);
+        }
+        else if constexpr (size_type == 8) {
+          if constexpr (sizeof(std::size_t) >= 8) {
+            low_bytes_write_wrapper<size_type>(writer_, size);
+          }
+          else {
+            std::uint64_t sz = size;
+            low_bytes_write_wrapper<size_type>(writer_, sz);
+          }
+        }
+        else {
+          static_assert(!size_type, "illegal size_type.");
+        }
+      }
+      else {
+        switch ((info_.metainfo() & 0b11000) >> 3) {
+          case 1:
+            low_bytes_write_wrapper<2>(writer_, size);
+            break;
+          case 2:
+            low_bytes_write_wrapper<4>(writer_, size);
+            break;
+          case 3:
+            if constexpr (sizeof(std::size_t) >= 8) {
+              low_bytes_write_wrapper<8>(writer_, size);
+            }
+            else {
+              unreachable();
+            }
+            break;
+          default:
+            unreachable();
+        }
+      }
+    }
+  }
+
   template <std::size_t size_type, uint64_t version, uint64_t parent_tag = 0,
             typename T>
   constexpr void inline serialize_one(const T &item) {
@@ -306,58 +548,7 @@ class packer {
         }
       }
       else if constexpr (map_container<type> || container<type>) {
-        auto size = item.size();
-
-        if constexpr (size_type == 1) {
-          low_bytes_write_wrapper<size_type>(writer_, size);
-        }
-        else {
-#ifdef STRUCT_PACK_OPTIMIZE
-          constexpr bool struct_pack_optimize = true;
-#else
-          constexpr bool struct_pack_optimize = false;
-#endif
-          if constexpr (force_optimize || struct_pack_optimize) {
-            if constexpr (size_type == 2) {
-              low_bytes_write_wrapper<size_type>(writer_, size);
-            }
-            else if constexpr (size_type == 4) {
-              low_bytes_write_wrapper<size_type>(writer_, size);
-            }
-            else if constexpr (size_type == 8) {
-              if constexpr (sizeof(std::size_t) >= 8) {
-                low_bytes_write_wrapper<size_type>(writer_, size);
-              }
-              else {
-                std::uint64_t sz = size;
-                low_bytes_write_wrapper<size_type>(writer_, sz);
-              }
-            }
-            else {
-              static_assert(!sizeof(item), "illegal size_type.");
-            }
-          }
-          else {
-            switch ((info_.metainfo() & 0b11000) >> 3) {
-              case 1:
-                low_bytes_write_wrapper<2>(writer_, size);
-                break;
-              case 2:
-                low_bytes_write_wrapper<4>(writer_, size);
-                break;
-              case 3:
-                if constexpr (sizeof(std::size_t) >= 8) {
-                  low_bytes_write_wrapper<8>(writer_, size);
-                }
-                else {
-                  unreachable();
-                }
-                break;
-              default:
-                unreachable();
-            }
-          }
-        }
+        write_container_length<size_type>(item.size());
         if constexpr (trivially_copyable_container<type> &&
                       is_little_endian_copyable<sizeof(
                           typename type::value_type)>) {
@@ -366,6 +557,26 @@ class packer {
                             item.size() * sizeof(typename type::value_type));
           return;
         }
+        else if constexpr (is_bulk_varint_container<type>()) {
+          serialize_varint_bulk(writer_, item.data(), item.size());
+        }
+        else if constexpr (columnar_container<type>()) {
+          serialize_columns<size_type, version>(
+              item, std::make_index_sequence<struct_pack::members_count<
+                        typename type::value_type>>{});
+        }
+        else if constexpr (span_writer<writer> &&
+                           !serialize_static_config<type>::has_compatible) {
+          for (const auto &i : item) {
+            auto span = writer_.reserve(calculate_one_size(i));
+            if SP_LIKELY (span != nullptr) {
+              memory_writer element_writer{span};
+              packer<memory_writer, serialize_type, force_optimize> o(
+                  element_writer, info_);
+              o.template serialize_one<size_type, version>(i);
+            }
+          }
+        }
         else {
           for (const auto &i : item) {
             serialize_one<size_type, version>(i);
@@ -436,19 +647,46 @@ class packer {
         }
         else {
           constexpr uint64_t tag = get_parent_tag<type>();
-          if constexpr (is_enable_fast_varint_coding(tag)) {
+          if constexpr (has_field_offset_table<type>()) {
+            static_assert(!is_enable_fast_varint_coding(tag),
+                          "ENCODING_WITH_FIELD_OFFSET can't be used together "
+                          "with USE_FAST_VARINT.");
+            static_assert(!exist_compatible_member<type>,
+                          "The struct encoded with field offset table can't "
+                          "have compatible member.");
+          }
+          if constexpr (has_field_offset_table<type>() &&
+                        std::is_same_v<writer, memory_writer>) {
             visit_members(
                 item, [this](auto &&...items) CONSTEXPR_INLINE_LAMBDA {
-                  constexpr uint64_t tag =
-                      get_parent_tag<type>();  // to pass msvc with c++17
-                  serialize_fast_varint<tag>(items...);
+                  serialize_with_field_offset_table<size_type, version, type>(
+                      items...);
+                });
+          }
+          else {
+            if constexpr (has_field_offset_table<type>()) {
+              visit_members(
+                  item, [this](auto &&...items) CONSTEXPR_INLINE_LAMBDA {
+                    constexpr uint64_t tag =
+                        get_parent_tag<type>();  // to pass msvc with c++17
+                    serialize_field_offset_table<size_type, tag>(items...);
+                  });
+            }
+            if constexpr (is_enable_fast_varint_coding(tag)) {
+              visit_members(
+                  item, [this](auto &&...items) CONSTEXPR_INLINE_LAMBDA {
+                    constexpr uint64_t tag =
+                        get_parent_tag<type>();  // to pass msvc with c++17
+                    serialize_fast_varint<tag>(items...);
+                  });
+            }
+            visit_members(
+                item, [this](auto &&...items) CONSTEXPR_INLINE_LAMBDA {
+                  serialize_member_runs<size_type, version, type>(
+                      std::forward_as_tuple(items...),
+                      std::make_index_sequence<sizeof...(items)>{});
                 });
           }
-          visit_members(item, [this](auto &&...items) CONSTEXPR_INLINE_LAMBDA {
-            constexpr uint64_t tag =
-                get_parent_tag<type>();  // to pass msvc with c++17
-            serialize_many<size_type, version, tag>(items...);
-          });
         }
       }
       else {
@@ -537,6 +775,41 @@ class packer {
   const serialize_buffer_size &info_;
 };
 
+// Call func with the size type of the serialization as an integral constant.
+template <typename Func>
+STRUCT_PACK_INLINE void visit_size_type(const serialize_buffer_size &info,
+                                        Func &&func) {
+  switch ((info.metainfo() & 0b11000) >> 3) {
+    case 0:
+      func(std::integral_constant<std::size_t, 1>{});
+      break;
+#ifdef STRUCT_PACK_OPTIMIZE
+    case 1:
+      func(std::integral_constant<std::size_t, 2>{});
+      break;
+    case 2:
+      func(std::integral_constant<std::size_t, 4>{});
+      break;
+    case 3:
+      if constexpr (sizeof(std::size_t) >= 8) {
+        func(std::integral_constant<std::size_t, 8>{});
+      }
+      else {
+        unreachable();
+      }
+      break;
+#else
+    case 1:
+    case 2:
+    case 3:
+      func(std::integral_constant<std::size_t, 2>{});
+      break;
+#endif
+    default:
+      unreachable();
+  }
+}
+
 template <uint64_t conf = sp_config::DEFAULT,
 #if __cpp_concepts >= 201907L
           struct_pack::writer_t Writer,
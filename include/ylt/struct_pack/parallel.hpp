@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "calculate_size.hpp"
+#include "packer.hpp"
+#include "reflection.hpp"
+#include "type_calculate.hpp"
+#include "util.h"
+#include "varint.hpp"
+
+namespace struct_pack {
+namespace detail {
+// Each task serializes the parts of the container one by one, there are more
+// parts than tasks so the work is balanced when the elements have different
+// sizes.
+constexpr std::size_t parallel_chunks_per_task = 4;
+
+// The container can be serialized in parallel if its elements are serialized
+// one by one and can be accessed randomly.
+template <typename T>
+constexpr bool is_parallel_serializable_container() {
+  if constexpr (container<T> && !map_container<T> && !set_container<T>) {
+    using category = typename std::iterator_traits<
+        typename T::const_iterator>::iterator_category;
+    return std::is_base_of_v<std::random_access_iterator_tag, category> &&
+           !trivially_copyable_container<T> && !is_bulk_varint_container<T>() &&
+           !columnar_container<T>() &&
+           !serialize_static_config<T>::has_compatible;
+  }
+  else {
+    return false;
+  }
+}
+
+template <typename Executor, typename = void>
+struct parallel_executor_impl : std::false_type {};
+
+template <typename Executor>
+struct parallel_executor_impl<
+    Executor, std::void_t<decltype(std::declval<Executor &>().schedule(
+                  std::declval<std::function<void()>>()))>> : std::true_type {
+};
+
+// An executor should schedule a std::function<void()> and return false if it
+// failed, such as async_simple::Executor.
+template <typename Executor>
+constexpr bool parallel_executor = parallel_executor_impl<Executor>::value;
+
+// Run the tasks by at most max_thread_count threads, which are started when
+// there is no idle thread for a task and joined when it's destroyed.
+class thread_executor {
+ public:
+  explicit thread_executor(std::size_t max_thread_count)
+      : max_thread_count_(max_thread_count) {}
+  thread_executor(const thread_executor &) = delete;
+  thread_executor &operator=(const thread_executor &) = delete;
+  ~thread_executor() {
+    {
+      std::lock_guard lock(mutex_);
+      stopped_ = true;
+    }
+    cv_.notify_all();
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+  }
+  bool schedule(std::function<void()> func) {
+    std::unique_lock lock(mutex_);
+    if (idle_count_ <= tasks_.size() && threads_.size() < max_thread_count_) {
+      try {
+        threads_.emplace_back([this] {
+          work();
+        });
+      } catch (...) {
+      }
+    }
+    if (threads_.empty()) {
+      return false;
+    }
+    tasks_.push_back(std::move(func));
+    lock.unlock();
+    cv_.notify_one();
+    return true;
+  }
+
+ private:
+  void work() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+      ++idle_count_;
+      cv_.wait(lock, [this] {
+        return stopped_ || !tasks_.empty();
+      });
+      --idle_count_;
+      if (tasks_.empty()) {
+        return;
+      }
+      auto task = std::move(tasks_.front());
+      tasks_.pop_front();
+      lock.unlock();
+      task();
+      lock.lock();
+    }
+  }
+
+  std::size_t max_thread_count_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  std::size_t idle_count_ = 0;
+  bool stopped_ = false;
+};
+
+// The parts shared by the tasks of parallel_for_each_chunk. The tasks own it
+// too, so a task which starts after all parts are done finds nothing to do
+// and never touches the caller's stack.
+class parallel_chunks {
+ public:
+  explicit parallel_chunks(std::size_t count) : count_(count) {}
+
+  // Take the next part until all of them are taken, the first exception thrown
+  // by func is rethrown by wait().
+  template <typename Func>
+  void run(const Func &func) {
+    for (auto chunk = next_.fetch_add(1, std::memory_order_relaxed);
+         chunk < count_;
+         chunk = next_.fetch_add(1, std::memory_order_relaxed)) {
+      std::exception_ptr error;
+      try {
+        func(chunk);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      std::lock_guard lock(mutex_);
+      if (error && !error_) {
+        error_ = std::move(error);
+      }
+      if (++done_ == count_) {
+        cv_.notify_all();
+      }
+    }
+  }
+
+  // Wait for the parts taken by the other tasks.
+  void wait() {
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, [this] {
+      return done_ == count_;
+    });
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+ private:
+  std::atomic<std::size_t> next_{0};
+  std::size_t count_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::size_t done_ = 0;
+  std::exception_ptr error_;
+};
+
+// Call func(i) for every part i by at most `parallelism` tasks, each of which
+// takes the next part until all of them are done. The caller is one of the
+// tasks, so it never waits for a task which isn't started, even if it's
+// running on a thread of the executor.
+template <typename Executor, typename Func>
+void parallel_for_each_chunk(Executor &executor, std::size_t parallelism,
+                             std::size_t chunk_count, const Func &func) {
+  auto chunks = std::make_shared<parallel_chunks>(chunk_count);
+  auto task_count = (std::min)(parallelism, chunk_count);
+  for (std::size_t i = 1; i < task_count; ++i) {
+    // the caller takes the parts of a task which can't be scheduled.
+    executor.schedule([chunks, func = &func] {
+      chunks->run(*func);
+    });
+  }
+  chunks->run(func);
+  chunks->wait();
+}
+
+// Serialize the container in parallel: calculate the size of each part of the
+// container, get the offset of each part by the prefix sum of the sizes, then
+// serialize the parts into the preallocated buffer at the same time. The
+// result is the same as the sequential serialization.
+template <uint64_t conf, typename Buffer, typename T, typename Executor>
+void parallel_serialize_to(Buffer &buffer, const T &t, Executor &executor,
+                           std::size_t parallelism) {
+  auto data_offset = buffer.size();
+  if constexpr (is_parallel_serializable_container<T>()) {
+    auto count = t.size();
+    auto chunk_count = (std::min)(
+        count, (std::max)(parallelism, std::size_t{1}) *
+                   parallel_chunks_per_task);
+    if (parallelism > 1 && chunk_count > 1) {
+      auto chunk_begin = [&t, count, chunk_count](std::size_t i) {
+        return t.begin() +
+               static_cast<std::ptrdiff_t>(count * i / chunk_count);
+      };
+      std::vector<size_info> sizes(chunk_count);
+      parallel_for_each_chunk(
+          executor, parallelism, chunk_count, [&](std::size_t i) {
+            size_info size{};
+            for (auto it = chunk_begin(i), end = chunk_begin(i + 1); it != end;
+                 ++it) {
+              size += calculate_one_size(*it);
+            }
+            sizes[i] = size;
+          });
+      // the container itself has a length.
+      size_info payload{0, 1, count};
+      for (auto &size : sizes) {
+        payload += size;
+      }
+      auto info = get_serialize_runtime_info_by_payload<conf, T>(payload);
+      auto width = std::size_t{1} << ((info.metainfo() & 0b11000) >> 3);
+      std::vector<std::size_t> offsets(chunk_count);
+      for (std::size_t i = 1; i < chunk_count; ++i) {
+        offsets[i] = offsets[i - 1] + sizes[i - 1].total +
+                     sizes[i - 1].size_cnt * width;
+      }
+      resize(buffer, data_offset + info.size());
+      visit_size_type(info, [&](auto size_type) {
+        constexpr std::size_t size_type_v = decltype(size_type)::value;
+        memory_writer writer{(char *)buffer.data() + data_offset};
+        packer<memory_writer, T> o(writer, info);
+        o.template serialize_container_head<conf, size_type_v>(t);
+        auto elements = writer.buffer;
+        parallel_for_each_chunk(
+            executor, parallelism, chunk_count, [&](std::size_t i) {
+              memory_writer writer{elements + offsets[i]};
+              packer<memory_writer, T> o(writer, info);
+              o.template serialize_range<size_type_v>(chunk_begin(i),
+                                                      chunk_begin(i + 1));
+            });
+      });
+      return;
+    }
+  }
+  auto info = get_serialize_runtime_info<conf>(t);
+  resize(buffer, data_offset + info.size());
+  memory_writer writer{(char *)buffer.data() + data_offset};
+  serialize_to<conf>(writer, info, t);
+}
+}  // namespace detail
+}  // namespace struct_pack
@@ -31,6 +31,10 @@
 #include <span>
 #endif
 
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+
 #include "derived_helper.hpp"
 #include "foreach_macro.h"
 #include "marco.h"
@@ -48,7 +52,9 @@ enum sp_config : uint64_t {
   ENABLE_TYPE_INFO = 0b10,
   DISABLE_ALL_META_INFO = 0b11,
   ENCODING_WITH_VARINT = 0b100,
-  USE_FAST_VARINT = 0b1000
+  USE_FAST_VARINT = 0b1000,
+  ENCODING_WITH_FIELD_OFFSET = 0b10000,
+  ENCODING_WITH_COLUMNAR = 0b100000
 };
 
 namespace detail {
@@ -890,7 +896,13 @@ struct memory_reader;
         else if constexpr (std::is_class_v<T>) {
           constexpr auto tag = get_parent_tag<T>();
           using U = decltype(get_types<T>());
-          return class_visit_helper<U , tag>(std::make_index_sequence<std::tuple_size_v<U>>{});
+          if constexpr (tag & struct_pack::ENCODING_WITH_COLUMNAR) {
+            // the containers of it should be encoded by columns
+            return false;
+          }
+          else {
+            return class_visit_helper<U , tag>(std::make_index_sequence<std::tuple_size_v<U>>{});
+          }
         }
         else
           return false;
@@ -900,9 +912,68 @@ struct memory_reader;
       static inline constexpr bool value = is_trivial_serializable::solve();
   };
 
+  constexpr inline bool is_enable_field_offset(uint64_t tag) {
+    return tag & struct_pack::ENCODING_WITH_FIELD_OFFSET;
+  }
+
+  // A non-trivial struct configured with ENCODING_WITH_FIELD_OFFSET is encoded
+  // with a table of the end offset of each member ahead of its members, so
+  // that a single member can be located without decoding the others.
+  template <typename T>
+  constexpr bool has_field_offset_table() {
+    if constexpr (std::is_class_v<T> && !is_trivial_serializable<T>::value &&
+                  !is_trivial_serializable<T, true>::value) {
+      return is_enable_field_offset(get_parent_tag<T>());
+    }
+    else {
+      return false;
+    }
+  }
+
+  constexpr inline bool is_enable_columnar(uint64_t tag) {
+    return tag & struct_pack::ENCODING_WITH_COLUMNAR;
+  }
+
+  // A sequence container of the struct configured with ENCODING_WITH_COLUMNAR
+  // is encoded by columns: the values of the first member of all elements,
+  // then the values of the second member, and so on.
+  template <typename T>
+  constexpr bool columnar_container() {
+    if constexpr (container<T> && !map_container<T> && !set_container<T>) {
+      using value_type = typename T::value_type;
+      if constexpr (std::is_class_v<value_type>) {
+        return is_enable_columnar(get_parent_tag<value_type>());
+      }
+      else {
+        return false;
+      }
+    }
+    else {
+      return false;
+    }
+  }
+
+#if __cpp_lib_memory_resource >= 201603L
+  template <typename T, typename = void>
+  struct pmr_container_impl : std::false_type {};
+
+  template <typename T>
+  struct pmr_container_impl<
+      T, std::void_t<typename T::allocator_type, typename T::value_type>>
+      : std::is_same<typename T::allocator_type,
+                     std::pmr::polymorphic_allocator<typename T::value_type>> {
+  };
+
+  // std::pmr::vector, std::pmr::string, std::pmr::map and so on.
+  template <typename T>
+  constexpr bool pmr_container = pmr_container_impl<T>::value;
+#endif
+
 }
 template <typename T, typename = std::enable_if_t<detail::is_trivial_serializable<T>::value>>
 struct trivial_view;
+template <typename T>
+class column_view;
 namespace detail {
 
 #if __cpp_concepts < 201907L
@@ -932,6 +1003,12 @@ constexpr bool trivially_copyable_container =
   template <typename Type>
   constexpr inline bool is_trivial_view_v<struct_pack::trivial_view<Type>> = true;
 
+  template <typename Type>
+  constexpr inline bool is_column_view_v = false;
+
+  template <typename Type>
+  constexpr inline bool is_column_view_v<struct_pack::column_view<Type>> = true;
+
   struct UniversalVectorType {
     template <typename T>
     operator std::vector<T>();
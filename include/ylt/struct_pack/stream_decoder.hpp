@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "error_code.hpp"
+#include "reflection.hpp"
+#include "type_calculate.hpp"
+#include "unpacker.hpp"
+
+namespace struct_pack {
+namespace detail {
+// A memory_reader which remembers the end of the failed read, so the decoder
+// knows how many bytes it needs at least to go further.
+struct stream_memory_reader : public memory_reader {
+  constexpr stream_memory_reader(const char *beg, const char *end) noexcept
+      : memory_reader(beg, end), begin(beg) {}
+  bool read(char *target, size_t len) {
+    return memory_reader::read(target, len) || need(len);
+  }
+  bool check(size_t len) { return memory_reader::check(len) || need(len); }
+  const char *read_view(size_t len) {
+    auto ret = memory_reader::read_view(len);
+    if SP_UNLIKELY (ret == nullptr) {
+      need(len);
+    }
+    return ret;
+  }
+  bool ignore(size_t len) { return memory_reader::ignore(len) || need(len); }
+  bool need(size_t len) {
+    needed = now - begin + len;
+    return false;
+  }
+  const char *begin;
+  std::size_t needed = 0;
+};
+}  // namespace detail
+
+/*!
+ * \ingroup struct_pack
+ * \brief a push-style decoder for the data serialized from std::vector<T>.
+ *
+ * The data can be fed in chunks of any size as it arrives. The decoder keeps
+ * its state across calls and passes each element to the callback as soon as
+ * it's complete. Only the bytes of the incomplete element are buffered, and an
+ * element which needs more than max_buffer_size bytes fails with
+ * errc::invalid_buffer, so the memory is bounded by the chunk size and
+ * max_buffer_size rather than the size of the whole data.
+ *
+ * An element which is still incomplete after a chunk is tried again only when
+ * the bytes of the read which failed have arrived, and the retry just walks
+ * over the buffered bytes without building the element, so a large element
+ * fed in small chunks is built once. Call finish after the last chunk to
+ * check that the data isn't truncated.
+ *
+ * For example:
+ * ```cpp
+ * struct_pack::stream_decoder<person> decoder;
+ * while (auto n = read(fd, buf, sizeof(buf))) {
+ *   auto ec = decoder.feed(buf, n, [](person &&p) {
+ *     // ...
+ *   });
+ *   if (ec != struct_pack::errc{}) {
+ *     // invalid data
+ *   }
+ * }
+ * auto ec = decoder.finish([](person &&p) {
+ *   // ...
+ * });
+ * assert(ec == struct_pack::errc{});
+ * ```
+ *
+ * T should not have compatible member, and the elements should not contain
+ * view types such as std::string_view, which refer to the internal buffer.
+ * @tparam T the element type of the serialized std::vector<T>
+ * @tparam conf the config used to serialize the data
+ */
+template <typename T, uint64_t conf = sp_config::DEFAULT>
+class stream_decoder {
+  static_assert(!detail::exist_compatible_member<T>,
+                "stream_decoder doesn't support the type which has compatible "
+                "member.");
+
+ public:
+  constexpr static std::size_t default_max_buffer_size = 64 * 1024 * 1024;
+
+  /*!
+   * @param max_buffer_size the max bytes which an element may take
+   */
+  explicit stream_decoder(
+      std::size_t max_buffer_size = default_max_buffer_size) noexcept
+      : max_buffer_size_(max_buffer_size) {}
+
+  /*!
+   * \brief feed the next chunk of data.
+   *
+   * on_element(T&&) is called for every element decoded from the data fed so
+   * far. Incomplete data is not an error, the decoder waits for the next chunk.
+   * @return errc::ok, or the error of invalid data. The error is kept and
+   * returned by the later calls until reset.
+   */
+  template <typename Func>
+  [[nodiscard]] struct_pack::errc feed(const char *data, std::size_t size,
+                                       Func &&on_element) {
+    if SP_UNLIKELY (state_ == state::failed) {
+      return error_;
+    }
+    if (state_ == state::finished) {
+      return size == 0 ? struct_pack::errc{} : fail(errc::invalid_buffer);
+    }
+    if (consumed_ > 0) {
+      buffer_.erase(0, consumed_);
+      consumed_ = 0;
+    }
+    buffer_.append(data, size);
+    if (buffered_size() < needed_size_) {
+      return struct_pack::errc{};
+    }
+    struct_pack::errc ec{};
+    if (state_ == state::header) {
+      ec = decode_header();
+    }
+    if (ec == struct_pack::errc{} && state_ == state::elements) {
+      ec = decode_elements(on_element);
+    }
+    if (ec == errc::no_buffer_space) {
+      // Don't decode the incomplete element again until there are enough
+      // bytes for the read which failed.
+      if SP_UNLIKELY (needed_size_ > max_buffer_size_) {
+        return fail(errc::invalid_buffer);
+      }
+      return struct_pack::errc{};
+    }
+    needed_size_ = 0;
+    if SP_UNLIKELY (ec != struct_pack::errc{}) {
+      return fail(ec);
+    }
+    if (state_ == state::finished && buffered_size() > 0) {
+      return fail(errc::invalid_buffer);
+    }
+    return struct_pack::errc{};
+  }
+
+#if __cpp_concepts >= 201907L
+  template <detail::deserialize_view View, typename Func>
+#else
+  template <typename View, typename Func,
+            typename = std::enable_if_t<detail::deserialize_view<View>>>
+#endif
+  [[nodiscard]] struct_pack::errc feed(const View &v, Func &&on_element) {
+    return feed((const char *)v.data(), v.size(),
+                std::forward<Func>(on_element));
+  }
+
+  /*!
+   * \brief check the data after the last chunk is fed.
+   *
+   * @return errc::ok if all the elements are decoded, errc::no_buffer_space
+   * if the data is truncated, or the error of invalid data.
+   */
+  template <typename Func>
+  [[nodiscard]] struct_pack::errc finish(Func &&on_element) {
+    auto ec = feed("", 0, on_element);
+    if (ec == struct_pack::errc{} && state_ != state::finished) {
+      return errc::no_buffer_space;
+    }
+    return ec;
+  }
+
+  /*!
+   * \brief whether all the elements have been decoded.
+   */
+  bool is_finished() const noexcept { return state_ == state::finished; }
+
+  /*!
+   * \brief the count of elements, which is known after the metainfo and the
+   * length of vector are decoded.
+   */
+  std::size_t size() const noexcept { return size_; }
+
+  /*!
+   * \brief the count of elements decoded.
+   */
+  std::size_t decoded_size() const noexcept { return decoded_size_; }
+
+  /*!
+   * \brief the bytes which have been fed but not decoded yet.
+   */
+  std::size_t buffered_size() const noexcept {
+    return buffer_.size() - consumed_;
+  }
+
+  void reset() {
+    buffer_.clear();
+    consumed_ = 0;
+    needed_size_ = 0;
+    incomplete_ = false;
+    state_ = state::header;
+    error_ = {};
+    size_type_ = 0;
+    size_ = 0;
+    decoded_size_ = 0;
+  }
+
+ private:
+  enum class state { header, elements, finished, failed };
+
+  struct_pack::errc fail(struct_pack::errc ec) {
+    state_ = state::failed;
+    error_ = ec;
+    return ec;
+  }
+
+  struct_pack::errc decode_header() {
+    detail::stream_memory_reader reader{buffer_.data() + consumed_,
+                                        buffer_.data() + buffer_.size()};
+    detail::unpacker<detail::stream_memory_reader, conf> in(reader);
+    auto ec = in.template deserialize_metainfo<std::vector<T>>().first;
+    if SP_UNLIKELY (ec != struct_pack::errc{}) {
+      needed_size_ = reader.needed;
+      return ec;
+    }
+    bool ok;
+    switch (in.size_type()) {
+      case 0:
+        ok = detail::low_bytes_read_wrapper<1>(reader, size_);
+        break;
+      case 1:
+        ok = detail::low_bytes_read_wrapper<2>(reader, size_);
+        break;
+      case 2:
+        ok = detail::low_bytes_read_wrapper<4>(reader, size_);
+        break;
+      case 3:
+        if constexpr (sizeof(std::size_t) >= 8) {
+          ok = detail::low_bytes_read_wrapper<8>(reader, size_);
+        }
+        else {
+          return errc::invalid_width_of_container_length;
+        }
+        break;
+      default:
+        detail::unreachable();
+    }
+    if SP_UNLIKELY (!ok) {
+      size_ = 0;
+      needed_size_ = reader.needed;
+      return errc::no_buffer_space;
+    }
+    size_type_ = in.size_type();
+    consumed_ = reader.now - buffer_.data();
+    state_ = size_ == 0 ? state::finished : state::elements;
+    return struct_pack::errc{};
+  }
+
+  template <typename Func>
+  struct_pack::errc decode_elements(Func &on_element) {
+    while (decoded_size_ < size_) {
+      T element{};
+      if (incomplete_) {
+        // only walk over the element which was incomplete, it's built when
+        // all of its bytes have arrived.
+        detail::stream_memory_reader reader{buffer_.data() + consumed_,
+                                            buffer_.data() + buffer_.size()};
+        detail::unpacker<detail::stream_memory_reader, conf> in(reader);
+        in.set_size_type(size_type_);
+        auto ec = in.template skip_member<0>(element);
+        if (ec != struct_pack::errc{}) {
+          needed_size_ = reader.needed;
+          return ec;
+        }
+        incomplete_ = false;
+      }
+      detail::stream_memory_reader reader{buffer_.data() + consumed_,
+                                          buffer_.data() + buffer_.size()};
+      detail::unpacker<detail::stream_memory_reader, conf> in(reader);
+      in.set_size_type(size_type_);
+      auto ec = in.template deserialize_member<0>(element);
+      if (ec != struct_pack::errc{}) {
+        needed_size_ = reader.needed;
+        incomplete_ = ec == errc::no_buffer_space;
+        return ec;
+      }
+      consumed_ = reader.now - buffer_.data();
+      ++decoded_size_;
+      on_element(std::move(element));
+    }
+    state_ = state::finished;
+    return struct_pack::errc{};
+  }
+
+  std::size_t max_buffer_size_;
+  std::string buffer_;
+  std::size_t consumed_ = 0;
+  std::size_t needed_size_ = 0;
+  bool incomplete_ = false;
+  state state_ = state::header;
+  struct_pack::errc error_{};
+  unsigned char size_type_ = 0;
+  std::size_t size_ = 0;
+  std::size_t decoded_size_ = 0;
+};
+}  // namespace struct_pack
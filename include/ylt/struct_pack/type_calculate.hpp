@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 #pragma once
+#include <array>
+
 #include "alignment.hpp"
+#include "endian_wrapper.hpp"
 #include "marco.h"
 #include "md5_constexpr.hpp"
 #include "reflection.hpp"
@@ -229,6 +232,16 @@ constexpr decltype(auto) get_type_literal() {
                  get_size_literal<align::pack_alignment_v<Arg>>() +
                  get_size_literal<align::alignment_v<Arg>>() + end;
         }
+        else if constexpr (has_field_offset_table<Arg>()) {
+          constexpr auto flag = string_literal<char, 1>{
+              {static_cast<char>(type_id::field_offset_table_flag)}};
+          return begin + flag + body + end;
+        }
+        else if constexpr (is_enable_columnar(get_parent_tag<Arg>())) {
+          constexpr auto flag = string_literal<char, 1>{
+              {static_cast<char>(type_id::columnar_flag)}};
+          return begin + flag + body + end;
+        }
         else {
           return begin + body + end;
         }
@@ -353,6 +366,16 @@ constexpr decltype(auto) get_types_literal() {
         return begin + body + get_size_literal<align::pack_alignment_v<T>>() +
                get_size_literal<align::alignment_v<T>>() + end;
       }
+      else if constexpr (has_field_offset_table<T>()) {
+        constexpr auto flag = string_literal<char, 1>{
+            {static_cast<char>(type_id::field_offset_table_flag)}};
+        return begin + flag + body + end;
+      }
+      else if constexpr (is_enable_columnar(get_parent_tag<T>())) {
+        constexpr auto flag = string_literal<char, 1>{
+            {static_cast<char>(type_id::columnar_flag)}};
+        return begin + flag + body + end;
+      }
       else {
         return begin + body + end;
       }
@@ -905,5 +928,88 @@ constexpr auto get_types() {
   }
 }
 
+// A run of adjacent members which could be serialized by a single memcpy.
+// `length` is the count of members in the run, it's zero if the member is
+// inside a run begin before it. `size` is the bytes of the run.
+struct member_run {
+  std::size_t length;
+  std::size_t size;
+};
+
+template <typename T, uint64_t parent_tag>
+constexpr bool is_memcpy_member() {
+  if constexpr (is_compatible_v<T> || is_trivial_view_v<T> ||
+                std::is_same_v<T, std::monostate>) {
+    return false;
+  }
+  else {
+    return is_trivial_serializable<T, false, parent_tag>::value &&
+           is_little_endian_copyable<sizeof(T)>;
+  }
+}
+
+#ifdef STRUCT_PACK_DISABLE_MEMBER_RUNS
+constexpr inline bool enable_member_runs = false;
+#else
+constexpr inline bool enable_member_runs = true;
+#endif
+
+// Merge the adjacent trivially serializable members into runs, assuming the
+// natural layout of the members. The layout is checked again when serializing
+// since alignas, [[no_unique_address]] or the reordered members of
+// STRUCT_PACK_REFL may break the assumption. Define
+// STRUCT_PACK_DISABLE_MEMBER_RUNS to copy the members one by one.
+template <typename Types, uint64_t parent_tag, std::size_t... I>
+constexpr auto get_member_runs_impl(std::index_sequence<I...>) {
+  constexpr std::size_t size[] = {sizeof(std::tuple_element_t<I, Types>)...};
+  constexpr std::size_t align[] = {
+      alignof(std::tuple_element_t<I, Types>)...};
+  constexpr bool memcpy_able[] = {
+      is_memcpy_member<std::tuple_element_t<I, Types>, parent_tag>()...};
+  std::array<member_run, sizeof...(I)> runs{};
+  std::size_t offset = 0, run_begin = 0;
+  for (std::size_t i = 0; i < sizeof...(I); ++i) {
+    auto begin = (offset + align[i] - 1) / align[i] * align[i];
+    if (enable_member_runs && i > 0 && memcpy_able[i] && memcpy_able[i - 1] &&
+        begin == offset) {
+      ++runs[run_begin].length;
+      runs[run_begin].size += size[i];
+    }
+    else {
+      run_begin = i;
+      runs[i] = member_run{1, size[i]};
+    }
+    offset = begin + size[i];
+  }
+  return runs;
+}
+
+template <typename T>
+constexpr auto get_member_runs() {
+  using Types = decltype(get_types<T>());
+  constexpr std::size_t count = std::tuple_size_v<Types>;
+  if constexpr (count == 0) {
+    return std::array<member_run, 0>{};
+  }
+  else {
+    return get_member_runs_impl<Types, get_parent_tag<T>()>(
+        std::make_index_sequence<count>{});
+  }
+}
+
+template <typename T>
+constexpr inline auto member_runs = get_member_runs<T>();
+
+// Check whether the members [Begin, Begin + sizeof...(I) + 1) are placed
+// continuously in memory.
+template <std::size_t Begin, typename Tuple, std::size_t... I>
+STRUCT_PACK_INLINE bool is_continuous_members(const Tuple &members,
+                                              std::index_sequence<I...>) {
+  return ((reinterpret_cast<const char *>(&std::get<Begin + I>(members)) +
+               sizeof(std::get<Begin + I>(members)) ==
+           reinterpret_cast<const char *>(&std::get<Begin + I + 1>(members))) &&
+          ...);
+}
+
 }  // namespace detail
 }  // namespace struct_pack
\ No newline at end of file
@@ -66,6 +66,10 @@ enum class type_id {
   expected_t,
   bitset_t,
   polymorphic_unique_ptr_t,
+  // flag for struct whose containers are encoded by columns
+  columnar_flag = 247,
+  // flag for struct encoded with a field offset table
+  field_offset_table_flag = 248,
   // flag for user-defined type
   user_defined_type = 249,
   // monostate, or void
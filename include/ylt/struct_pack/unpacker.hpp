@@ -94,6 +94,23 @@ class unpacker {
 #endif
   }
 
+#if __cpp_lib_memory_resource >= 201603L
+  // Every std::pmr container in the deserialized object graph will allocate
+  // from the resource, so that the whole message can be released at once.
+  STRUCT_PACK_INLINE unpacker(Reader &reader,
+                              std::pmr::memory_resource *resource)
+      : unpacker(reader) {
+    resource_ = resource;
+  }
+
+  std::pmr::memory_resource *memory_resource() const noexcept {
+    return resource_;
+  }
+  void set_memory_resource(std::pmr::memory_resource *resource) noexcept {
+    resource_ = resource;
+  }
+#endif
+
   template <std::size_t size_width, typename R, typename T>
   friend STRUCT_PACK_INLINE struct_pack::errc read(Reader &reader, T &t);
 
@@ -278,6 +295,78 @@ class unpacker {
     return err_code;
   }
 
+  // Deserialize the Ith column of T, which is a container encoded by columns.
+  // The Column is a std::vector of the member type, or a column_view of it.
+  template <typename T, size_t I, typename Column>
+  STRUCT_PACK_MAY_INLINE struct_pack::errc get_column(Column &column) {
+    static_assert(columnar_container<T>(),
+                  "T should be a container of the struct configured with "
+                  "ENCODING_WITH_COLUMNAR");
+    auto &&[err_code, buffer_len] = deserialize_metainfo<T>();
+    if SP_UNLIKELY (err_code != struct_pack::errc{}) {
+      return err_code;
+    }
+    return dispatch_size_type([&](auto size_type) {
+      return get_column_impl<decltype(size_type)::value, T, I>(
+          column, std::make_index_sequence<I>{});
+    });
+  }
+
+  template <size_t size_type, typename T, size_t I, typename Column,
+            size_t... J>
+  STRUCT_PACK_INLINE struct_pack::errc get_column_impl(
+      Column &column, std::index_sequence<J...>) {
+    using value_type = typename T::value_type;
+    using field_type =
+        std::tuple_element_t<I, decltype(get_types<value_type>())>;
+    constexpr uint64_t tag = get_parent_tag<value_type>();
+    std::size_t size = 0;
+    auto code = read_container_length<size_type>(size);
+    if SP_UNLIKELY (code != struct_pack::errc{}) {
+      return code;
+    }
+    T useless;
+    (void)(((code = deserialize_column<size_type, UINT64_MAX, false, J>(
+                 useless, size)) == struct_pack::errc{}) &&
+           ...);
+    if SP_UNLIKELY (code != struct_pack::errc{}) {
+      return code;
+    }
+    if constexpr (is_column_view_v<Column>) {
+      static_assert(is_trivial_serializable<field_type, false, tag>::value &&
+                        is_little_endian_copyable<sizeof(field_type)>,
+                    "The column_view can only refer to the column of trivial "
+                    "values.");
+      static_assert(view_reader_t<Reader>,
+                    "The Reader isn't a view_reader, can't get a column_view");
+      if constexpr (sizeof(field_type) > 1) {
+        if SP_UNLIKELY (size > SIZE_MAX / sizeof(field_type)) {
+          return errc::no_buffer_space;
+        }
+      }
+      const char *view = reader_.read_view(size * sizeof(field_type));
+      if SP_UNLIKELY (view == nullptr) {
+        return struct_pack::errc::no_buffer_space;
+      }
+      column = Column{(const field_type *)view, size};
+    }
+    else {
+      constexpr std::size_t block_lim_cnt =
+          STRUCT_PACK_MAX_UNCONFIRM_PREREAD_SIZE / sizeof(field_type);
+      column.clear();
+      column.reserve((std::min)(size, block_lim_cnt));
+      for (std::size_t i = 0; i < size; ++i) {
+        field_type value{};
+        code = deserialize_one<size_type, UINT64_MAX, true, tag>(value);
+        if SP_UNLIKELY (code != struct_pack::errc{}) {
+          return code;
+        }
+        column.push_back(std::move(value));
+      }
+    }
+    return code;
+  }
+
   template <typename T, typename... Args, size_t... I>
   STRUCT_PACK_INLINE struct_pack::errc deserialize_compatibles(
       T &t, std::index_sequence<I...>, Args &...args) {
@@ -436,8 +525,16 @@ class unpacker {
       std::tuple_element_t<I, decltype(get_types<U>())> &field) {
     using T = remove_cvref_t<U>;
 
-    T t;
     struct_pack::errc err_code;
+    if constexpr (has_field_offset_table<T>() && version == UINT64_MAX) {
+      err_code = seek_field<T, I>();
+      if SP_LIKELY (err_code == errc::ok) {
+        constexpr uint64_t tag = get_parent_tag<T>();
+        err_code = deserialize_one<size_type, version, true, tag>(field);
+      }
+      return err_code;
+    }
+    T t;
     if constexpr (tuple<T>) {
       err_code = std::apply(
           [&](auto &&...items) CONSTEXPR_INLINE_LAMBDA {
@@ -462,6 +559,103 @@ class unpacker {
     return err_code;
   }
 
+  // Move the reader from the field offset table of T to its Ith member.
+  template <typename T, size_t I>
+  STRUCT_PACK_INLINE struct_pack::errc seek_field() {
+    constexpr std::size_t count = struct_pack::members_count<T>;
+    static_assert(I < count, "out of range");
+    uint32_t begin = 0;
+    if constexpr (I > 0) {
+      if SP_UNLIKELY (!reader_.ignore(sizeof(uint32_t) * (I - 1)) ||
+                      !read_wrapper<sizeof(uint32_t)>(reader_,
+                                                      (char *)&begin)) {
+        return errc::no_buffer_space;
+      }
+    }
+    if SP_UNLIKELY (!reader_.ignore(sizeof(uint32_t) * (count - I))) {
+      return errc::no_buffer_space;
+    }
+    return reader_.ignore(begin) ? errc{} : errc::no_buffer_space;
+  }
+
+  // Skip a whole struct by the last entry of its field offset table.
+  template <typename T>
+  STRUCT_PACK_INLINE struct_pack::errc skip_by_field_offset_table() {
+    constexpr std::size_t count = struct_pack::members_count<T>;
+    uint32_t end;
+    if SP_UNLIKELY (!reader_.ignore(sizeof(uint32_t) * (count - 1)) ||
+                    !read_wrapper<sizeof(uint32_t)>(reader_, (char *)&end)) {
+      return errc::no_buffer_space;
+    }
+    return reader_.ignore(end) ? errc{} : errc::no_buffer_space;
+  }
+
+  unsigned char size_type() const noexcept { return size_type_; }
+  void set_size_type(unsigned char size_type) noexcept {
+    size_type_ = size_type;
+  }
+
+  // Deserialize a member of a struct without metainfo, the size_type should be
+  // set before. Used by struct_pack::view.
+  template <uint64_t parent_tag, typename T>
+  STRUCT_PACK_INLINE struct_pack::errc deserialize_member(T &t) {
+    return dispatch_size_type([&](auto size_type) {
+      return deserialize_one<decltype(size_type)::value, UINT64_MAX, true,
+                             parent_tag>(t);
+    });
+  }
+
+  // Same as deserialize_member, but only moves the reader over the member,
+  // `t` is left unchanged. Used by struct_pack::stream_decoder.
+  template <uint64_t parent_tag, typename T>
+  STRUCT_PACK_INLINE struct_pack::errc skip_member(T &t) {
+    return dispatch_size_type([&](auto size_type) {
+      return deserialize_one<decltype(size_type)::value, UINT64_MAX, false,
+                             parent_tag>(t);
+    });
+  }
+
+  // Same as get_field, but the reader is at the start of the payload of U.
+  template <typename U, size_t I>
+  STRUCT_PACK_INLINE struct_pack::errc get_field_without_metainfo(
+      std::tuple_element_t<I, decltype(get_types<U>())> &field) {
+    return dispatch_size_type([&](auto size_type) {
+      return get_field_impl<decltype(size_type)::value, UINT64_MAX, U, I>(
+          field);
+    });
+  }
+
+  template <typename Func>
+  STRUCT_PACK_INLINE struct_pack::errc dispatch_size_type(Func &&func) {
+    switch (size_type_) {
+      case 0:
+        return func(std::integral_constant<std::size_t, 1>{});
+#ifdef STRUCT_PACK_OPTIMIZE
+      case 1:
+        return func(std::integral_constant<std::size_t, 2>{});
+      case 2:
+        return func(std::integral_constant<std::size_t, 4>{});
+      case 3:
+        if constexpr (sizeof(std::size_t) >= 8) {
+          return func(std::integral_constant<std::size_t, 8>{});
+        }
+        else {
+          return struct_pack::errc::invalid_width_of_container_length;
+        }
+#else
+      case 3:
+        if constexpr (sizeof(std::size_t) < 8) {
+          return struct_pack::errc::invalid_width_of_container_length;
+        }
+      case 2:
+      case 1:
+        return func(std::integral_constant<std::size_t, 2>{});
+#endif
+      default:
+        return struct_pack::errc::invalid_width_of_container_length;
+    }
+  }
+
   template <typename size_type, typename version, typename NotSkip>
   struct variant_construct_helper {
     template <size_t index, typename unpack, typename variant_t>
@@ -610,6 +804,71 @@ class unpacker {
     }
   }
 
+  template <size_t size_type, uint64_t version, bool NotSkip, typename T,
+            typename Tuple, std::size_t... I>
+  constexpr struct_pack::errc STRUCT_PACK_INLINE
+  deserialize_member_runs(const Tuple &members, std::index_sequence<I...>) {
+    struct_pack::errc code{};
+    (void)((code = deserialize_member_run<size_type, version, NotSkip, T, I>(
+                members),
+            code == struct_pack::errc{}) &&
+           ...);
+    return code;
+  }
+
+  template <size_t size_type, uint64_t version, bool NotSkip, typename T,
+            std::size_t I, typename Tuple>
+  constexpr struct_pack::errc STRUCT_PACK_INLINE
+  deserialize_member_run(const Tuple &members) {
+    constexpr auto run = member_runs<T>[I];
+    constexpr uint64_t tag = get_parent_tag<T>();
+    if constexpr (run.length == 1) {
+      return deserialize_one<size_type, version, NotSkip, tag>(
+          std::get<I>(members));
+    }
+    else if constexpr (run.length > 1) {
+      if constexpr (!NotSkip) {
+        return reader_.ignore(run.size) ? errc{} : errc::no_buffer_space;
+      }
+      else if SP_LIKELY (is_continuous_members<I>(
+                             members,
+                             std::make_index_sequence<run.length - 1>{})) {
+        if constexpr (view_reader_t<Reader>) {
+          const char *view = reader_.read_view(run.size);
+          if SP_UNLIKELY (view == nullptr) {
+            return errc::no_buffer_space;
+          }
+          copy_bytes<run.size>((char *)&std::get<I>(members), view);
+          return errc{};
+        }
+        else {
+          return read_bytes_array(reader_, (char *)&std::get<I>(members),
+                                  run.size)
+                     ? errc{}
+                     : errc::no_buffer_space;
+        }
+      }
+      else {
+        return deserialize_members_one_by_one<size_type, version, NotSkip, tag,
+                                              I>(
+            members, std::make_index_sequence<run.length>{});
+      }
+    }
+    else {
+      return errc{};
+    }
+  }
+
+  template <size_t size_type, uint64_t version, bool NotSkip,
+            uint64_t parent_tag, std::size_t Begin, typename Tuple,
+            std::size_t... I>
+  constexpr struct_pack::errc STRUCT_PACK_INLINE
+  deserialize_members_one_by_one(const Tuple &members,
+                                 std::index_sequence<I...>) {
+    return deserialize_many<size_type, version, NotSkip, parent_tag>(
+        std::get<Begin + I>(members)...);
+  }
+
   template <size_t size_type, uint64_t version, bool NotSkip>
   constexpr struct_pack::errc STRUCT_PACK_INLINE deserialize_many() {
     return {};
@@ -747,6 +1006,153 @@ class unpacker {
     }
   }
 
+  template <size_t size_type, uint64_t version, bool NotSkip, std::size_t I,
+            typename T>
+  STRUCT_PACK_INLINE struct_pack::errc deserialize_column_member(T &element) {
+    return visit_members(
+        element, [this](auto &&...items) CONSTEXPR_INLINE_LAMBDA {
+          constexpr uint64_t tag = get_parent_tag<T>();
+          return deserialize_one<size_type, version, NotSkip, tag>(
+              std::get<I>(std::forward_as_tuple(items...)));
+        });
+  }
+
+  template <size_t size_type, uint64_t version, bool NotSkip, std::size_t I,
+            typename T>
+  STRUCT_PACK_INLINE struct_pack::errc deserialize_column(T &item,
+                                                          std::size_t size) {
+    using value_type = typename T::value_type;
+    struct_pack::errc code{};
+    if constexpr (!NotSkip) {
+      value_type useless{};
+      for (std::size_t i = 0; i < size; ++i) {
+        code = deserialize_column_member<size_type, version, NotSkip, I>(
+            useless);
+        if SP_UNLIKELY (code != struct_pack::errc{}) {
+          return code;
+        }
+      }
+    }
+    else if constexpr (I == 0) {
+      // The elements are created by the first column, so the memory we
+      // allocate is limited by the data we have read.
+      constexpr std::size_t block_lim_cnt =
+          STRUCT_PACK_MAX_UNCONFIRM_PREREAD_SIZE / sizeof(value_type);
+      item.clear();
+      if constexpr (can_reserve<T>) {
+        item.reserve((std::min)(size, block_lim_cnt));
+      }
+      for (std::size_t i = 0; i < size; ++i) {
+        item.emplace_back();
+        code = deserialize_column_member<size_type, version, NotSkip, I>(
+            item.back());
+        if SP_UNLIKELY (code != struct_pack::errc{}) {
+          if constexpr (can_shrink_to_fit<T>) {
+            item.shrink_to_fit();
+          }
+          return code;
+        }
+      }
+    }
+    else {
+      for (auto &element : item) {
+        code = deserialize_column_member<size_type, version, NotSkip, I>(
+            element);
+        if SP_UNLIKELY (code != struct_pack::errc{}) {
+          return code;
+        }
+      }
+    }
+    return code;
+  }
+
+  template <size_t size_type, uint64_t version, bool NotSkip, typename T,
+            std::size_t... I>
+  STRUCT_PACK_INLINE struct_pack::errc deserialize_columns(
+      T &item, std::size_t size, std::index_sequence<I...>) {
+    struct_pack::errc code{};
+    (void)(((code = deserialize_column<size_type, version, NotSkip, I>(
+                 item, size)) == struct_pack::errc{}) &&
+           ...);
+    return code;
+  }
+
+  template <size_t size_type>
+  STRUCT_PACK_INLINE struct_pack::errc read_container_length(
+      std::size_t &size) {
+    if constexpr (size_type == 1) {
+      if SP_UNLIKELY (!low_bytes_read_wrapper<size_type>(reader_, size)) {
+        return struct_pack::errc::no_buffer_space;
+      }
+    }
+    else {
+#ifdef STRUCT_PACK_OPTIMIZE
+      constexpr bool struct_pack_optimize = true;
+#else
+      constexpr bool struct_pack_optimize = false;
+#endif
+      if constexpr (force_optimize || struct_pack_optimize) {
+        if constexpr (size_type == 2) {
+          if SP_UNLIKELY (!low_bytes_read_wrapper<size_type>(reader_, size)) {
+            return struct_pack::errc::no_buffer_space;
+          }
+        }
+        else if constexpr (size_type == 4) {
+          if SP_UNLIKELY (!low_bytes_read_wrapper<size_type>(reader_, size)) {
+            return struct_pack::errc::no_buffer_space;
+          }
+        }
+        else if constexpr (size_type == 8) {
+          if constexpr (sizeof(std::size_t) >= 8) {
+            if SP_UNLIKELY (!low_bytes_read_wrapper<size_type>(reader_, size)) {
+              return struct_pack::errc::no_buffer_space;
+            }
+          }
+          else {
+            std::uint64_t sz;
+            if SP_UNLIKELY (!low_bytes_read_wrapper<size_type>(reader_, sz)) {
+              return struct_pack::errc::no_buffer_space;
+            }
+            if SP_UNLIKELY (sz > UINT32_MAX) {
+              return struct_pack::errc::invalid_width_of_container_length;
+            }
+            size = sz;
+          }
+        }
+        else {
+          static_assert(size_type == 2, "illegal size_type");
+        }
+      }
+      else {
+        switch (size_type_) {
+          case 1:
+            if SP_UNLIKELY (!low_bytes_read_wrapper<2>(reader_, size)) {
+              return struct_pack::errc::no_buffer_space;
+            }
+            break;
+          case 2:
+            if SP_UNLIKELY (!low_bytes_read_wrapper<4>(reader_, size)) {
+              return struct_pack::errc::no_buffer_space;
+            }
+            break;
+          case 3:
+            if constexpr (sizeof(std::size_t) >= 8) {
+              if SP_UNLIKELY (!low_bytes_read_wrapper<8>(reader_, size)) {
+                return struct_pack::errc::no_buffer_space;
+              }
+            }
+            else {
+              unreachable();
+            }
+            break;
+          default:
+            unreachable();
+        }
+      }
+    }
+    return {};
+  }
+
   template <size_t size_type, uint64_t version, bool NotSkip,
             uint64_t parent_tag = 0, typename T>
   constexpr struct_pack::errc inline deserialize_one(T &item) {
@@ -873,84 +1279,25 @@ class unpacker {
       else if constexpr (container<type>) {
         std::size_t size = 0;
         bool result{};
-        if constexpr (size_type == 1) {
-          if SP_UNLIKELY (!low_bytes_read_wrapper<size_type>(reader_, size)) {
-            return struct_pack::errc::no_buffer_space;
-          }
-        }
-        else {
-#ifdef STRUCT_PACK_OPTIMIZE
-          constexpr bool struct_pack_optimize = true;
-#else
-          constexpr bool struct_pack_optimize = false;
-#endif
-          if constexpr (force_optimize || struct_pack_optimize) {
-            if constexpr (size_type == 2) {
-              if SP_UNLIKELY (!low_bytes_read_wrapper<size_type>(reader_,
-                                                                 size)) {
-                return struct_pack::errc::no_buffer_space;
-              }
-            }
-            else if constexpr (size_type == 4) {
-              if SP_UNLIKELY (!low_bytes_read_wrapper<size_type>(reader_,
-                                                                 size)) {
-                return struct_pack::errc::no_buffer_space;
-              }
-            }
-            else if constexpr (size_type == 8) {
-              if constexpr (sizeof(std::size_t) >= 8) {
-                if SP_UNLIKELY (!low_bytes_read_wrapper<size_type>(reader_,
-                                                                   size)) {
-                  return struct_pack::errc::no_buffer_space;
-                }
-              }
-              else {
-                std::uint64_t sz;
-                if SP_UNLIKELY (!low_bytes_read_wrapper<size_type>(reader_,
-                                                                   sz)) {
-                  return struct_pack::errc::no_buffer_space;
-                }
-                if SP_UNLIKELY (sz > UINT32_MAX) {
-                  return struct_pack::errc::invalid_width_of_container_length;
-                }
-                size = sz;
-              }
-            }
-            else {
-              static_assert(!sizeof(T), "illegal size_type");
-            }
-          }
-          else {
-            switch (size_type_) {
-              case 1:
-                if SP_UNLIKELY (!low_bytes_read_wrapper<2>(reader_, size)) {
-                  return struct_pack::errc::no_buffer_space;
-                }
-                break;
-              case 2:
-                if SP_UNLIKELY (!low_bytes_read_wrapper<4>(reader_, size)) {
-                  return struct_pack::errc::no_buffer_space;
-                }
-                break;
-              case 3:
-                if constexpr (sizeof(std::size_t) >= 8) {
-                  if SP_UNLIKELY (!low_bytes_read_wrapper<8>(reader_, size)) {
-                    return struct_pack::errc::no_buffer_space;
-                  }
-                }
-                else {
-                  unreachable();
-                }
-                break;
-              default:
-                unreachable();
-            }
-          }
+        code = read_container_length<size_type>(size);
+        if SP_UNLIKELY (code != struct_pack::errc{}) {
+          return code;
         }
         if (size == 0) {
           return {};
         }
-        if constexpr (map_container<type>) {
+#if __cpp_lib_memory_resource >= 201603L
+        if constexpr (NotSkip && pmr_container<type>) {
+          bind_memory_resource(item);
+        }
+#endif
+        if constexpr (columnar_container<type>()) {
+          return deserialize_columns<size_type, version, NotSkip>(
+              item, size,
+              std::make_index_sequence<
+                  struct_pack::members_count<typename type::value_type>>{});
+        }
+        else if constexpr (map_container<type>) {
           std::pair<typename type::key_type, typename type::mapped_type>
               value{};
           if constexpr (is_trivial_serializable<decltype(value)>::value &&
@@ -1088,6 +1435,29 @@ class unpacker {
                             "It's illegal to deserialize a span<T> which T "
                             "is a non-trival-serializable type.");
             }
+            else if constexpr (NotSkip &&
+                               is_bulk_varint_container<type>() &&
+                               std::is_base_of_v<memory_reader, Reader>) {
+              item.clear();
+              for (size_t i = 0; i < size;) {
+                auto len = (std::min)(size - i, block_lim_cnt);
+                item.resize(i + len);
+                i += deserialize_varint_bulk(reader_.now, reader_.end,
+                                             item.data() + i, len);
+                if (i < item.size()) {
+                  // the tail of buffer, or an invalid varint.
+                  code = deserialize_one<size_type, version, NotSkip>(item[i]);
+                  if SP_UNLIKELY (code != struct_pack::errc{}) {
+                    item.resize(i);
+                    if constexpr (can_shrink_to_fit<type>) {
+                      item.shrink_to_fit();
+                    }
+                    return code;
+                  }
+                  ++i;
+                }
+              }
+            }
             else if constexpr (NotSkip) {
               item.clear();
               if constexpr (can_reserve<type>) {
@@ -1209,6 +1579,18 @@ class unpacker {
         }
         else {
           constexpr uint64_t tag = get_parent_tag<type>();
+          if constexpr (has_field_offset_table<type>()) {
+            if constexpr (NotSkip) {
+              if SP_UNLIKELY (!reader_.ignore(
+                                  sizeof(uint32_t) *
+                                  struct_pack::members_count<type>)) {
+                return errc::no_buffer_space;
+              }
+            }
+            else {
+              return skip_by_field_offset_table<type>();
+            }
+          }
           if constexpr (is_enable_fast_varint_coding(tag)) {
             code = visit_members(
                 item, [this](auto &&...items) CONSTEXPR_INLINE_LAMBDA {
@@ -1222,10 +1604,10 @@ class unpacker {
           }
           code = visit_members(
               item, [this](auto &&...items) CONSTEXPR_INLINE_LAMBDA {
-                constexpr uint64_t tag =
-                    get_parent_tag<type>();  // to pass msvc with c++17
-                return deserialize_many<size_type, version, NotSkip, tag>(
-                    items...);
+                return deserialize_member_runs<size_type, version, NotSkip,
+                                               type>(
+                    std::forward_as_tuple(items...),
+                    std::make_index_sequence<sizeof...(items)>{});
               });
         }
       }
@@ -1418,8 +1800,24 @@ class unpacker {
   std::size_t data_len_;
 
  private:
+#if __cpp_lib_memory_resource >= 201603L
+  // The allocator of a pmr container is never propagated by assignment, so we
+  // rebuild the container in place with the expected memory resource. It's
+  // only called before the container is filled, so nothing is lost.
+  template <typename T>
+  STRUCT_PACK_INLINE void bind_memory_resource(T &item) {
+    if (resource_ != nullptr && item.get_allocator().resource() != resource_) {
+      item.~T();
+      new (&item) T(typename T::allocator_type{resource_});
+    }
+  }
+#endif
+
   Reader &reader_;
   unsigned char size_type_;
+#if __cpp_lib_memory_resource >= 201603L
+  std::pmr::memory_resource *resource_ = nullptr;
+#endif
 };
 
 template <typename Reader>
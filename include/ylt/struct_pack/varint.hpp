@@ -14,13 +14,26 @@
  * limitations under the License.
  */
 #pragma once
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <ostream>
 #include <system_error>
 #include <type_traits>
 
 #include "endian_wrapper.hpp"
 #include "reflection.hpp"
+
+#if __has_include(<bit>)
+#include <bit>
+#endif
+
+#if !defined(STRUCT_PACK_DISABLE_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#elif !defined(STRUCT_PACK_DISABLE_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+#include <emmintrin.h>
+#endif
 namespace struct_pack {
 
 namespace detail {
@@ -348,6 +361,242 @@ auto& get_varint_value(T& v) {
   }
 }
 
+// Bulk coding of the continuous containers of varint/sint, e.g.
+// std::vector<var_uint64_t>. The wire format is as same as coding the elements
+// one by one.
+
+template <typename T>
+constexpr bool bulk_varint_t = varintable_t<T> || sintable_t<T>;
+
+template <typename T>
+constexpr bool is_bulk_varint_container() {
+  if constexpr (continuous_container<T>) {
+    return bulk_varint_t<typename T::value_type>;
+  }
+  else {
+    return false;
+  }
+}
+
+template <typename T>
+[[nodiscard]] STRUCT_PACK_INLINE uint64_t get_varint_bits(const T& t) {
+  if constexpr (sintable_t<T>) {
+    return encode_zigzag(t.get());
+  }
+  else {
+    return t.get();
+  }
+}
+
+template <typename T>
+STRUCT_PACK_INLINE void set_varint_bits(T& t, uint64_t v) {
+  if constexpr (sintable_t<T>) {
+    t = decode_zigzag<int64_t>(v);
+  }
+  else {
+    t = v;
+  }
+}
+
+[[nodiscard]] STRUCT_PACK_INLINE std::size_t countr_zero_u64(uint64_t v) {
+#if __cpp_lib_bitops >= 201907L
+  return std::countr_zero(v);
+#elif defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(v);
+#else
+  std::size_t ret = 0;
+  for (; !(v & 1); v >>= 1) ++ret;
+  return ret;
+#endif
+}
+
+[[nodiscard]] STRUCT_PACK_INLINE std::size_t varint_size_u64(uint64_t v) {
+#if __cpp_lib_bitops >= 201907L
+  return (std::bit_width(v | 1) + 6) / 7;
+#else
+  return calculate_varint_size(v);
+#endif
+}
+
+template <typename T>
+[[nodiscard]] STRUCT_PACK_INLINE std::size_t calculate_varint_size_bulk(
+    const T* data, std::size_t n) {
+  std::size_t ret = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    ret += varint_size_u64(get_varint_bits(data[i]));
+  }
+  return ret;
+}
+
+// Encode v to p and return the length. p should have 10 bytes at least.
+[[nodiscard]] STRUCT_PACK_INLINE std::size_t encode_varint_bytes(char* p,
+                                                               uint64_t v) {
+  if (v < (uint64_t{1} << 56) && is_system_little_endian) {
+    // spread the 7-bit groups to bytes and set the continuation bits, which
+    // is the reverse of decode_varint_bytes, without a loop per byte.
+    std::size_t len = varint_size_u64(v);
+    uint64_t x = (v & 0x000000000fffffffull) | ((v & 0x00fffffff0000000ull) << 4);
+    x = (x & 0x00003fff00003fffull) | ((x & 0x0fffc0000fffc000ull) << 2);
+    x = (x & 0x007f007f007f007full) | ((x & 0x3f803f803f803f80ull) << 1);
+    x |= 0x8080808080808080ull & ((uint64_t{1} << (len * 8 - 8)) - 1);
+    memcpy(p, &x, sizeof(x));
+    return len;
+  }
+  std::size_t len = 0;
+  while (v >= 0x80) {
+    p[len++] = static_cast<char>(v | 0x80u);
+    v >>= 7;
+  }
+  p[len++] = static_cast<char>(v);
+  return len;
+}
+
+template <
+#if __cpp_concepts >= 201907L
+    writer_t writer,
+#else
+    typename writer,
+#endif
+    typename T>
+STRUCT_PACK_INLINE void serialize_varint_bulk(writer& writer_, const T* data,
+                                              std::size_t n) {
+  constexpr std::size_t block_size = 16;
+  constexpr std::size_t buffer_size = 1024;
+  char buffer[buffer_size + block_size * 10];
+  std::size_t len = 0;
+  for (std::size_t i = 0; i < n;) {
+    std::size_t k = (std::min)(block_size, n - i);
+    // Small values are the common case of varint, a block of them is
+    // written as bytes directly, the compiler vectorizes it.
+    uint64_t bits = 0;
+    for (std::size_t j = 0; j < k; ++j) {
+      bits |= get_varint_bits(data[i + j]);
+    }
+    if (bits < 0x80) {
+      for (std::size_t j = 0; j < k; ++j) {
+        buffer[len + j] = static_cast<char>(get_varint_bits(data[i + j]));
+      }
+      len += k;
+    }
+    else {
+      for (std::size_t j = 0; j < k; ++j) {
+        len += encode_varint_bytes(buffer + len, get_varint_bits(data[i + j]));
+      }
+    }
+    i += k;
+    if (len >= buffer_size) {
+      write_bytes_array(writer_, buffer, len);
+      len = 0;
+    }
+  }
+  if (len > 0) {
+    write_bytes_array(writer_, buffer, len);
+  }
+}
+
+// Masked-VByte style decoding: the continuation bits of a window of bytes are
+// gathered to a bitmask by SIMD, then every varint which ends in the window is
+// located by the mask instead of testing the bytes one by one. The window is
+// 32 bytes with AVX2, 16 bytes with SSE2, and 8 bytes (SWAR) otherwise.
+#if !defined(STRUCT_PACK_DISABLE_SIMD) && defined(__AVX2__)
+constexpr std::size_t varint_window_size = 32;
+#elif !defined(STRUCT_PACK_DISABLE_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+constexpr std::size_t varint_window_size = 16;
+#else
+constexpr std::size_t varint_window_size = 8;
+#endif
+
+[[nodiscard]] STRUCT_PACK_INLINE uint64_t load_u64(const char* p) {
+  uint64_t x;
+  memcpy(&x, p, sizeof(x));
+  if constexpr (!is_system_little_endian) {
+    x = bswap64(x);
+  }
+  return x;
+}
+
+// bit i is set if byte i of the window has the continuation bit.
+[[nodiscard]] STRUCT_PACK_INLINE uint64_t varint_continuation_mask(
+    const char* p) {
+#if !defined(STRUCT_PACK_DISABLE_SIMD) && defined(__AVX2__)
+  return static_cast<uint32_t>(_mm256_movemask_epi8(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))));
+#elif !defined(STRUCT_PACK_DISABLE_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+  return static_cast<uint32_t>(
+      _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+#else
+  uint64_t x = (load_u64(p) >> 7) & 0x0101010101010101ull;
+  return (x * 0x0102040810204080ull) >> 56;
+#endif
+}
+
+// Decode a terminated varint of len bytes, there should be 8 bytes at least
+// from p.
+[[nodiscard]] STRUCT_PACK_INLINE uint64_t decode_varint_bytes(const char* p,
+                                                             std::size_t len) {
+  if SP_LIKELY (len <= 8) {
+    // compact the 7-bit groups of the first len bytes.
+    uint64_t x = load_u64(p) & (~uint64_t{0} >> (64 - len * 8)) &
+                 0x7f7f7f7f7f7f7f7full;
+    x = ((x & 0x7f007f007f007f00ull) >> 1) | (x & 0x007f007f007f007full);
+    x = ((x & 0x3fff00003fff0000ull) >> 2) | (x & 0x00003fff00003fffull);
+    x = ((x & 0x0fffffff00000000ull) >> 4) | (x & 0x000000000fffffffull);
+    return x;
+  }
+  uint64_t v = 0;
+  for (std::size_t i = 0; i < len; ++i) {
+    v |= (1ull * (static_cast<uint8_t>(p[i]) & 0x7fu)) << (i * 7);
+  }
+  return v;
+}
+
+// Decode at most n varints from [now, end) to out and move now forward.
+// It stops before the varints near the end of buffer, or the varint longer
+// than the max length, and returns the count of varints decoded. The caller
+// decodes the rest one by one, which also reports the error.
+template <typename T>
+[[nodiscard]] STRUCT_PACK_INLINE std::size_t deserialize_varint_bulk(
+    const char*& now, const char* end, T* out, std::size_t n) {
+  constexpr std::size_t max_varint_length = sizeof(uint64_t) * 8 / 7 + 1;
+  constexpr uint64_t window_mask = (uint64_t{1} << varint_window_size) - 1;
+  std::size_t cnt = 0;
+  // keep 8 bytes after the window for the loads of decode_varint_bytes.
+  while (cnt < n &&
+         static_cast<std::size_t>(end - now) >= varint_window_size + 8) {
+    uint64_t mask = varint_continuation_mask(now);
+    if (mask == 0) {
+      // all bytes of the window are varints of one byte.
+      std::size_t k = (std::min)(varint_window_size, n - cnt);
+      for (std::size_t i = 0; i < k; ++i) {
+        set_varint_bits(out[cnt + i], static_cast<uint8_t>(now[i]));
+      }
+      now += k;
+      cnt += k;
+      continue;
+    }
+    uint64_t ends = ~mask & window_mask;
+    std::size_t pos = 0;
+    for (uint64_t rest = ends; rest != 0; rest = ends >> pos) {
+      std::size_t len = countr_zero_u64(rest) + 1;
+      if SP_UNLIKELY (len > max_varint_length) {
+        break;
+      }
+      set_varint_bits(out[cnt], decode_varint_bytes(now + pos, len));
+      pos += len;
+      if (++cnt == n) {
+        break;
+      }
+    }
+    if (pos == 0) {
+      break;
+    }
+    now += pos;
+  }
+  return cnt;
+}
+
 }  // namespace detail
 using var_int32_t = detail::sint<int32_t>;
 using var_int64_t = detail::sint<int64_t>;
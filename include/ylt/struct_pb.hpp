@@ -17,6 +17,10 @@
 #include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #if defined __clang__
 #define STRUCT_PB_INLINE __attribute__((always_inline)) inline
@@ -25,7 +29,11 @@
 #else
 #define STRUCT_PB_INLINE __attribute__((always_inline)) inline
 #endif
+#ifndef STRUCT_PB_NODISCARD
 #define STRUCT_PB_NODISCARD [[nodiscard]]
+#endif
+
+#include "ylt/struct_pb/arena.hpp"
 namespace struct_pb {
 
 struct UnknownFields {
@@ -72,6 +80,173 @@ STRUCT_PB_NODISCARD bool deserialize_to(T& t, const char* data,
                                         std::size_t size);
 }  // namespace internal
 
+/*
+ * A submessage field declared with [lazy = true], which keeps the raw bytes
+ * of the submessage when it's deserialized and decodes them on first access.
+ * An untouched field is serialized by copying the raw bytes back.
+ *
+ * The const accessors keep the raw bytes, the non-const accessors drop them
+ * since the message may be modified. Raw is std::string_view for the view
+ * messages, which refers to the deserialized buffer like their string fields.
+ * The bytes which fail to be decoded give an empty message, the const
+ * accessors keep them to be serialized as they are, and the non-const
+ * accessors drop them too so the modified message is serialized. Call parse()
+ * to check them.
+ *
+ * The decoded message of an arena message is allocated from the arena of the
+ * message, like the raw bytes.
+ *
+ * The first access decodes the bytes without synchronization, even by the
+ * const accessors, so it's not safe to access a field from several threads
+ * at the same time unless parse() has been called before.
+ */
+template <typename T, typename Raw = std::string>
+class lazy {
+ public:
+  lazy() = default;
+  lazy(T value) { value_ = make_value(std::move(value)); }
+  lazy(lazy&&) = default;
+  lazy& operator=(lazy&&) = default;
+  lazy& operator=(T value) {
+    value_ = make_value(std::move(value));
+    parse_failed_ = false;
+    reset_raw();
+    return *this;
+  }
+
+  STRUCT_PB_NODISCARD bool has_value() const noexcept {
+    return value_ != nullptr || has_raw_;
+  }
+  explicit operator bool() const noexcept { return has_value(); }
+  // whether the field is serialized by copying the raw bytes.
+  STRUCT_PB_NODISCARD bool has_raw() const noexcept { return has_raw_; }
+  STRUCT_PB_NODISCARD bool is_parsed() const noexcept {
+    return value_ != nullptr && !parse_failed_;
+  }
+  STRUCT_PB_NODISCARD std::string_view raw() const noexcept {
+    return has_raw_ ? std::string_view{raw_.data(), raw_.size()}
+                    : std::string_view{};
+  }
+
+  // decode the raw bytes if they aren't decoded, the result is remembered.
+  bool parse() const {
+    if (value_ != nullptr) {
+      return !parse_failed_;
+    }
+    value_ = make_value();
+    if (has_raw_ &&
+        !internal::deserialize_to(*value_, raw_.data(), raw_.size())) {
+      // don't give the partially decoded message.
+      *value_ = T{};
+      parse_failed_ = true;
+    }
+    return !parse_failed_;
+  }
+
+  const T& get() const {
+    parse();
+    return *value_;
+  }
+  T& get() {
+    parse();
+    reset_raw();
+    return *value_;
+  }
+  const T& operator*() const { return get(); }
+  T& operator*() { return get(); }
+  const T* operator->() const { return &get(); }
+  T* operator->() { return &get(); }
+
+  void reset() noexcept {
+    value_.reset();
+    parse_failed_ = false;
+    reset_raw();
+  }
+
+  STRUCT_PB_NODISCARD std::size_t get_needed_size() const {
+    return has_raw_ ? raw_.size() : internal::get_needed_size(get());
+  }
+  void serialize_to(char* data, std::size_t size) const {
+    if (has_raw_) {
+      assert(raw_.size() <= size);
+      std::memcpy(data, raw_.data(), raw_.size());
+    }
+    else {
+      internal::serialize_to(data, size, get());
+    }
+  }
+  /*
+   * Keep the raw bytes of the submessage. A submessage which occurs more than
+   * once is merged like the eager fields: the owned raw bytes are concatenated,
+   * and a parsed message decodes the bytes directly. A view can't concatenate
+   * the bytes, so both occurrences are decoded into the message.
+   */
+  STRUCT_PB_NODISCARD bool deserialize_from(const char* data,
+                                            std::size_t size) {
+    if (value_ != nullptr && !has_raw_) {
+      return internal::deserialize_to(*value_, data, size);
+    }
+    if constexpr (!std::is_same_v<Raw, std::string_view>) {
+      if (!has_raw_) {
+        raw_.clear();
+      }
+      raw_.append(data, size);
+    }
+    else {
+      if (has_raw_) {
+        value_ = make_value();
+        parse_failed_ = false;
+        auto ok = internal::deserialize_to(*value_, raw_.data(), raw_.size()) &&
+                  internal::deserialize_to(*value_, data, size);
+        reset_raw();
+        return ok;
+      }
+      raw_ = Raw{data, size};
+    }
+    value_.reset();
+    parse_failed_ = false;
+    has_raw_ = true;
+    return true;
+  }
+
+  friend bool operator==(const lazy& a, const lazy& b) {
+    if (a.has_raw_ && b.has_raw_ && a.raw() == b.raw()) {
+      return true;
+    }
+    if (a.has_value() != b.has_value()) {
+      return false;
+    }
+    return !a.has_value() || a.get() == b.get();
+  }
+
+ private:
+  static constexpr bool is_arena = std::is_same_v<Raw, arena_string>;
+  using pointer =
+      std::conditional_t<is_arena, arena_ptr<T>, std::unique_ptr<T>>;
+
+  template <typename... Args>
+  pointer make_value(Args&&... args) const {
+    if constexpr (is_arena) {
+      // the raw bytes are allocated from the arena of the message.
+      arena::scope scope(raw_.get_allocator().resource());
+      return make_arena_ptr<T>(std::forward<Args>(args)...);
+    }
+    else {
+      return std::make_unique<T>(std::forward<Args>(args)...);
+    }
+  }
+
+  void reset_raw() noexcept {
+    has_raw_ = false;
+    raw_ = Raw{};
+  }
+
+  mutable pointer value_;
+  mutable bool parse_failed_ = false;
+  Raw raw_{};
+  bool has_raw_ = false;
+};
+
 /*
  * High-Level API for struct_pb user
  * If you need more fine-grained operations, encapsulate the internal API
@@ -98,5 +273,23 @@ STRUCT_PB_NODISCARD STRUCT_PB_INLINE bool deserialize_to(T& t,
                                                          const Buffer& buffer) {
   return struct_pb::internal::deserialize_to(t, buffer.data(), buffer.size());
 }
+/*
+ * Deserialize the messages generated with the arena option, the strings,
+ * containers and submessages are allocated from the arena.
+ *
+ * The message must be created by arena.create<T>(), the members of a message
+ * on the stack or the heap aren't allocated from the arena, so the elements
+ * added to them would be freed with the arena before them. A message created
+ * by another arena isn't deserialized.
+ */
+template <typename T, typename Buffer>
+STRUCT_PB_NODISCARD bool deserialize_to(arena_ptr<T>& t, const Buffer& buffer,
+                                        arena& arena) {
+  if (t == nullptr || t.get_deleter().resource != arena.resource()) {
+    return false;
+  }
+  arena::scope scope(arena);
+  return struct_pb::internal::deserialize_to(*t, buffer.data(), buffer.size());
+}
 
 }  // namespace struct_pb
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef STRUCT_PB_NODISCARD
+#define STRUCT_PB_NODISCARD [[nodiscard]]
+#endif
+
+namespace struct_pb {
+
+/*
+ * A monotonic arena for the messages generated with the arena option. The
+ * strings, containers and submessages of them are allocated from the arena
+ * which is current on the thread when they are constructed, and all of them
+ * are freed at once when the arena is reset or destroyed.
+ *
+ * struct_pb::arena arena;
+ * auto request = arena.create<xxx::Request>();
+ * bool ok = struct_pb::deserialize_to(request, buffer, arena);
+ */
+class arena {
+ public:
+  static constexpr std::size_t default_initial_size = 4096;
+
+  explicit arena(std::size_t initial_size = default_initial_size)
+      : resource_(initial_size) {}
+  // allocate from the buffer first, for example a buffer on the stack.
+  arena(void* buffer, std::size_t size) : resource_(buffer, size) {}
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  STRUCT_PB_NODISCARD std::pmr::memory_resource* resource() noexcept {
+    return &resource_;
+  }
+  // free all memory, the objects allocated from the arena must be destroyed
+  // before.
+  void reset() { resource_.release(); }
+
+  /*
+   * Make the arena current on this thread in the scope, the previous one is
+   * restored when the scope exits.
+   */
+  class scope {
+   public:
+    explicit scope(arena& a) noexcept : scope(a.resource()) {}
+    // make the resource of an arena current, such as the resource of a member
+    // of an arena message.
+    explicit scope(std::pmr::memory_resource* r) noexcept : prev_(current()) {
+      current() = r;
+    }
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+    ~scope() { current() = prev_; }
+
+   private:
+    std::pmr::memory_resource* prev_;
+  };
+
+  /*
+   * The resource of the current arena, or the default resource if there is
+   * no current arena.
+   */
+  STRUCT_PB_NODISCARD static std::pmr::memory_resource*
+  current_resource() noexcept {
+    auto r = current();
+    return r ? r : std::pmr::get_default_resource();
+  }
+
+  template <typename T, typename... Args>
+  auto create(Args&&... args);
+
+ private:
+  static std::pmr::memory_resource*& current() noexcept {
+    thread_local std::pmr::memory_resource* r = nullptr;
+    return r;
+  }
+
+  std::pmr::monotonic_buffer_resource resource_;
+};
+
+/*
+ * A polymorphic allocator whose default constructor takes the resource of
+ * the current arena, so the containers of the messages are allocated from the
+ * arena without passing the allocator to each of them.
+ */
+template <typename T>
+class arena_allocator : public std::pmr::polymorphic_allocator<T> {
+  using base = std::pmr::polymorphic_allocator<T>;
+
+ public:
+  template <typename U>
+  struct rebind {
+    using other = arena_allocator<U>;
+  };
+
+  arena_allocator() noexcept : base(arena::current_resource()) {}
+  arena_allocator(std::pmr::memory_resource* r) noexcept : base(r) {}
+  // the elements take the resource of the container.
+  template <typename U>
+  arena_allocator(const std::pmr::polymorphic_allocator<U>& other) noexcept
+      : base(other.resource()) {}
+
+  arena_allocator select_on_container_copy_construction() const noexcept {
+    return arena_allocator{};
+  }
+};
+
+template <typename T>
+struct arena_deleter {
+  // delete the object allocated by new if there is no resource.
+  std::pmr::memory_resource* resource = nullptr;
+
+  void operator()(T* p) const {
+    if (resource == nullptr) {
+      delete p;
+    }
+    else {
+      p->~T();
+      resource->deallocate(p, sizeof(T), alignof(T));
+    }
+  }
+};
+
+using arena_string =
+    std::basic_string<char, std::char_traits<char>, arena_allocator<char>>;
+template <typename T>
+using arena_vector = std::vector<T, arena_allocator<T>>;
+template <typename K, typename V>
+using arena_map =
+    std::map<K, V, std::less<K>, arena_allocator<std::pair<const K, V>>>;
+// the submessage pointer of the arena messages.
+template <typename T>
+using arena_ptr = std::unique_ptr<T, arena_deleter<T>>;
+
+template <typename T, typename... Args>
+arena_ptr<T> make_arena_ptr(Args&&... args) {
+  auto r = arena::current_resource();
+  void* p = r->allocate(sizeof(T), alignof(T));
+  return arena_ptr<T>(new (p) T(std::forward<Args>(args)...),
+                      arena_deleter<T>{r});
+}
+
+template <typename T, typename... Args>
+auto arena::create(Args&&... args) {
+  scope s(*this);
+  return make_arena_ptr<T>(std::forward<Args>(args)...);
+}
+
+}  // namespace struct_pb
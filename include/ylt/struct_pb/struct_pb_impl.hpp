@@ -14,14 +14,23 @@
  * limitations under the License.
  */
 #pragma once
+#include <bit>
 #include <cassert>
 #include <cstring>
 #include <map>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "ylt/struct_pb.hpp"
 
+#if !defined(STRUCT_PB_DISABLE_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#elif !defined(STRUCT_PB_DISABLE_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+#include <emmintrin.h>
+#endif
+
 namespace struct_pb {
 
 namespace internal {
@@ -101,6 +110,112 @@ STRUCT_PB_NODISCARD STRUCT_PB_INLINE std::size_t calculate_varint_size(
   v = val;
   return true;
 }
+
+// The packed repeated varints are decoded in bulk: the continuation bits of a
+// window of bytes are gathered to a bitmask by SIMD, which counts the varints
+// to resize the vector once, and finds the windows of one byte varints.
+// The window is 32 bytes with AVX2, 16 bytes with SSE2, and 8 bytes (SWAR)
+// otherwise.
+#if !defined(STRUCT_PB_DISABLE_SIMD) && defined(__AVX2__)
+constexpr std::size_t varint_window_size = 32;
+#elif !defined(STRUCT_PB_DISABLE_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+constexpr std::size_t varint_window_size = 16;
+#else
+constexpr std::size_t varint_window_size = 8;
+#endif
+
+STRUCT_PB_NODISCARD STRUCT_PB_INLINE uint64_t load_u64(const char* p) {
+  uint64_t x;
+  std::memcpy(&x, p, sizeof(x));
+  if constexpr (std::endian::native == std::endian::big) {
+    x = ((x & 0x00000000ffffffffull) << 32) | (x >> 32);
+    x = ((x & 0x0000ffff0000ffffull) << 16) |
+        ((x >> 16) & 0x0000ffff0000ffffull);
+    x = ((x & 0x00ff00ff00ff00ffull) << 8) | ((x >> 8) & 0x00ff00ff00ff00ffull);
+  }
+  return x;
+}
+
+// bit i is set if byte i of the window has the continuation bit.
+STRUCT_PB_NODISCARD STRUCT_PB_INLINE uint64_t
+varint_continuation_mask(const char* p) {
+#if !defined(STRUCT_PB_DISABLE_SIMD) && defined(__AVX2__)
+  return static_cast<uint32_t>(_mm256_movemask_epi8(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))));
+#elif !defined(STRUCT_PB_DISABLE_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+  return static_cast<uint32_t>(
+      _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+#else
+  uint64_t x = (load_u64(p) >> 7) & 0x0101010101010101ull;
+  return (x * 0x0102040810204080ull) >> 56;
+#endif
+}
+
+// Count the varints which end in [data, data + size).
+STRUCT_PB_NODISCARD inline std::size_t count_varints(const char* data,
+                                                     std::size_t size) {
+  constexpr uint64_t window_mask = (uint64_t{1} << varint_window_size) - 1;
+  std::size_t cnt = 0, i = 0;
+  for (; i + varint_window_size <= size; i += varint_window_size) {
+    cnt += std::popcount(~varint_continuation_mask(data + i) & window_mask);
+  }
+  for (; i < size; ++i) {
+    cnt += (static_cast<uint8_t>(data[i]) & 0x80U) == 0;
+  }
+  return cnt;
+}
+
+template <typename T, bool zigzag>
+STRUCT_PB_NODISCARD STRUCT_PB_INLINE T varint_cast(uint64_t v) {
+  if constexpr (zigzag) {
+    if constexpr (sizeof(T) == sizeof(uint32_t)) {
+      return static_cast<T>(decode_zigzag(static_cast<uint32_t>(v)));
+    }
+    else {
+      return static_cast<T>(decode_zigzag(v));
+    }
+  }
+  else {
+    return static_cast<T>(v);
+  }
+}
+
+/*
+ * Decode the packed varints in [pos, max_size) and append them to out, the
+ * values of sint32 and sint64 are decoded by zigzag. The varints are counted
+ * first to resize the vector once.
+ */
+template <bool zigzag = false, typename T, typename Alloc>
+STRUCT_PB_NODISCARD bool deserialize_packed_varint(const char* data,
+                                                   std::size_t& pos,
+                                                   std::size_t max_size,
+                                                   std::vector<T, Alloc>& out) {
+  std::size_t i = out.size();
+  std::size_t n = i + count_varints(data + pos, max_size - pos);
+  out.resize(n);
+  while (pos < max_size) {
+    if (max_size - pos >= varint_window_size &&
+        varint_continuation_mask(data + pos) == 0) {
+      // all bytes of the window are varints of one byte.
+      for (std::size_t k = 0; k < varint_window_size; ++k) {
+        out[i + k] =
+            varint_cast<T, zigzag>(static_cast<uint8_t>(data[pos + k]));
+      }
+      i += varint_window_size;
+      pos += varint_window_size;
+      continue;
+    }
+    uint64_t v = 0;
+    if (!decode_varint(data, pos, max_size, v)) [[unlikely]] {
+      return false;
+    }
+    out[i++] = varint_cast<T, zigzag>(v);
+  }
+  return i == n;
+}
+
 STRUCT_PB_INLINE void serialize_varint(char* const data, std::size_t& pos,
                                        std::size_t size, uint64_t v) {
   while (v >= 0x80) {
@@ -298,6 +298,11 @@ class coro_http_client : public std::enable_shared_from_this<coro_http_client> {
 
   bool has_closed() { return socket_->has_closed_; }
 
+  // whether a request failed in the transport rather than by its status.
+  static bool is_call_error(const resp_data &data) {
+    return static_cast<bool>(data.net_err);
+  }
+
   const auto &get_headers() { return req_headers_; }
 
   void set_headers(std::unordered_map<std::string, std::string> req_headers) {
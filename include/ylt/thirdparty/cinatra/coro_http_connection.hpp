@@ -20,6 +20,7 @@
 #include "websocket.hpp"
 #include "ylt/coro_io/coro_file.hpp"
 #include "ylt/coro_io/coro_io.hpp"
+#include "ylt/coro_io/timer_wheel.hpp"
 
 namespace cinatra {
 struct chunked_result {
@@ -51,7 +52,9 @@ class coro_http_connection
         socket_(std::move(socket)),
         router_(router),
         request_(parser_, this),
-        response_(this) {
+        response_(this),
+        timer_wheel_(
+            &coro_io::timer_wheel::get(executor->get_asio_executor())) {
     buffers_.reserve(3);
   }
 
@@ -646,7 +649,46 @@ class coro_http_connection
 
   void set_check_timeout(bool r) { checkout_timeout_ = r; }
 
+  // close the connection if it has no read or write in timeout_duration, the
+  // idle time is checked by the timer wheel of the connection's io_context.
+  void set_timeout_duration(std::chrono::steady_clock::duration duration) {
+    checkout_timeout_ = true;
+    timeout_duration_ = duration;
+    set_last_time();
+    arm_timeout(duration);
+  }
+
  private:
+  void arm_timeout(std::chrono::steady_clock::duration duration) {
+    timer_wheel_->add(duration,
+                      [weak = weak_from_this()](const std::error_code &ec) {
+                        if (ec) {
+                          return;
+                        }
+                        if (auto self = weak.lock()) {
+                          self->check_timeout();
+                        }
+                      });
+  }
+
+  void check_timeout() {
+    if (has_closed_) {
+      return;
+    }
+
+    auto idle_time = std::chrono::system_clock::now() - get_last_rwtime();
+    if (idle_time >= timeout_duration_) {
+      CINATRA_LOG_INFO << "close idle connection, id: " << conn_id_;
+      close();
+    }
+    else {
+      // there was io in the meantime, wait for the rest of the timeout.
+      arm_timeout(timeout_duration_ -
+                  std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                      idle_time));
+    }
+  }
+
   bool check_keep_alive() {
     bool keep_alive = true;
     auto val = request_.get_header_value("connection");
@@ -699,6 +741,8 @@ class coro_http_connection
   std::function<void(const uint64_t &conn_id)> quit_cb_ = nullptr;
   bool checkout_timeout_ = false;
   std::atomic<std::chrono::system_clock::time_point> last_rwtime_;
+  std::chrono::steady_clock::duration timeout_duration_{};
+  coro_io::timer_wheel *timer_wheel_;
   uint64_t max_part_size_ = 8 * 1024 * 1024;
 
   websocket ws_;
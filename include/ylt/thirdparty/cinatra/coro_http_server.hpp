@@ -25,13 +25,12 @@ enum class file_resp_format_type {
 class coro_http_server {
  public:
   coro_http_server(asio::io_context &ctx, unsigned short port)
-      : out_ctx_(&ctx), port_(port), acceptor_(ctx), check_timer_(ctx) {}
+      : out_ctx_(&ctx), port_(port), acceptor_(ctx) {}
 
   coro_http_server(size_t thread_num, unsigned short port)
       : pool_(std::make_unique<coro_io::io_context_pool>(thread_num)),
         port_(port),
-        acceptor_(pool_->get_executor()->get_asio_executor()),
-        check_timer_(pool_->get_executor()->get_asio_executor()) {}
+        acceptor_(pool_->get_executor()->get_asio_executor()) {}
 
   ~coro_http_server() {
     CINATRA_LOG_INFO << "coro_http_server will quit";
@@ -40,6 +39,18 @@ class coro_http_server {
 
   void set_no_delay(bool r) { no_delay_ = r; }
 
+  // pin the io threads to cpus and steer the connections to the threads on
+  // their NUMA node, call it before start.
+  void set_thread_affinity(const coro_io::thread_affinity_config &affinity) {
+    if (pool_) {
+      pool_->set_thread_affinity(affinity);
+    }
+  }
+
+  // open one SO_REUSEPORT acceptor per io thread, the kernel balances the
+  // connections between them. Only for linux, call it before start.
+  void set_reuse_port(bool r) { reuse_port_ = r; }
+
 #ifdef CINATRA_ENABLE_SSL
   void init_ssl(const std::string &cert_file, const std::string &key_file,
                 const std::string &passwd) {
@@ -71,14 +82,21 @@ class coro_http_server {
         });
       }
 
-      accept().start([p = std::move(promise)](auto &&res) mutable {
-        if (res.hasError()) {
-          p.setValue(std::errc::io_error);
-        }
-        else {
-          p.setValue(res.value());
-        }
-      });
+      accept(acceptor_,
+             reuse_port_acceptors_.empty() ? nullptr : pool_->get_executor(0))
+          .start([p = std::move(promise)](auto &&res) mutable {
+            if (res.hasError()) {
+              p.setValue(std::errc::io_error);
+            }
+            else {
+              p.setValue(res.value());
+            }
+          });
+      for (size_t i = 0; i < reuse_port_acceptors_.size(); ++i) {
+        accept(*reuse_port_acceptors_[i], pool_->get_executor(i + 1))
+            .start([](auto &&) {
+            });
+      }
     }
     else {
       promise.setValue(ec);
@@ -93,10 +111,6 @@ class coro_http_server {
       return;
     }
 
-    stop_timer_ = true;
-    std::error_code ec;
-    check_timer_.cancel(ec);
-
     close_acceptor();
 
     // close current connections.
@@ -330,14 +344,11 @@ class coro_http_server {
     }
   }
 
-  void set_check_duration(auto duration) { check_duration_ = duration; }
-
   void set_timeout_duration(
       std::chrono::steady_clock::duration timeout_duration) {
     if (timeout_duration > std::chrono::steady_clock::duration::zero()) {
       need_check_ = true;
       timeout_duration_ = timeout_duration;
-      start_check_timer();
     }
   }
 
@@ -355,6 +366,13 @@ class coro_http_server {
 #ifdef __GNUC__
     acceptor_.set_option(tcp::acceptor::reuse_address(true));
 #endif
+    bool reuse_port = false;
+    if (reuse_port_ && out_ctx_ == nullptr && pool_->pool_size() > 1) {
+      reuse_port = coro_io::set_reuse_port(acceptor_);
+      if (!reuse_port) {
+        CINATRA_LOG_WARNING << "SO_REUSEPORT is not supported, use one acceptor";
+      }
+    }
     asio::error_code ec;
     acceptor_.bind(endpoint, ec);
     if (ec) {
@@ -376,14 +394,61 @@ class coro_http_server {
     }
     port_ = end_point.port();
 
+    if (reuse_port) {
+      if (auto err = listen_reuse_port(); err != std::errc{}) {
+        return err;
+      }
+    }
+    accepting_cnt_ = 1 + reuse_port_acceptors_.size();
+
     CINATRA_LOG_INFO << "listen port " << port_ << " successfully";
     return {};
   }
 
-  async_simple::coro::Lazy<std::errc> accept() {
+  // every other io thread listens the same port by its own acceptor.
+  std::errc listen_reuse_port() {
+    using asio::ip::tcp;
+    auto endpoint = tcp::endpoint(tcp::v4(), port_);
+    for (size_t i = 1; i < pool_->pool_size(); ++i) {
+      auto acceptor = std::make_unique<tcp::acceptor>(
+          pool_->get_executor(i)->get_asio_executor());
+      asio::error_code ec;
+      acceptor->open(endpoint.protocol(), ec);
+      if (!ec) {
+        acceptor->set_option(tcp::acceptor::reuse_address(true), ec);
+        coro_io::set_reuse_port(*acceptor);
+        acceptor->bind(endpoint, ec);
+      }
+      if (!ec) {
+        acceptor->listen(asio::socket_base::max_listen_connections, ec);
+      }
+      if (ec) {
+        CINATRA_LOG_ERROR << "listen port: " << port_
+                          << " by SO_REUSEPORT error: " << ec.message();
+        acceptor->close(ec);
+        for (auto &acc : reuse_port_acceptors_) {
+          acc->close(ec);
+        }
+        reuse_port_acceptors_.clear();
+        acceptor_.close(ec);
+        return std::errc::address_in_use;
+      }
+      reuse_port_acceptors_.push_back(std::move(acceptor));
+    }
+    return {};
+  }
+
+  // accept the connections of `acceptor`, they run in `fixed_executor`, or
+  // the executors round-robin if it's nullptr.
+  async_simple::coro::Lazy<std::errc> accept(
+      asio::ip::tcp::acceptor &acceptor,
+      coro_io::ExecutorWrapper<> *fixed_executor) {
     for (;;) {
       coro_io::ExecutorWrapper<> *executor;
-      if (out_ctx_ == nullptr) {
+      if (fixed_executor != nullptr) {
+        executor = fixed_executor;
+      }
+      else if (out_ctx_ == nullptr) {
         executor = pool_->get_executor();
       }
       else {
@@ -393,16 +458,21 @@ class coro_http_server {
       }
 
       asio::ip::tcp::socket socket(executor->get_asio_executor());
-      auto error = co_await coro_io::async_accept(acceptor_, socket);
+      auto error = co_await coro_io::async_accept(acceptor, socket);
       if (error) {
         CINATRA_LOG_INFO << "accept failed, error: " << error.message();
         if (error == asio::error::operation_aborted ||
             error == asio::error::bad_descriptor) {
-          acceptor_close_waiter_.set_value();
+          if (--accepting_cnt_ == 0) {
+            acceptor_close_waiter_.set_value();
+          }
           co_return std::errc::operation_canceled;
         }
         continue;
       }
+      if (pool_ && pool_->numa_aware()) {
+        executor = coro_io::steer_to_numa_node(*pool_, socket, executor);
+      }
 
       uint64_t conn_id = ++conn_id_;
       CINATRA_LOG_DEBUG << "new connection comming, id: " << conn_id;
@@ -412,7 +482,7 @@ class coro_http_server {
         conn->tcp_socket().set_option(asio::ip::tcp::no_delay(true));
       }
       if (need_check_) {
-        conn->set_check_timeout(true);
+        conn->set_timeout_duration(timeout_duration_);
       }
 
 #ifdef CINATRA_ENABLE_SSL
@@ -444,45 +514,18 @@ class coro_http_server {
   }
 
   void close_acceptor() {
-    asio::dispatch(acceptor_.get_executor(), [this]() {
-      asio::error_code ec;
-      acceptor_.cancel(ec);
-      acceptor_.close(ec);
-    });
-    acceptor_close_waiter_.get_future().wait();
-  }
-
-  void start_check_timer() {
-    check_timer_.expires_after(check_duration_);
-    check_timer_.async_wait([this](auto ec) {
-      if (ec || stop_timer_) {
-        return;
-      }
-
-      check_timeout();
-      start_check_timer();
-    });
-  }
-
-  void check_timeout() {
-    auto cur_time = std::chrono::system_clock::now();
-
-    std::unordered_map<uint64_t, std::shared_ptr<coro_http_connection>> conns;
-
-    {
-      std::scoped_lock lock(conn_mtx_);
-      for (auto it = connections_.begin();
-           it != connections_.end();)  // no "++"!
-      {
-        if (cur_time - it->second->get_last_rwtime() > timeout_duration_) {
-          it->second->close(false);
-          connections_.erase(it++);
-        }
-        else {
-          ++it;
-        }
-      }
+    auto close = [](asio::ip::tcp::acceptor &acceptor) {
+      asio::dispatch(acceptor.get_executor(), [&acceptor]() {
+        asio::error_code ec;
+        acceptor.cancel(ec);
+        acceptor.close(ec);
+      });
+    };
+    close(acceptor_);
+    for (auto &acceptor : reuse_port_acceptors_) {
+      close(*acceptor);
     }
+    acceptor_close_waiter_.get_future().wait();
   }
 
   std::string build_range_header(std::string_view mime,
@@ -505,6 +548,10 @@ class coro_http_server {
   std::unique_ptr<coro_io::ExecutorWrapper<>> out_executor_ = nullptr;
   uint16_t port_;
   asio::ip::tcp::acceptor acceptor_;
+  // the acceptors of the other io threads in SO_REUSEPORT mode.
+  std::vector<std::unique_ptr<asio::ip::tcp::acceptor>> reuse_port_acceptors_;
+  std::atomic<size_t> accepting_cnt_ = 0;
+  bool reuse_port_ = false;
   std::thread thd_;
   std::promise<void> acceptor_close_waiter_;
   bool no_delay_ = true;
@@ -513,12 +560,8 @@ class coro_http_server {
   std::unordered_map<uint64_t, std::shared_ptr<coro_http_connection>>
       connections_;
   std::mutex conn_mtx_;
-  std::chrono::steady_clock::duration check_duration_ =
-      std::chrono::seconds(15);
   std::chrono::steady_clock::duration timeout_duration_{};
-  asio::steady_timer check_timer_;
   bool need_check_ = false;
-  std::atomic<bool> stop_timer_ = false;
 
   std::string static_dir_router_path_ = "";
   std::string static_dir_ = "";
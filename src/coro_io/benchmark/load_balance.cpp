@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <async_simple/coro/Collect.h>
+#include <async_simple/coro/Lazy.h>
+#include <async_simple/coro/SyncAwait.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ylt/coro_io/channel.hpp>
+#include <ylt/coro_rpc/coro_rpc_client.hpp>
+#include <ylt/coro_rpc/coro_rpc_server.hpp>
+
+// Simulate a group of hosts where one of them is slow, and compare the request
+// latency of the load balance algorithms of coro_io::channel. Then check the
+// key affinity of consistent_hash: the share of keys which move to another
+// host when a host is removed.
+//
+// usage: coro_io_benchmark_load_balance [concurrency] [requests per worker]
+
+using namespace async_simple::coro;
+using namespace std::chrono;
+
+struct host_sim {
+  microseconds delay;
+  Lazy<void> handle() { co_await coro_io::sleep_for(delay); }
+};
+
+struct bench_config {
+  std::size_t host_num = 4;
+  microseconds normal_delay{1000};
+  microseconds slow_delay{20000};
+  std::size_t concurrency = 32;
+  std::size_t request_num = 100;
+};
+
+using channel_t = coro_io::channel<coro_rpc::coro_rpc_client>;
+
+Lazy<void> worker(channel_t &channel, std::size_t request_num,
+                  std::vector<int64_t> &latencies, std::string_view slow_host,
+                  std::atomic<std::size_t> &slow_cnt) {
+  for (std::size_t i = 0; i < request_num; ++i) {
+    auto start = steady_clock::now();
+    auto ret = co_await channel.send_request(
+        [&](coro_rpc::coro_rpc_client &client,
+            std::string_view host) -> Lazy<void> {
+          if (host == slow_host) {
+            ++slow_cnt;
+          }
+          auto result = co_await client.call<&host_sim::handle>();
+          if (!result) {
+            std::cout << "call failed: " << result.error().msg << std::endl;
+          }
+        });
+    if (!ret) {
+      std::cout << "send request failed" << std::endl;
+    }
+    latencies.push_back(
+        duration_cast<microseconds>(steady_clock::now() - start).count());
+  }
+}
+
+void bench_lba(const char *name, coro_io::load_blance_algorithm lba,
+               const std::vector<std::string_view> &hosts,
+               const bench_config &conf) {
+  // use a private client_pools, so that the latency of the hosts measured by
+  // the former algorithms is not reused.
+  coro_io::client_pools<coro_rpc::coro_rpc_client> client_pools;
+  auto channel = channel_t::create(hosts, {.lba = lba}, client_pools);
+  std::vector<std::vector<int64_t>> latencies(conf.concurrency);
+  std::atomic<std::size_t> slow_cnt = 0;
+  std::vector<Lazy<void>> workers;
+  for (std::size_t i = 0; i < conf.concurrency; ++i) {
+    workers.push_back(
+        worker(channel, conf.request_num, latencies[i], hosts[0], slow_cnt));
+  }
+  syncAwait([](std::vector<Lazy<void>> workers) -> Lazy<void> {
+    co_await collectAll(std::move(workers));
+  }(std::move(workers)));
+
+  std::vector<int64_t> all;
+  for (auto &v : latencies) {
+    all.insert(all.end(), v.begin(), v.end());
+  }
+  std::sort(all.begin(), all.end());
+  auto percentile = [&](double p) {
+    return all[std::min(all.size() - 1, std::size_t(all.size() * p))];
+  };
+  std::cout << name << ": p50 " << percentile(0.5) << "us, p99 "
+            << percentile(0.99) << "us, max " << all.back()
+            << "us, share of the slow host "
+            << 100.0 * slow_cnt / all.size() << "%\n";
+}
+
+Lazy<std::vector<std::string>> route_keys(channel_t &channel,
+                                          std::size_t key_num) {
+  std::vector<std::string> routes;
+  for (std::size_t i = 0; i < key_num; ++i) {
+    co_await channel.send_request(
+        [&](coro_rpc::coro_rpc_client &, std::string_view host) -> Lazy<void> {
+          routes.emplace_back(host);
+          co_return;
+        },
+        "key" + std::to_string(i));
+  }
+  co_return routes;
+}
+
+void bench_consistent_hash(const std::vector<std::string_view> &hosts) {
+  constexpr std::size_t key_num = 2000;
+  coro_io::client_pools<coro_rpc::coro_rpc_client> client_pools;
+  auto all_hosts = channel_t::create(
+      hosts, {.lba = coro_io::load_blance_algorithm::consistent_hash},
+      client_pools);
+  auto less_hosts = channel_t::create(
+      {hosts.begin(), hosts.end() - 1},
+      {.lba = coro_io::load_blance_algorithm::consistent_hash}, client_pools);
+  auto routes1 = syncAwait(route_keys(all_hosts, key_num));
+  auto routes2 = syncAwait(route_keys(less_hosts, key_num));
+
+  std::map<std::string, std::size_t> host_cnt;
+  std::size_t moved = 0;
+  for (std::size_t i = 0; i < key_num; ++i) {
+    ++host_cnt[routes1[i]];
+    moved += routes1[i] != routes2[i];
+  }
+  std::cout << "consistent_hash: keys per host";
+  for (auto &[host, cnt] : host_cnt) {
+    std::cout << " " << cnt;
+  }
+  std::cout << ", moved " << 100.0 * moved / key_num
+            << "% of keys after removing 1 of " << hosts.size() << " hosts\n";
+}
+
+int main(int argc, char **argv) {
+  bench_config conf;
+  if (argc > 1) {
+    conf.concurrency = std::atoi(argv[1]);
+  }
+  if (argc > 2) {
+    conf.request_num = std::atoi(argv[2]);
+  }
+
+  std::vector<std::unique_ptr<host_sim>> sims;
+  std::vector<std::unique_ptr<coro_rpc::coro_rpc_server>> servers;
+  std::vector<std::string> host_names;
+  for (std::size_t i = 0; i < conf.host_num; ++i) {
+    sims.push_back(std::make_unique<host_sim>(
+        host_sim{i == 0 ? conf.slow_delay : conf.normal_delay}));
+    auto &server =
+        servers.emplace_back(std::make_unique<coro_rpc::coro_rpc_server>(1, 0));
+    server->register_handler<&host_sim::handle>(sims.back().get());
+    if (!server->async_start()) {
+      std::cout << "server start failed" << std::endl;
+      return 1;
+    }
+    host_names.push_back("127.0.0.1:" + std::to_string(server->port()));
+  }
+  std::vector<std::string_view> hosts(host_names.begin(), host_names.end());
+
+  std::cout << "hosts " << conf.host_num << ", slow host delay "
+            << conf.slow_delay.count() << "us, others "
+            << conf.normal_delay.count() << "us, concurrency "
+            << conf.concurrency << ", requests per worker " << conf.request_num
+            << "\n";
+  bench_lba("RR", coro_io::load_blance_algorithm::RR, hosts, conf);
+  bench_lba("random", coro_io::load_blance_algorithm::random, hosts, conf);
+  bench_lba("least_loaded", coro_io::load_blance_algorithm::least_loaded,
+            hosts, conf);
+  bench_consistent_hash(hosts);
+
+  for (auto &server : servers) {
+    server->stop();
+  }
+  return 0;
+}
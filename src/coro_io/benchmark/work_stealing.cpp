@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <ylt/coro_io/io_context_pool.hpp>
+
+// Skewed load: all the tasks come from one hot executor (like a busy
+// connection), one of ten tasks is heavy. io_context_pool runs them all in the
+// thread of the hot executor, work_stealing_context_pool lets the idle threads
+// steal them.
+
+using namespace std::chrono;
+
+struct bench_config {
+  std::size_t thread_num = 4;
+  std::size_t task_num = 5000;
+  microseconds interval{20};
+  microseconds light_cost{10};
+  microseconds heavy_cost{300};
+};
+
+void spin_for(microseconds cost) {
+  auto end = steady_clock::now() + cost;
+  while (steady_clock::now() < end)
+    ;
+}
+
+template <typename Schedule>
+std::vector<int64_t> run_load(const bench_config &conf, Schedule schedule) {
+  std::vector<int64_t> latencies(conf.task_num);
+  std::atomic<std::size_t> finished = 0;
+  std::promise<void> promise;
+  auto next = steady_clock::now();
+  for (std::size_t i = 0; i < conf.task_num; ++i) {
+    next += conf.interval;
+    std::this_thread::sleep_until(next);
+    auto cost = i % 10 == 0 ? conf.heavy_cost : conf.light_cost;
+    schedule([&, i, cost, start = steady_clock::now()] {
+      spin_for(cost);
+      latencies[i] =
+          duration_cast<microseconds>(steady_clock::now() - start).count();
+      if (++finished == conf.task_num) {
+        promise.set_value();
+      }
+    });
+  }
+  promise.get_future().wait();
+  std::sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+void print_result(const char *name, const std::vector<int64_t> &latencies,
+                  std::size_t steal_cnt) {
+  auto percentile = [&](double p) {
+    return latencies[std::min(latencies.size() - 1,
+                              std::size_t(latencies.size() * p))];
+  };
+  std::cout << name << ": p50 " << percentile(0.5) << "us, p99 "
+            << percentile(0.99) << "us, p999 " << percentile(0.999)
+            << "us, max " << latencies.back() << "us, stolen " << steal_cnt
+            << "\n";
+}
+
+void bench_io_context_pool(const bench_config &conf) {
+  coro_io::io_context_pool pool(conf.thread_num);
+  std::thread thd([&pool] {
+    pool.run();
+  });
+  auto *hot_executor = pool.get_executor();
+  auto latencies = run_load(conf, [&](auto task) {
+    hot_executor->schedule(std::move(task));
+  });
+  print_result("io_context_pool", latencies, 0);
+  pool.stop();
+  thd.join();
+}
+
+void bench_work_stealing_context_pool(const bench_config &conf) {
+  coro_io::work_stealing_context_pool pool(conf.thread_num);
+  std::thread thd([&pool] {
+    pool.run();
+  });
+  auto *hot_executor = pool.get_executor();
+  auto latencies = run_load(conf, [&](auto task) {
+    // offload the task from the hot thread, like a handler does.
+    hot_executor->schedule([&pool, task = std::move(task)]() mutable {
+      pool.get_cpu_executor()->schedule(std::move(task));
+    });
+  });
+  print_result("work_stealing_context_pool", latencies, pool.steal_count());
+  pool.stop();
+  thd.join();
+}
+
+int main(int argc, char **argv) {
+  bench_config conf;
+  if (argc > 1) {
+    conf.thread_num = std::atoi(argv[1]);
+  }
+  if (argc > 2) {
+    conf.task_num = std::atoi(argv[2]);
+  }
+  if (argc > 3) {
+    conf.interval = microseconds(std::atoi(argv[3]));
+  }
+  std::cout << "threads " << conf.thread_num << ", tasks " << conf.task_num
+            << ", interval " << conf.interval.count() << "us, light "
+            << conf.light_cost.count() << "us, heavy "
+            << conf.heavy_cost.count() << "us\n";
+  bench_io_context_pool(conf);
+  bench_work_stealing_context_pool(conf);
+  return 0;
+}
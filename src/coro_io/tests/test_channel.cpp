@@ -7,9 +7,12 @@
 #include <filesystem>
 #include <fstream>
 #include <memory>
+#include <set>
+#include <string>
 #include <string_view>
 #include <system_error>
 #include <thread>
+#include <unordered_map>
 #include <ylt/coro_io/channel.hpp>
 #include <ylt/coro_io/coro_file.hpp>
 #include <ylt/coro_io/coro_io.hpp>
@@ -110,4 +113,204 @@ TEST_CASE("test send_request config") {
     }
     server.stop();
   }());
-}
\ No newline at end of file
+}
+TEST_CASE("test least loaded") {
+  async_simple::coro::syncAwait([]() -> async_simple::coro::Lazy<void> {
+    coro_rpc::coro_rpc_server server(1, 8801);
+    auto res = server.async_start();
+    REQUIRE_MESSAGE(res, "server start failed");
+    auto hosts =
+        std::vector<std::string_view>{"127.0.0.1:8801", "localhost:8801"};
+    auto channel = coro_io::channel<coro_rpc::coro_rpc_client>::create(
+        hosts, {.lba = coro_io::load_blance_algorithm::least_loaded});
+    int slow_cnt = 0;
+    for (int i = 0; i < 20; ++i) {
+      auto res = co_await channel.send_request(
+          [&](coro_rpc::coro_rpc_client &client,
+              std::string_view host) -> async_simple::coro::Lazy<void> {
+            if (host == hosts[0]) {
+              ++slow_cnt;
+              co_await coro_io::sleep_for(std::chrono::milliseconds(50));
+            }
+            co_return;
+          });
+      CHECK(res.has_value());
+    }
+    // the slow host is avoided once its latency is known.
+    CHECK(slow_cnt <= 2);
+    server.stop();
+  }());
+}
+
+TEST_CASE("test consistent hash") {
+  async_simple::coro::syncAwait([]() -> async_simple::coro::Lazy<void> {
+    coro_rpc::coro_rpc_server server(1, 8801);
+    auto res = server.async_start();
+    REQUIRE_MESSAGE(res, "server start failed");
+    auto hosts = std::vector<std::string_view>{
+        "127.0.0.1:8801", "localhost:8801", "0.0.0.0:8801"};
+    auto channel = coro_io::channel<coro_rpc::coro_rpc_client>::create(
+        hosts, {.lba = coro_io::load_blance_algorithm::consistent_hash});
+    std::unordered_map<std::string, std::string> key_hosts;
+    std::set<std::string> used_hosts;
+    for (int i = 0; i < 100; ++i) {
+      auto key = "key" + std::to_string(i % 20);
+      auto res = co_await channel.send_request(
+          [&](coro_rpc::coro_rpc_client &client,
+              std::string_view host) -> async_simple::coro::Lazy<void> {
+            auto [iter, ok] = key_hosts.emplace(key, host);
+            CHECK(iter->second == host);
+            used_hosts.emplace(host);
+            co_return;
+          },
+          key);
+      CHECK(res.has_value());
+    }
+    CHECK(used_hosts.size() > 1);
+    server.stop();
+  }());
+}
+
+TEST_CASE("test outlier ejection") {
+  async_simple::coro::syncAwait([]() -> async_simple::coro::Lazy<void> {
+    coro_rpc::coro_rpc_server server(1, 8801);
+    auto res = server.async_start();
+    REQUIRE_MESSAGE(res, "server start failed");
+    // nothing listens on 8898.
+    auto hosts =
+        std::vector<std::string_view>{"127.0.0.1:8801", "127.0.0.1:8898"};
+    coro_io::client_pools<coro_rpc::coro_rpc_client> client_pools;
+    auto channel = coro_io::channel<coro_rpc::coro_rpc_client>::create(
+        hosts,
+        {.pool_config = {.connect_retry_count = 0,
+                         .max_consecutive_failures = 2,
+                         .base_ejection_time = std::chrono::milliseconds(300)},
+         .lba = coro_io::load_blance_algorithm::RR},
+        client_pools);
+    auto send = [&]() -> async_simple::coro::Lazy<int> {
+      int failed_cnt = 0;
+      for (int i = 0; i < 20; ++i) {
+        auto res = co_await channel.send_request(
+            [](coro_rpc::coro_rpc_client &client,
+               std::string_view host) -> async_simple::coro::Lazy<void> {
+              co_return;
+            });
+        failed_cnt += !res.has_value();
+      }
+      co_return failed_cnt;
+    };
+    // the bad host is ejected after 2 failures.
+    int failed_cnt = co_await send();
+    CHECK(failed_cnt == 2);
+    auto bad_pool = client_pools.at(hosts[1]);
+    CHECK(bad_pool->is_ejected());
+    CHECK(bad_pool->consecutive_failures() == 2);
+    CHECK(!client_pools.at(hosts[0])->is_ejected());
+
+    // only one probe is sent after the ejection time, which fails again.
+    co_await coro_io::sleep_for(std::chrono::milliseconds(400));
+    failed_cnt = co_await send();
+    CHECK(failed_cnt == 1);
+    CHECK(bad_pool->is_ejected());
+    server.stop();
+  }());
+}
+
+TEST_CASE("test only the probe re-admits an ejected host") {
+  async_simple::coro::syncAwait([]() -> async_simple::coro::Lazy<void> {
+    using namespace std::chrono_literals;
+    coro_rpc::coro_rpc_server server(1, 8801);
+    auto res = server.async_start();
+    REQUIRE_MESSAGE(res, "server start failed");
+    // both hosts are the same server, the requests fail by closing the
+    // client.
+    auto hosts =
+        std::vector<std::string_view>{"127.0.0.1:8801", "localhost:8801"};
+    coro_io::client_pools<coro_rpc::coro_rpc_client> client_pools;
+    auto channel = coro_io::channel<coro_rpc::coro_rpc_client>::create(
+        hosts,
+        {.pool_config = {.max_consecutive_failures = 2,
+                         .base_ejection_time = 100ms},
+         .lba = coro_io::load_blance_algorithm::consistent_hash},
+        client_pools);
+    auto send = [&](std::string_view key, std::chrono::milliseconds cost,
+                    bool fail) -> async_simple::coro::Lazy<std::string> {
+      auto res = co_await channel.send_request(
+          [cost, fail](coro_rpc::coro_rpc_client &client, std::string_view host)
+              -> async_simple::coro::Lazy<std::string> {
+            if (cost.count() > 0) {
+              co_await coro_io::sleep_for(cost);
+            }
+            if (fail) {
+              client.close();
+            }
+            co_return std::string{host};
+          },
+          key);
+      co_return res.has_value() ? res.value() : std::string{};
+    };
+    // find a key of the second host.
+    std::string key;
+    for (int i = 0; i < 100 && key.empty(); ++i) {
+      auto k = "key" + std::to_string(i);
+      if (co_await send(k, 0ms, false) == hosts[1]) {
+        key = k;
+      }
+    }
+    REQUIRE(!key.empty());
+    auto pool = client_pools.at(hosts[1]);
+
+    auto eject_and_probe = [&]() -> async_simple::coro::Lazy<void> {
+      co_await send(key, 0ms, true);
+      co_await send(key, 0ms, true);
+      CHECK(pool->is_ejected());
+      // the probe is in flight when the slow request succeeds.
+      co_await coro_io::sleep_for(150ms);
+      co_await send(key, 300ms, true);
+    };
+    // a slow request which is sent before the ejection and succeeds later
+    // doesn't re-admit the host.
+    co_await async_simple::coro::collectAll(send(key, 300ms, false),
+                                            eject_and_probe());
+    // the failed probe ejects the host again.
+    CHECK(pool->is_ejected());
+    server.stop();
+  }());
+}
+
+TEST_CASE("test call errors count toward ejection") {
+  async_simple::coro::syncAwait([]() -> async_simple::coro::Lazy<void> {
+    using result_t =
+        coro_rpc::rpc_result<void, coro_rpc::protocol::coro_rpc_protocol>;
+    coro_rpc::coro_rpc_server server(1, 8801);
+    auto res = server.async_start();
+    REQUIRE_MESSAGE(res, "server start failed");
+    auto hosts = std::vector<std::string_view>{"127.0.0.1:8801"};
+    coro_io::client_pools<coro_rpc::coro_rpc_client> client_pools;
+    auto channel = coro_io::channel<coro_rpc::coro_rpc_client>::create(
+        hosts, {.pool_config = {.max_consecutive_failures = 2}},
+        client_pools);
+    // the client stays open, only the result of the call fails.
+    auto send = [&](coro_rpc::errc ec) -> async_simple::coro::Lazy<void> {
+      co_await channel.send_request(
+          [ec](coro_rpc::coro_rpc_client &client,
+               std::string_view host) -> async_simple::coro::Lazy<result_t> {
+            if (!ec) {
+              co_return result_t{};
+            }
+            co_return result_t{coro_rpc::unexpect_t{},
+                               coro_rpc::rpc_error{ec, "failed"}};
+          });
+    };
+    auto pool = client_pools.at(hosts[0]);
+    // an error returned by the server is not a failure of the host.
+    co_await send(coro_rpc::errc::function_not_registered);
+    CHECK(pool->consecutive_failures() == 0);
+    co_await send(coro_rpc::errc::timed_out);
+    CHECK(pool->consecutive_failures() == 1);
+    CHECK(!pool->is_ejected());
+    co_await send(coro_rpc::errc::io_error);
+    CHECK(pool->is_ejected());
+    server.stop();
+  }());
+}
@@ -0,0 +1,177 @@
+#include <async_simple/coro/Lazy.h>
+#include <async_simple/coro/SyncAwait.h>
+#include <doctest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <ylt/coro_io/coro_io.hpp>
+#include <ylt/coro_io/io_context_pool.hpp>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("test work_stealing_context_pool steal tasks") {
+  coro_io::work_stealing_context_pool pool(2);
+  std::thread thd([&pool] {
+    pool.run();
+  });
+
+  constexpr int task_cnt = 10;
+  std::atomic<int> finished = 0;
+  std::promise<void> promise;
+  auto *busy_executor = pool.get_executor();
+  busy_executor->schedule([&] {
+    // the tasks are queued in this thread, which is kept busy, so the other
+    // thread has to steal them.
+    for (int i = 0; i < task_cnt; ++i) {
+      pool.get_cpu_executor()->schedule([&] {
+        CHECK(!busy_executor->currentThreadInExecutor());
+        if (++finished == task_cnt) {
+          promise.set_value();
+        }
+      });
+    }
+    std::this_thread::sleep_for(300ms);
+  });
+  CHECK(promise.get_future().wait_for(10s) == std::future_status::ready);
+  CHECK(pool.steal_count() == task_cnt);
+
+  auto lazy = [&]() -> async_simple::coro::Lazy<int> {
+    CHECK(pool.get_cpu_executor()->currentThreadInExecutor());
+    co_return 42;
+  };
+  CHECK(async_simple::coro::syncAwait(lazy().via(pool.get_cpu_executor())) ==
+        42);
+
+  pool.stop();
+  thd.join();
+  CHECK(pool.has_stop());
+}
+
+TEST_CASE("test work_stealing_context_pool io executor") {
+  coro_io::work_stealing_context_pool pool(2);
+  std::thread thd([&pool] {
+    pool.run();
+  });
+  auto *executor = pool.get_executor();
+  auto lazy = [&]() -> async_simple::coro::Lazy<bool> {
+    co_await coro_io::sleep_for(10ms, executor);
+    co_return executor->currentThreadInExecutor();
+  };
+  CHECK(async_simple::coro::syncAwait(lazy().via(executor)));
+  pool.stop();
+  thd.join();
+}
+
+TEST_CASE("test parse cpu list") {
+  CHECK(coro_io::detail::parse_cpu_list("0-3,8,10-11\n") ==
+        std::vector<int>{0, 1, 2, 3, 8, 10, 11});
+  CHECK(coro_io::detail::parse_cpu_list("").empty());
+  CHECK(coro_io::detail::parse_cpu_list("5") == std::vector<int>{5});
+}
+
+namespace {
+// a cpu which this process may run on.
+int get_allowed_cpu() {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        return cpu;
+      }
+    }
+  }
+#endif
+  return 0;
+}
+}  // namespace
+
+TEST_CASE("test io_context_pool thread affinity") {
+  int cpu = get_allowed_cpu();
+  coro_io::thread_affinity_config affinity;
+  affinity.cpus = {{cpu}};
+  affinity.numa_aware = true;
+  coro_io::io_context_pool pool(2, affinity);
+  std::thread thd([&pool] {
+    pool.run();
+  });
+
+  auto *executor = pool.get_executor();
+  std::promise<int> promise;
+  executor->schedule([&promise, cpu] {
+#if defined(__linux__)
+    promise.set_value(sched_getcpu());
+#else
+    promise.set_value(cpu);
+#endif
+  });
+  CHECK(promise.get_future().get() == cpu);
+
+  // the cpu of unknown node falls back to round-robin.
+  CHECK(pool.get_executor_by_cpu(-1) != nullptr);
+  if (pool.numa_aware()) {
+    auto node = pool.get_numa_node(cpu);
+    CHECK(node >= 0);
+    CHECK(pool.get_numa_node(executor) == node);
+    CHECK(pool.get_executor_by_cpu(cpu) != nullptr);
+  }
+  pool.stop();
+  thd.join();
+}
+
+TEST_CASE("test steer accepted socket to numa node") {
+  coro_io::io_context_pool pool(2);
+  std::thread thd([&pool] {
+    pool.run();
+  });
+  auto *accept_executor = pool.get_executor(0);
+  // every cpu is on node 0, whose thread is the other one.
+  struct one_node_pool {
+    coro_io::ExecutorWrapper<> *local_executor;
+    int picks = 0;
+    int get_numa_node(int) const noexcept { return 0; }
+    int get_numa_node(const coro_io::ExecutorWrapper<> *e) const noexcept {
+      return e == local_executor ? 0 : 1;
+    }
+    coro_io::ExecutorWrapper<> *get_executor_by_cpu(int) noexcept {
+      ++picks;
+      return local_executor;
+    }
+  } node_pool{pool.get_executor(1)};
+
+  asio::ip::tcp::acceptor acceptor(
+      accept_executor->get_asio_executor(),
+      asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+  asio::ip::tcp::socket client(accept_executor->get_asio_executor());
+  client.connect(acceptor.local_endpoint());
+  asio::ip::tcp::socket socket(accept_executor->get_asio_executor());
+  acceptor.accept(socket);
+
+  if (coro_io::get_incoming_cpu(socket) < 0) {
+    MESSAGE("SO_INCOMING_CPU is not supported, skip");
+  }
+  else {
+    auto *executor =
+        coro_io::steer_to_numa_node(node_pool, socket, accept_executor);
+    CHECK(executor == node_pool.local_executor);
+    CHECK(node_pool.picks == 1);
+    // the socket is on its node already, no executor is picked again.
+    CHECK(coro_io::steer_to_numa_node(node_pool, socket, executor) ==
+          executor);
+    CHECK(node_pool.picks == 1);
+    auto lazy = [&]() -> async_simple::coro::Lazy<bool> {
+      // the socket is served by the io_context of the local executor.
+      char buf[5];
+      auto [ec, size] = co_await coro_io::async_read(socket, asio::buffer(buf));
+      co_return !ec && std::string_view(buf, size) == "hello" &&
+          executor->currentThreadInExecutor();
+    };
+    asio::write(client, asio::buffer("hello", 5));
+    CHECK(async_simple::coro::syncAwait(lazy().via(executor)));
+  }
+  pool.stop();
+  thd.join();
+}
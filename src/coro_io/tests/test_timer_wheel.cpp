@@ -0,0 +1,164 @@
+#include <doctest.h>
+
+#include <asio/executor_work_guard.hpp>
+#include <asio/io_context.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <ylt/coro_http/coro_http_server.hpp>
+#include <ylt/coro_io/timer_wheel.hpp>
+
+using namespace std::chrono_literals;
+
+namespace {
+struct wheel_runner {
+  wheel_runner() : guard(ctx.get_executor()), thd([this] {
+    ctx.run();
+  }) {}
+  ~wheel_runner() {
+    guard.reset();
+    ctx.stop();
+    thd.join();
+  }
+  asio::io_context ctx;
+  asio::executor_work_guard<asio::io_context::executor_type> guard;
+  std::thread thd;
+};
+}  // namespace
+
+TEST_CASE("test timer wheel is per io_context") {
+  asio::io_context ctx1, ctx2;
+  auto &wheel1 = coro_io::timer_wheel::get(ctx1);
+  CHECK(&wheel1 == &coro_io::timer_wheel::get(ctx1.get_executor()));
+  CHECK(&wheel1 != &coro_io::timer_wheel::get(ctx2));
+}
+
+TEST_CASE("test timer wheel expire in order") {
+  wheel_runner runner;
+  auto &wheel = coro_io::timer_wheel::get(runner.ctx);
+
+  std::mutex mtx;
+  std::vector<int> fired;
+  std::promise<void> promise;
+  auto start = std::chrono::steady_clock::now();
+  // 800ms is beyond the first level, it has to be cascaded down.
+  std::vector<std::chrono::milliseconds> timeouts = {800ms, 30ms, 100ms};
+  for (int i = 0; i < (int)timeouts.size(); ++i) {
+    wheel.add(timeouts[i], [&, i](const std::error_code &ec) {
+      CHECK(!ec);
+      CHECK(runner.ctx.get_executor().running_in_this_thread());
+      CHECK(std::chrono::steady_clock::now() - start >= timeouts[i]);
+      std::lock_guard lock(mtx);
+      fired.push_back(i);
+      if (fired.size() == timeouts.size()) {
+        promise.set_value();
+      }
+    });
+  }
+  CHECK(wheel.size() == 3);
+  CHECK(promise.get_future().wait_for(5s) == std::future_status::ready);
+  CHECK(fired == std::vector<int>{1, 2, 0});
+  CHECK(wheel.size() == 0);
+}
+
+TEST_CASE("test timer wheel cancel") {
+  wheel_runner runner;
+  auto &wheel = coro_io::timer_wheel::get(runner.ctx);
+
+  std::atomic<int> fired = 0;
+  auto id1 = wheel.add(50ms, [&](const std::error_code &) {
+    ++fired;
+  });
+  auto id2 = wheel.add(2s, [&](const std::error_code &) {
+    ++fired;
+  });
+  CHECK(wheel.cancel(id1));
+  CHECK(!wheel.cancel(id1));
+  CHECK(wheel.cancel(id2));
+  CHECK(wheel.size() == 0);
+
+  // the slot of a cancelled timeout is reused, the stale id mustn't cancel it.
+  std::promise<void> promise;
+  auto id3 = wheel.add(20ms, [&](const std::error_code &) {
+    promise.set_value();
+  });
+  CHECK(id3.index == id2.index);
+  CHECK(!wheel.cancel(id2));
+  CHECK(promise.get_future().wait_for(5s) == std::future_status::ready);
+  CHECK(!wheel.cancel(id3));
+
+  std::this_thread::sleep_for(100ms);
+  CHECK(fired == 0);
+}
+
+TEST_CASE("test timer wheel rearm in callback") {
+  wheel_runner runner;
+  auto &wheel = coro_io::timer_wheel::get(runner.ctx);
+
+  std::atomic<int> count = 0;
+  std::promise<void> promise;
+  coro_io::timer_wheel::callback_type callback =
+      [&](const std::error_code &) {
+        if (++count == 5) {
+          promise.set_value();
+          return;
+        }
+        wheel.add(10ms, callback);
+      };
+  wheel.add(10ms, callback);
+  CHECK(promise.get_future().wait_for(5s) == std::future_status::ready);
+  CHECK(count == 5);
+}
+
+TEST_CASE("test timer wheel aborts pending timeouts on shutdown") {
+  std::vector<std::error_code> results;
+  {
+    asio::io_context ctx;
+    auto &wheel = coro_io::timer_wheel::get(ctx);
+    for (int i = 0; i < 2; ++i) {
+      wheel.add(1s, [&results](const std::error_code &ec) {
+        results.push_back(ec);
+      });
+    }
+    auto id = wheel.add(1s, [&results](const std::error_code &ec) {
+      results.push_back(ec);
+    });
+    CHECK(wheel.cancel(id));
+  }
+  // the cancelled one isn't invoked.
+  REQUIRE(results.size() == 2);
+  for (auto &ec : results) {
+    CHECK(ec == asio::error::operation_aborted);
+  }
+}
+
+TEST_CASE("test idle http connection expires through the wheel") {
+  cinatra::coro_http_server server(1, 0);
+  server.set_timeout_duration(100ms);
+  auto started = server.async_start();
+  REQUIRE(!started.hasResult());
+
+  asio::io_context ctx;
+  asio::ip::tcp::socket socket(ctx);
+  socket.connect(
+      asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), server.port()));
+  auto wait_for_count = [&server](std::size_t count) {
+    for (int i = 0; i < 200 && server.connection_count() != count; ++i) {
+      std::this_thread::sleep_for(10ms);
+    }
+    return server.connection_count() == count;
+  };
+  CHECK(wait_for_count(1));
+  // the server closes the idle connection without any request.
+  auto begin = std::chrono::steady_clock::now();
+  char c;
+  std::error_code ec;
+  socket.read_some(asio::buffer(&c, 1), ec);
+  CHECK(ec);
+  CHECK(std::chrono::steady_clock::now() - begin < 1s);
+  CHECK(wait_for_count(0));
+  server.stop();
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <async_simple/coro/Collect.h>
+#include <async_simple/coro/Lazy.h>
+#include <async_simple/coro/SyncAwait.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ylt/coro_rpc/coro_rpc_client.hpp>
+#include <ylt/coro_rpc/coro_rpc_server.hpp>
+
+#include "api/rpc_functions.hpp"
+
+using namespace async_simple::coro;
+using namespace std::chrono_literals;
+
+// Compare the calls/sec of one connection between the classic mode (one
+// in-flight call per connection) and the multiplexing mode (many concurrent
+// calls share the connection).
+//
+// usage: coro_rpc_benchmark_multiplexing [concurrency] [test seconds]
+
+Lazy<void> call_loop(coro_rpc::coro_rpc_client &client,
+                     std::chrono::steady_clock::time_point deadline,
+                     std::atomic<uint64_t> &cnt) {
+  std::string req(100, 'A');
+  while (std::chrono::steady_clock::now() < deadline) {
+    auto ret = co_await client.call<echo_100B>(req);
+    if (!ret) {
+      std::cout << "call failed: " << ret.error().msg << std::endl;
+      co_return;
+    }
+    ++cnt;
+  }
+}
+
+double bench(bool enable_multiplexing, unsigned concurrency,
+             std::chrono::seconds test_time, unsigned short port) {
+  coro_rpc::coro_rpc_client client;
+  coro_rpc::coro_rpc_client::config config{};
+  config.enable_multiplexing = enable_multiplexing;
+  [[maybe_unused]] bool ok = client.init_config(config);
+  auto ec = syncAwait(client.connect("127.0.0.1", std::to_string(port)));
+  if (ec) {
+    std::cout << "connect failed: " << coro_rpc::make_error_message(ec)
+              << std::endl;
+    return 0;
+  }
+  std::atomic<uint64_t> cnt = 0;
+  auto begin = std::chrono::steady_clock::now();
+  auto deadline = begin + test_time;
+  std::vector<Lazy<void>> loops;
+  // without multiplexing, the client can't be shared by concurrent calls.
+  for (unsigned i = 0; i < (enable_multiplexing ? concurrency : 1); ++i) {
+    loops.push_back(call_loop(client, deadline, cnt));
+  }
+  syncAwait([](std::vector<Lazy<void>> loops) -> Lazy<void> {
+    co_await collectAll(std::move(loops));
+  }(std::move(loops)));
+  auto cost = std::chrono::duration_cast<std::chrono::duration<double>>(
+      std::chrono::steady_clock::now() - begin);
+  return cnt / cost.count();
+}
+
+int main(int argc, char **argv) {
+  unsigned concurrency = 64;
+  std::chrono::seconds test_time{10};
+  if (argc >= 2) {
+    concurrency = std::max(1ul, std::stoul(argv[1]));
+  }
+  if (argc >= 3) {
+    test_time = std::chrono::seconds(std::stoul(argv[2]));
+  }
+  easylog::set_min_severity(easylog::Severity::WARN);
+
+  coro_rpc::config::coro_rpc_default_config server_config{};
+  server_config.port = 0;
+  server_config.enable_write_stats = true;
+  coro_rpc::coro_rpc_server server(server_config);
+  server.register_handler<echo_100B>();
+  auto started = server.async_start();
+  if (!started) {
+    std::cout << "server start failed" << std::endl;
+    return -1;
+  }
+
+  std::cout << "concurrency: " << concurrency << ", test time: "
+            << test_time.count() << "s" << std::endl;
+  auto classic_qps = bench(false, concurrency, test_time, server.port());
+  std::cout << "classic mode calls/sec per connection: "
+            << (uint64_t)classic_qps << std::endl;
+  auto multiplexing_qps = bench(true, concurrency, test_time, server.port());
+  std::cout << "multiplexing mode calls/sec per connection: "
+            << (uint64_t)multiplexing_qps << std::endl;
+  auto &stats = *server.get_write_stats();
+  std::cout << "server responses per write: avg "
+            << (double)stats.msg_cnt / (std::max<uint64_t>)(1, stats.write_cnt)
+            << ", max " << stats.max_batch_size << std::endl;
+  return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <async_simple/coro/Collect.h>
+#include <async_simple/coro/Lazy.h>
+#include <async_simple/coro/SyncAwait.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ylt/coro_rpc/coro_rpc_client.hpp>
+#include <ylt/coro_rpc/coro_rpc_server.hpp>
+
+#include "api/rpc_functions.hpp"
+
+using namespace async_simple::coro;
+using namespace std::chrono_literals;
+
+// Compare the connections/sec of short-lived connections (connect, one call,
+// close) between one acceptor and one SO_REUSEPORT acceptor per io thread.
+//
+// usage: coro_rpc_benchmark_reuse_port [concurrency] [test seconds]
+
+Lazy<void> connect_loop(std::chrono::steady_clock::time_point deadline,
+                        unsigned short port, std::atomic<uint64_t> &cnt) {
+  std::string req(100, 'A');
+  while (std::chrono::steady_clock::now() < deadline) {
+    coro_rpc::coro_rpc_client client(*coro_io::get_global_executor());
+    auto ec = co_await client.connect("127.0.0.1", std::to_string(port));
+    if (ec) {
+      std::cout << "connect failed: " << coro_rpc::make_error_message(ec)
+                << std::endl;
+      co_return;
+    }
+    auto ret = co_await client.call<echo_100B>(req);
+    if (!ret) {
+      std::cout << "call failed: " << ret.error().msg << std::endl;
+      co_return;
+    }
+    ++cnt;
+  }
+}
+
+double bench(bool reuse_port, unsigned concurrency,
+             std::chrono::seconds test_time) {
+  coro_rpc::config::coro_rpc_default_config config{};
+  config.port = 0;
+  config.reuse_port = reuse_port;
+  coro_rpc::coro_rpc_server server(config);
+  server.register_handler<echo_100B>();
+  auto started = server.async_start();
+  if (!started) {
+    std::cout << "server start failed" << std::endl;
+    return 0;
+  }
+
+  std::atomic<uint64_t> cnt = 0;
+  auto begin = std::chrono::steady_clock::now();
+  auto deadline = begin + test_time;
+  std::vector<Lazy<void>> loops;
+  for (unsigned i = 0; i < concurrency; ++i) {
+    loops.push_back(connect_loop(deadline, server.port(), cnt));
+  }
+  syncAwait([](std::vector<Lazy<void>> loops) -> Lazy<void> {
+    co_await collectAll(std::move(loops));
+  }(std::move(loops)));
+  auto cost = std::chrono::duration_cast<std::chrono::duration<double>>(
+      std::chrono::steady_clock::now() - begin);
+  return cnt / cost.count();
+}
+
+int main(int argc, char **argv) {
+  unsigned concurrency = 64;
+  std::chrono::seconds test_time{10};
+  if (argc >= 2) {
+    concurrency = std::max(1ul, std::stoul(argv[1]));
+  }
+  if (argc >= 3) {
+    test_time = std::chrono::seconds(std::stoul(argv[2]));
+  }
+  easylog::set_min_severity(easylog::Severity::WARN);
+
+  std::cout << "concurrency: " << concurrency << ", test time: "
+            << test_time.count() << "s" << std::endl;
+  auto one_acceptor = bench(false, concurrency, test_time);
+  std::cout << "one acceptor connections/sec: " << (uint64_t)one_acceptor
+            << std::endl;
+  auto reuse_port = bench(true, concurrency, test_time);
+  std::cout << "SO_REUSEPORT acceptors connections/sec: "
+            << (uint64_t)reuse_port << std::endl;
+  return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <array>
+#include <cstdlib>
+#include <new>
+#include <string_view>
+#include <ylt/coro_rpc/coro_rpc_client.hpp>
+#include <ylt/coro_rpc/coro_rpc_context.hpp>
+#include <ylt/coro_rpc/coro_rpc_server.hpp>
+#include <ylt/coro_rpc/impl/default_config/coro_rpc_config.hpp>
+#include <ylt/coro_rpc/impl/protocol/coro_rpc_protocol.hpp>
+#include <ylt/util/utils.hpp>
+
+#include "doctest.h"
+
+// count the heap allocations of the current thread.
+thread_local std::size_t g_alloc_cnt = 0;
+thread_local std::size_t g_alloc_bytes = 0;
+
+void *operator new(std::size_t size) {
+  ++g_alloc_cnt;
+  g_alloc_bytes += size;
+  if (auto p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+void *operator new[](std::size_t size) { return ::operator new(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+using namespace coro_rpc;
+using coro_rpc_protocol = coro_rpc::protocol::coro_rpc_protocol;
+
+std::array<int, 64> fill_array(int val) {
+  std::array<int, 64> arr;
+  arr.fill(val);
+  return arr;
+}
+
+/*
+ * The steady state of the response path allocates nothing: routing the
+ * request, serializing the result into a recycled buffer and writing the
+ * response header in place. The coroutine frames, the write queue and the
+ * socket I/O of a whole client call and server response are out of scope.
+ */
+TEST_CASE("testing zero allocation of response buffer") {
+  asio::io_context ioc;
+  coro_io::ExecutorWrapper<> executor(ioc.get_executor());
+  auto conn = std::make_shared<coro_connection>(&executor,
+                                                asio::ip::tcp::socket(ioc));
+  auto ctx = std::make_shared<context_info_t<coro_rpc_protocol>>(
+      std::shared_ptr<coro_connection>(conn));
+  ctx->resp_head_len_ = coro_rpc_protocol::RESP_HEAD_LEN;
+
+  coro_rpc_protocol::router router;
+  router.register_handler<fill_array>();
+  constexpr auto id = func_id<fill_array>();
+  auto handler = router.get_handler(id);
+  REQUIRE(handler != nullptr);
+  ctx->req_head_.function_id = id;
+
+  auto payload = struct_pack::serialize<std::string>(42);
+  auto call = [&] {
+    auto [err, buffer] = router.route(
+        handler, payload, ctx,
+        std::variant<coro_rpc::protocol::struct_pack_protocol>{}, id);
+    REQUIRE(!err);
+    err = coro_rpc_protocol::prepare_response_in_place(buffer, ctx->req_head_);
+    REQUIRE(!err);
+    auto &head = *(coro_rpc_protocol::resp_header *)buffer.data();
+    CHECK(head.length == buffer.size() - coro_rpc_protocol::RESP_HEAD_LEN);
+    std::array<int, 64> result;
+    auto ec = struct_pack::deserialize_to(
+        result, std::string_view(buffer).substr(
+                    coro_rpc_protocol::RESP_HEAD_LEN));
+    CHECK(ec == struct_pack::errc{});
+    CHECK(result == fill_array(42));
+    conn->release_buffer(std::move(buffer));
+  };
+
+  auto old_severity = easylog::get_min_severity();
+  easylog::set_min_severity(easylog::Severity::WARN);
+  // the first call fills the buffer pool.
+  call();
+  auto alloc_cnt = g_alloc_cnt;
+  for (int i = 0; i < 100; ++i) {
+    call();
+  }
+  auto steady_alloc_cnt = g_alloc_cnt - alloc_cnt;
+  easylog::set_min_severity(old_severity);
+  CHECK(steady_alloc_cnt == 0);
+}
+
+std::string_view echo_view(std::string_view data) { return data; }
+
+// the bytes allocated by the thread of the server so far.
+std::size_t server_alloc_bytes() { return g_alloc_bytes; }
+
+/*
+ * A real call through the client and the connection loop of the server. The
+ * coroutine frames and the write queue still allocate a little per call, but
+ * neither the request body nor the response buffer is allocated, so the bytes
+ * allocated by the server thread don't grow with the payload.
+ */
+TEST_CASE("testing allocations of a real call") {
+  auto old_severity = easylog::get_min_severity();
+  easylog::set_min_severity(easylog::Severity::WARN);
+  coro_rpc_server server(1, 0);
+  server.register_handler<echo_view, server_alloc_bytes>();
+  auto res = server.async_start();
+  REQUIRE_MESSAGE(res, "server start failed");
+
+  coro_rpc_client client;
+  auto ec = async_simple::coro::syncAwait(
+      client.connect("127.0.0.1", std::to_string(server.port())));
+  REQUIRE(!ec);
+  std::string payload(32 * 1024, 'a');
+  auto call = [&] {
+    auto ret = async_simple::coro::syncAwait(client.call<echo_view>(payload));
+    REQUIRE(ret.has_value());
+    CHECK(ret.value().size() == payload.size());
+  };
+  auto get_server_alloc_bytes = [&] {
+    auto ret = async_simple::coro::syncAwait(client.call<server_alloc_bytes>());
+    REQUIRE(ret.has_value());
+    return ret.value();
+  };
+  // the first calls fill the buffer pool.
+  for (int i = 0; i < 10; ++i) {
+    call();
+  }
+  constexpr int call_cnt = 100;
+  auto begin = get_server_alloc_bytes();
+  for (int i = 0; i < call_cnt; ++i) {
+    call();
+  }
+  auto per_call = (get_server_alloc_bytes() - begin) / call_cnt;
+  easylog::set_min_severity(old_severity);
+  CHECK(per_call < payload.size() / 8);
+  server.stop();
+}
@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <async_simple/coro/Collect.h>
 #include <async_simple/coro/Lazy.h>
 #include <async_simple/coro/SyncAwait.h>
 
@@ -409,6 +410,89 @@ TEST_CASE("testing client with attachment") {
   ret = client.sync_call<echo_with_attachment>();
   CHECK(ret.has_value());
   CHECK(client.get_resp_attachment() == "");
+
+  std::string resp;
+  ret = syncAwait(client.call_with_attachment_for<echo_with_attachment>(
+      5s, "per call", resp));
+  CHECK(ret.has_value());
+  CHECK(resp == "per call");
+}
+
+TEST_CASE("testing client with multiplexing") {
+  g_action = {};
+  coro_rpc_server server(2, 8801);
+  server.register_handler<hello, hello_timeout, echo_with_attachment,
+                          coro_fun_with_delay_return_void_cost_long_time>();
+  auto res = server.async_start();
+  REQUIRE_MESSAGE(res, "server start failed");
+  coro_rpc_client client(*coro_io::get_global_executor(), g_client_id++);
+  coro_rpc_client::config config{};
+  config.enable_multiplexing = true;
+  REQUIRE(client.init_config(config));
+  auto ec = client.sync_connect("127.0.0.1", "8801");
+  REQUIRE_MESSAGE(!ec, make_error_message(ec));
+
+  SUBCASE("concurrent calls share one connection") {
+    std::atomic<int> finished_hello = 0;
+    auto slow_call = [&]() -> Lazy<bool> {
+      auto ret =
+          co_await client.call<coro_fun_with_delay_return_void_cost_long_time>();
+      // the delayed response comes after all the fast ones.
+      co_return ret.has_value() && finished_hello == 100;
+    };
+    auto fast_call = [&]() -> Lazy<bool> {
+      auto ret = co_await client.call<hello>();
+      ++finished_hello;
+      co_return ret.has_value() && ret.value() == "hello";
+    };
+    std::vector<Lazy<bool>> calls;
+    calls.push_back(slow_call());
+    for (int i = 0; i < 100; ++i) {
+      calls.push_back(fast_call());
+    }
+    auto results = syncAwait(
+        [](std::vector<Lazy<bool>> calls) -> Lazy<std::vector<async_simple::Try<bool>>> {
+          co_return co_await collectAll(std::move(calls));
+        }(std::move(calls)));
+    for (auto& result : results) {
+      CHECK(result.value());
+    }
+  }
+  SUBCASE("concurrent calls with attachments") {
+    auto echo_call = [&](int i) -> Lazy<bool> {
+      std::string req = "attachment " + std::to_string(i);
+      std::string resp;
+      auto ret = co_await client.call_with_attachment_for<echo_with_attachment>(
+          5s, req, resp);
+      co_return ret.has_value() && resp == req;
+    };
+    std::vector<Lazy<bool>> calls;
+    for (int i = 0; i < 100; ++i) {
+      calls.push_back(echo_call(i));
+    }
+    auto results = syncAwait(
+        [](std::vector<Lazy<bool>> calls) -> Lazy<std::vector<async_simple::Try<bool>>> {
+          co_return co_await collectAll(std::move(calls));
+        }(std::move(calls)));
+    for (auto& result : results) {
+      CHECK(result.value());
+    }
+    // the shared attachment of the client can't be used by multiplexed calls.
+    client.set_req_attachment("hello");
+    auto ret = syncAwait(client.call<echo_with_attachment>());
+    REQUIRE(!ret.has_value());
+    CHECK(ret.error().code == coro_rpc::errc::invalid_argument);
+    client.set_req_attachment({});
+  }
+  SUBCASE("timeout doesn't close the connection") {
+    auto ret = syncAwait(client.call_for<hello_timeout>(10ms));
+    REQUIRE(!ret.has_value());
+    CHECK(ret.error().code == coro_rpc::errc::timed_out);
+    CHECK(client.has_closed() == false);
+    auto ret2 = syncAwait(client.call<hello>());
+    REQUIRE(ret2.has_value());
+    CHECK(ret2.value() == "hello");
+  }
 }
 
 TEST_CASE("testing client with context response user-defined error") {
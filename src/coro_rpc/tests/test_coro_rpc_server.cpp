@@ -16,6 +16,7 @@
 #include <async_simple/coro/Collect.h>
 #include <async_simple/coro/SyncAwait.h>
 
+#include <mutex>
 #include <thread>
 #include <variant>
 #include <ylt/coro_rpc/coro_rpc_client.hpp>
@@ -334,6 +335,163 @@ TEST_CASE("test server write queue") {
   server.stop();
 }
 
+// Hold the contexts and respond to them together, so the responses are
+// queued while the first one is being written.
+std::mutex held_contexts_mtx;
+std::vector<coro_rpc::context<std::string>> held_contexts;
+void hello_in_group(coro_rpc::context<std::string> conn) {
+  conn.set_delay();
+  std::vector<coro_rpc::context<std::string>> group;
+  {
+    std::lock_guard lock(held_contexts_mtx);
+    held_contexts.push_back(std::move(conn));
+    if (held_contexts.size() < 10) {
+      return;
+    }
+    group = std::move(held_contexts);
+    held_contexts.clear();
+  }
+  for (auto &ctx : group) {
+    ctx.response_msg("hello");
+  }
+}
+
+TEST_CASE("test server write coalescing") {
+  g_action = {};
+  coro_rpc::config::coro_rpc_default_config config{};
+  config.thread_num = 2;
+  config.port = 8810;
+  // at most 2 responses (header + body) in one write, the delayed responses
+  // write the header in a separate buffer.
+  config.max_write_iovecs = 4;
+  config.enable_write_stats = true;
+  coro_rpc_server server(config);
+  server.register_handler<hello_in_group>();
+  auto res = server.async_start();
+  REQUIRE_MESSAGE(res, "server start failed");
+  coro_rpc_client client(*coro_io::get_global_executor(), g_client_id++);
+  coro_rpc_client::config client_config{};
+  client_config.enable_multiplexing = true;
+  REQUIRE(client.init_config(client_config));
+  auto ec = syncAwait(client.connect("127.0.0.1", "8810"));
+  REQUIRE_MESSAGE(!ec, make_error_message(ec));
+
+  auto call = [&client]() -> Lazy<bool> {
+    auto ret = co_await client.call<hello_in_group>();
+    co_return ret.has_value() && ret.value() == "hello";
+  };
+  std::vector<Lazy<bool>> calls;
+  for (int i = 0; i < 100; ++i) {
+    calls.push_back(call());
+  }
+  auto results = syncAwait(
+      [](std::vector<Lazy<bool>> calls) -> Lazy<std::vector<async_simple::Try<bool>>> {
+        co_return co_await collectAll(std::move(calls));
+      }(std::move(calls)));
+  for (auto &result : results) {
+    CHECK(result.value());
+  }
+  auto stats = server.get_write_stats();
+  REQUIRE(stats != nullptr);
+  CHECK(stats->msg_cnt == 100);
+  // some write carried more than one response.
+  CHECK(stats->write_cnt < 100);
+  CHECK(stats->max_batch_size == 2);
+}
+
+namespace {
+// a cpu which this process may run on.
+int get_allowed_cpu() {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        return cpu;
+      }
+    }
+  }
+#endif
+  return 0;
+}
+}  // namespace
+
+TEST_CASE("test server thread affinity") {
+  g_action = {};
+  coro_rpc::config::coro_rpc_default_config config{};
+  config.thread_num = 2;
+  config.port = 8811;
+  config.thread_affinity.cpus = {{get_allowed_cpu()}};
+  config.thread_affinity.numa_aware = true;
+  coro_rpc_server server(config);
+  server.register_handler<hello>();
+  auto res = server.async_start();
+  REQUIRE_MESSAGE(res, "server start failed");
+  for (int i = 0; i < 4; ++i) {
+    coro_rpc_client client(*coro_io::get_global_executor(), g_client_id++);
+    auto ec = syncAwait(client.connect("127.0.0.1", "8811"));
+    REQUIRE_MESSAGE(!ec, make_error_message(ec));
+    auto ret = syncAwait(client.call<hello>());
+    CHECK(ret.value() == "hello");
+  }
+}
+
+TEST_CASE("test server reuse port") {
+  g_action = {};
+  coro_rpc::config::coro_rpc_default_config config{};
+  config.thread_num = 4;
+  config.port = 8812;
+  config.reuse_port = true;
+  coro_rpc_server server(config);
+  server.register_handler<hello>();
+  auto res = server.async_start();
+  REQUIRE_MESSAGE(res, "server start failed");
+  for (int i = 0; i < 16; ++i) {
+    coro_rpc_client client(*coro_io::get_global_executor(), g_client_id++);
+    auto ec = syncAwait(client.connect("127.0.0.1", "8812"));
+    REQUIRE_MESSAGE(!ec, make_error_message(ec));
+    auto ret = syncAwait(client.call<hello>());
+    CHECK(ret.value() == "hello");
+  }
+  server.stop();
+
+  // the port can be listened again after all the acceptors are closed.
+  coro_rpc_server server2(config);
+  auto res2 = server2.async_start();
+  CHECK_MESSAGE(res2, "server start failed");
+}
+
+TEST_CASE("test server connection count") {
+  g_action = {};
+  coro_rpc_server server(2, 8813);
+  server.register_handler<hello>();
+  auto res = server.async_start();
+  REQUIRE_MESSAGE(res, "server start failed");
+  auto wait_count = [&server](std::size_t count) {
+    for (int i = 0; i < 100 && server.connection_count() != count; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return server.connection_count();
+  };
+  {
+    std::vector<std::unique_ptr<coro_rpc_client>> clients;
+    for (int i = 0; i < 3; ++i) {
+      auto client = std::make_unique<coro_rpc_client>(
+          *coro_io::get_global_executor(), g_client_id++);
+      auto ec = syncAwait(client->connect("127.0.0.1", "8813"));
+      REQUIRE_MESSAGE(!ec, make_error_message(ec));
+      auto ret = syncAwait(client->call<hello>());
+      CHECK(ret.value() == "hello");
+      clients.push_back(std::move(client));
+    }
+    CHECK(wait_count(3) == 3);
+  }
+  CHECK(wait_count(0) == 0);
+  server.stop();
+  CHECK(server.connection_count() == 0);
+}
+
 TEST_CASE("testing coro rpc write error") {
   ELOGV(INFO, "run testing coro rpc write error");
   g_action = inject_action::force_inject_connection_close_socket;
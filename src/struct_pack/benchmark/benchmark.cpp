@@ -1,8 +1,14 @@
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <map>
 #include <memory>
+#include <new>
 #include <stdexcept>
+#include <string_view>
 
 #include "struct_pack_sample.hpp"
+#include "ylt/struct_json/json_writer.h"
 
 #if __has_include(<msgpack.hpp>)
 #define HAVE_MSGPACK 1
@@ -15,6 +21,7 @@
 #ifdef HAVE_PROTOBUF
 #include "protobuf_sample.hpp"
 #ifdef HAVE_STRUCT_PB
+#include "struct_pb_arena_sample.hpp"
 #include "struct_pb_sample.hpp"
 #endif
 #endif
@@ -24,6 +31,79 @@
 
 #include "config.hpp"
 using namespace std::string_literals;
+
+// count the allocations for the allocations per operation.
+void* operator new(std::size_t size) {
+  ++alloc_count();
+  if (auto p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+REFLECTION(bench_result, lib, sample, op, buffer_size, mb_per_sec, mean_ns,
+           batch_p50_ns, batch_p99_ns, allocs_per_op);
+
+struct bench_report {
+  int object_count;
+  int iterations;
+  int batch_size;
+  // the libraries which aren't found when the benchmark is built.
+  std::vector<std::string> missing_libs;
+  std::vector<bench_result> results;
+};
+REFLECTION(bench_report, object_count, iterations, batch_size, missing_libs,
+           results);
+
+template <typename T>
+std::vector<std::string> get_missing_libs(const T& map) {
+  std::vector<std::string> ret;
+  for (auto lib_type :
+       {LibType::STRUCT_PACK, LibType::STRUCT_PB, LibType::STRUCT_PB_ARENA,
+        LibType::MSGPACK, LibType::PROTOBUF, LibType::FLATBUFFER}) {
+    if (map.find(lib_type) == map.end()) {
+      ret.push_back(get_lib_name(lib_type));
+    }
+  }
+  return ret;
+}
+
+template <typename T>
+void print_results(const T& map) {
+  std::cout << "======= throughput, latency and allocations ========\n";
+  for (auto [lib_type, sample] : map) {
+    for (auto& r : sample->get_results()) {
+      std::string prefix = r.lib + " " + r.op + " " + r.sample;
+      std::cout << prefix << get_space_str(prefix.size(), 63) << " " << std::fixed
+                << std::setprecision(1) << r.mb_per_sec
+                << " MB/s, batch-mean p50 = " << r.batch_p50_ns
+                << " ns, batch-mean p99 = " << r.batch_p99_ns << " ns, "
+                << std::setprecision(2) << r.allocs_per_op << " allocs/op\n";
+    }
+  }
+  std::cout.unsetf(std::ios::floatfield);
+}
+
+template <typename T>
+void write_json(const T& map, const std::string& path) {
+  bench_report report{OBJECT_COUNT, ITERATIONS, BATCH_SIZE,
+                      get_missing_libs(map), {}};
+  for (auto [lib_type, sample] : map) {
+    auto& results = sample->get_results();
+    report.results.insert(report.results.end(), results.begin(),
+                          results.end());
+  }
+  std::string json;
+  struct_json::to_json(report, json);
+  std::ofstream out(path);
+  out << json << "\n";
+  if (!out) {
+    throw std::runtime_error("failed to write " + path);
+  }
+  std::cout << "results are written to " << path << "\n";
+}
 template <typename T>
 void calculate_ser_rate(const T& map, LibType base_line_type,
                         SampleType base_line_sample_type,
@@ -110,7 +190,18 @@ void run_benchmark(const T& map, LibType base_line_type) {
 #endif
 }
 
+// usage: struct_pack_benchmark [--json <file>]
 int main(int argc, char** argv) {
+  std::string json_path;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string_view{argv[i]} == "--json" && i + 1 < argc) {
+      json_path = argv[++i];
+    }
+    else {
+      std::cerr << "usage: " << argv[0] << " [--json <file>]\n";
+      return 1;
+    }
+  }
   std::cout << "OBJECT_COUNT : " << OBJECT_COUNT << std::endl;
 
   std::map<LibType, std::shared_ptr<base_sample>> map;
@@ -122,6 +213,8 @@ int main(int argc, char** argv) {
 #ifdef HAVE_PROTOBUF
 #ifdef HAVE_STRUCT_PB
   map.emplace(LibType::STRUCT_PB, new struct_pb_sample::struct_pb_sample_t());
+  map.emplace(LibType::STRUCT_PB_ARENA,
+              new struct_pb_arena_sample::struct_pb_arena_sample_t());
 #endif
   map.emplace(LibType::PROTOBUF, new protobuf_sample_t());
 #endif
@@ -136,6 +229,10 @@ int main(int argc, char** argv) {
     sample->do_deserialization();
   }
 
+  for (auto& lib : get_missing_libs(map)) {
+    std::cout << "======= " << lib << " is not built, skip it =======\n";
+  }
+
   std::cout << "======= serialize buffer size ========\n";
   for (auto [lib_type, sample] : map) {
     sample->print_buffer_size(lib_type);
@@ -147,5 +244,9 @@ int main(int argc, char** argv) {
   run_benchmark(map, LibType::STRUCT_PB);
 #endif
 
+  print_results(map);
+  if (!json_path.empty()) {
+    write_json(map, json_path);
+  }
   return 0;
 }
@@ -7,10 +7,12 @@
 #include <vector>
 inline constexpr int OBJECT_COUNT = 20;
 inline constexpr int ITERATIONS = 1000000;
+inline constexpr int BATCH_SIZE = 1000;
 
 enum class LibType {
   STRUCT_PACK,
   STRUCT_PB,
+  STRUCT_PB_ARENA,
   MSGPACK,
   PROTOBUF,
   FLATBUFFER,
@@ -49,6 +51,7 @@ inline const std::unordered_map<SampleType, std::string> g_sample_name_map = {
 inline const std::unordered_map<LibType, std::string> g_lib_name_map = {
     {LibType::STRUCT_PACK, "struct_pack"},
     {LibType::STRUCT_PB, "struct_pb"},
+    {LibType::STRUCT_PB_ARENA, "struct_pb(arena)"},
     {LibType::MSGPACK, "msgpack"},
     {LibType::PROTOBUF, "protobuf"},
     {LibType::FLATBUFFER, "flatbuffer"}};
@@ -198,17 +198,11 @@ struct flatbuffer_sample_t : public base_sample {
     {
       flatbuffer_sample::create<T>(builder);
 
-      uint64_t ns = 0;
-      std::string bench_name =
-          name() + " serialize " + get_sample_name(sample_type);
-      {
-        ScopedTimer timer(bench_name.data(), ns);
-        for (int i = 0; i < ITERATIONS; ++i) {
-          builder.Clear();
-          flatbuffer_sample::create<T>(builder);
-          no_op((char *)builder.GetBufferPointer());
-        }
-      }
+      uint64_t ns = run_bench(sample_type, "serialize", builder.GetSize(), [&] {
+        builder.Clear();
+        flatbuffer_sample::create<T>(builder);
+        no_op((char *)builder.GetBufferPointer());
+      });
       ser_time_elapsed_map_.emplace(sample_type, ns);
     }
     buf_size_map_.emplace(sample_type, builder.GetSize());
@@ -218,18 +212,13 @@ struct flatbuffer_sample_t : public base_sample {
     flatbuffers::FlatBufferBuilder builder;
     flatbuffer_sample::create<T>(builder);
 
-    uint64_t ns = 0;
-    std::string bench_name =
-        name() + " deserialize " + get_sample_name(sample_type);
-    {
-      ScopedTimer timer(bench_name.data(), ns);
-      for (int i = 0; i < ITERATIONS; ++i) {
-        auto obj =
-            flatbuffers::GetRoot<fb::Monsters>(builder.GetBufferPointer());
-        no_op((char *)obj);
-        no_op((char *)&builder);
-      }
-    }
+    uint64_t ns =
+        run_bench(sample_type, "deserialize", builder.GetSize(), [&] {
+          auto obj =
+              flatbuffers::GetRoot<fb::Monsters>(builder.GetBufferPointer());
+          no_op((char *)obj);
+          no_op((char *)&builder);
+        });
     deser_time_elapsed_map_.emplace(sample_type, ns);
   }
 };
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+
+#include "no_op.h"
+
+// Measure the structs whose scalar members are copied as merged runs. The
+// same source is built as struct_pack_benchmark_member_runs_off with
+// STRUCT_PACK_DISABLE_MEMBER_RUNS, which copies the members one by one, so
+// run both and compare the lines.
+//
+// usage: struct_pack_benchmark_member_runs[_off] [count of structs] [rounds]
+
+using namespace std::chrono;
+
+// a string member makes the struct non-trivial, the 7 scalars before it are
+// one run.
+struct quote {
+  int64_t id;
+  int32_t bid;
+  int32_t ask;
+  int32_t bid_size;
+  int32_t ask_size;
+  double last;
+  int64_t time;
+  std::string symbol;
+};
+
+// 16 floats after a string are one run.
+struct sample {
+  std::string name;
+  float values[4];
+  float x, y, z, w;
+  float min[4];
+  float max[4];
+};
+
+// no two adjacent scalars, there is nothing to merge.
+struct sparse {
+  int64_t id;
+  std::string name;
+  double value;
+  std::vector<int32_t> history;
+};
+
+template <typename T>
+std::vector<T> make_values(std::size_t count);
+
+template <>
+std::vector<quote> make_values(std::size_t count) {
+  std::vector<quote> ret;
+  for (std::size_t i = 0; i < count; ++i) {
+    ret.push_back(quote{(int64_t)i, 100, 101, 5, 7, 100.5, (int64_t)i * 1000,
+                        "SYM" + std::to_string(i % 100)});
+  }
+  return ret;
+}
+
+template <>
+std::vector<sample> make_values(std::size_t count) {
+  std::vector<sample> ret(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    ret[i].name = "sensor" + std::to_string(i % 100);
+    ret[i].x = float(i);
+  }
+  return ret;
+}
+
+template <>
+std::vector<sparse> make_values(std::size_t count) {
+  std::vector<sparse> ret;
+  for (std::size_t i = 0; i < count; ++i) {
+    ret.push_back(sparse{(int64_t)i, "item" + std::to_string(i % 100), 0.5,
+                         std::vector<int32_t>(4, (int32_t)i)});
+  }
+  return ret;
+}
+
+template <typename Func>
+double measure_ns(std::size_t rounds, std::size_t count, Func &&func) {
+  auto begin = steady_clock::now();
+  for (std::size_t i = 0; i < rounds; ++i) {
+    func();
+  }
+  auto ns = duration_cast<nanoseconds>(steady_clock::now() - begin).count();
+  return double(ns) / rounds / count;
+}
+
+template <typename T>
+void bench(const char *name, std::size_t count, std::size_t rounds) {
+  auto values = make_values<T>(count);
+  std::string buffer;
+  auto encode = measure_ns(rounds, count, [&] {
+    buffer.clear();
+    struct_pack::serialize_to(buffer, values);
+    no_op(buffer);
+  });
+  std::vector<T> result;
+  auto decode = measure_ns(rounds, count, [&] {
+    if (struct_pack::deserialize_to(result, buffer) != struct_pack::errc{}) {
+      std::abort();
+    }
+    no_op((char *)result.data());
+  });
+  if (struct_pack::serialize<std::string>(result) != buffer) {
+    std::abort();
+  }
+  std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+            << std::setprecision(2) << std::setw(10) << encode << std::setw(10)
+            << decode << "\n";
+}
+
+int main(int argc, char **argv) {
+  std::size_t count = argc > 1 ? std::atoll(argv[1]) : 10000;
+  std::size_t rounds = argc > 2 ? std::atoll(argv[2]) : 200;
+  std::cout << "member runs: "
+            << (struct_pack::detail::enable_member_runs ? "on" : "off") << ", "
+            << count << " structs, ns per struct\n";
+  std::cout << std::left << std::setw(28) << "struct" << std::right
+            << std::setw(10) << "enc" << std::setw(10) << "dec" << "\n";
+  bench<quote>("quote (7 scalars)", count, rounds);
+  bench<sample>("sample (16 floats)", count, rounds);
+  bench<sparse>("sparse (no run)", count, rounds);
+  return 0;
+}
@@ -50,21 +50,15 @@ struct message_pack_sample : public base_sample {
   void serialize(SampleType sample_type, T &sample) {
     {
       msgpack::pack(buffer_, sample);
+      auto size = buffer_.size();
       buffer_.clear();
 
-      uint64_t ns = 0;
-      std::string bench_name =
-          name() + " serialize " + get_sample_name(sample_type);
-
-      {
-        ScopedTimer timer(bench_name.data(), ns);
-        for (int i = 0; i < ITERATIONS; ++i) {
-          buffer_.clear();
-          msgpack::pack(buffer_, sample);
-          no_op(buffer_.data());
-          no_op((char *)&sample);
-        }
-      }
+      uint64_t ns = run_bench(sample_type, "serialize", size, [&] {
+        buffer_.clear();
+        msgpack::pack(buffer_, sample);
+        no_op(buffer_.data());
+        no_op((char *)&sample);
+      });
       ser_time_elapsed_map_.emplace(sample_type, ns);
     }
     buf_size_map_.emplace(sample_type, buffer_.size());
@@ -78,19 +72,12 @@ struct message_pack_sample : public base_sample {
 
     msgpack::unpacked vec;
     T val;
-    uint64_t ns = 0;
-    std::string bench_name =
-        name() + " deserialize " + get_sample_name(sample_type);
-
-    {
-      ScopedTimer timer(bench_name.data(), ns);
-      for (int i = 0; i < ITERATIONS; ++i) {
-        msgpack::unpack(vec, buffer_.data(), buffer_.size());
-        val = vec->as<T>();
-        no_op((char *)&val);
-        no_op(buffer_.data());
-      }
-    }
+    uint64_t ns = run_bench(sample_type, "deserialize", buffer_.size(), [&] {
+      msgpack::unpack(vec, buffer_.data(), buffer_.size());
+      val = vec->as<T>();
+      no_op((char *)&val);
+      no_op(buffer_.data());
+    });
     deser_time_elapsed_map_.emplace(sample_type, ns);
   }
 
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+
+#include "no_op.h"
+
+// Count the heap allocations per message of deserializing into std containers
+// and into std::pmr containers backed by a monotonic buffer, which is released
+// in O(1) after each message.
+//
+// usage: struct_pack_benchmark_pmr [count of messages]
+
+using namespace std::chrono;
+
+static std::size_t allocation_count = 0;
+
+void *operator new(std::size_t size) {
+  ++allocation_count;
+  if (auto p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+void *operator new(std::size_t size, std::align_val_t align) {
+  ++allocation_count;
+  auto alignment = (std::max)(static_cast<std::size_t>(align), sizeof(void *));
+  size = (size + alignment - 1) / alignment * alignment;
+  if (auto p = std::aligned_alloc(alignment, size ? size : alignment)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+struct item {
+  std::string name;
+  std::vector<int32_t> values;
+};
+
+struct message {
+  int64_t id;
+  std::string title;
+  std::vector<item> items;
+  std::map<std::string, std::string> tags;
+};
+
+struct pmr_item {
+  std::pmr::string name;
+  std::pmr::vector<int32_t> values;
+};
+
+struct pmr_message {
+  int64_t id;
+  std::pmr::string title;
+  std::pmr::vector<pmr_item> items;
+  std::pmr::map<std::pmr::string, std::pmr::string> tags;
+};
+
+message make_message() {
+  message m{42, std::string(64, 't')};
+  for (int i = 0; i < 20; ++i) {
+    m.items.push_back({std::string(32, 'a' + i), std::vector<int32_t>(16, i)});
+    m.tags.emplace(std::string(24, 'a' + i), std::string(40, 'v'));
+  }
+  return m;
+}
+
+template <typename Func>
+void bench(const char *name, std::size_t count, Func &&func) {
+  allocation_count = 0;
+  auto begin = steady_clock::now();
+  for (std::size_t i = 0; i < count; ++i) {
+    func();
+  }
+  auto ns = duration_cast<nanoseconds>(steady_clock::now() - begin).count();
+  std::cout << std::left << std::setw(32) << name << std::right << std::fixed
+            << std::setprecision(2) << std::setw(16)
+            << double(allocation_count) / count << std::setw(12)
+            << double(ns) / count << "\n";
+}
+
+int main(int argc, char **argv) {
+  std::size_t count = argc > 1 ? std::atoll(argv[1]) : 100000;
+  auto buffer = struct_pack::serialize(make_message());
+  static_assert(struct_pack::get_type_code<message>() ==
+                struct_pack::get_type_code<pmr_message>());
+
+  std::cout << count << " messages of " << buffer.size() << " bytes\n";
+  std::cout << std::left << std::setw(32) << "deserialize into" << std::right
+            << std::setw(16) << "allocs/msg" << std::setw(12) << "ns/msg"
+            << "\n";
+  bench("std containers", count, [&] {
+    message m;
+    if (struct_pack::deserialize_to(m, buffer) != struct_pack::errc{}) {
+      std::abort();
+    }
+    no_op(m.title);
+  });
+  bench("pmr containers (default)", count, [&] {
+    pmr_message m;
+    if (struct_pack::deserialize_to(m, buffer) != struct_pack::errc{}) {
+      std::abort();
+    }
+    no_op((char *)m.title.data());
+  });
+  std::vector<char> storage(64 * 1024);
+  bench("pmr containers (monotonic)", count, [&] {
+    std::pmr::monotonic_buffer_resource arena(storage.data(), storage.size());
+    pmr_message m;
+    if (struct_pack::deserialize_to(m, buffer, &arena) !=
+        struct_pack::errc{}) {
+      std::abort();
+    }
+    no_op((char *)m.title.data());
+  });
+  return 0;
+}
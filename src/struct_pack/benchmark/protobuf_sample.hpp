@@ -185,21 +185,15 @@ struct protobuf_sample_t : public base_sample {
   void serialize(SampleType sample_type, T &sample) {
     {
       sample.SerializeToString(&buffer_);
+      auto size = buffer_.size();
       buffer_.clear();
 
-      uint64_t ns = 0;
-      std::string bench_name =
-          name() + " serialize " + get_sample_name(sample_type);
-
-      {
-        ScopedTimer timer(bench_name.data(), ns);
-        for (int i = 0; i < ITERATIONS; ++i) {
-          buffer_.clear();
-          sample.SerializeToString(&buffer_);
-          no_op(buffer_);
-          no_op((char *)&sample);
-        }
-      }
+      uint64_t ns = run_bench(sample_type, "serialize", size, [&] {
+        buffer_.clear();
+        sample.SerializeToString(&buffer_);
+        no_op(buffer_);
+        no_op((char *)&sample);
+      });
       ser_time_elapsed_map_.emplace(sample_type, ns);
     }
     buf_size_map_.emplace(sample_type, buffer_.size());
@@ -213,18 +207,11 @@ struct protobuf_sample_t : public base_sample {
 
     T obj;
 
-    uint64_t ns = 0;
-    std::string bench_name =
-        name() + " deserialize " + get_sample_name(sample_type);
-
-    {
-      ScopedTimer timer(bench_name.data(), ns);
-      for (int i = 0; i < ITERATIONS; ++i) {
-        obj.ParseFromString(buffer_);
-        no_op((char *)&obj);
-        no_op(buffer_);
-      }
-    }
+    uint64_t ns = run_bench(sample_type, "deserialize", buffer_.size(), [&] {
+      obj.ParseFromString(buffer_);
+      no_op((char *)&obj);
+      no_op(buffer_);
+    });
     deser_time_elapsed_map_.emplace(sample_type, ns);
   }
 
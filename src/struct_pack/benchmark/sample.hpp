@@ -4,12 +4,37 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <iostream>
 #include <numeric>
+#include <string>
+#include <vector>
 
+#include "ScopedTimer.hpp"
 #include "config.hpp"
 
+// The count of the allocations, which is increased by the operator new of
+// the benchmark program.
+inline std::size_t &alloc_count() {
+  static std::size_t count = 0;
+  return count;
+}
+
+struct bench_result {
+  std::string lib;
+  std::string sample;
+  std::string op;
+  std::size_t buffer_size;
+  double mb_per_sec;
+  double mean_ns;
+  // the percentiles of the mean latency of the batches, not of the single
+  // operations.
+  double batch_p50_ns;
+  double batch_p99_ns;
+  double allocs_per_op;
+};
+
 struct base_sample {
   virtual std::string name() const = 0;
   virtual void do_serialization() = 0;
@@ -31,8 +56,59 @@ struct base_sample {
 
   auto &get_ser_time_elapsed_map() { return ser_time_elapsed_map_; }
   auto &get_deser_time_elapsed_map() { return deser_time_elapsed_map_; }
+  const auto &get_results() const { return results_; }
 
  protected:
+  /*
+   * Run f ITERATIONS times after a warm up, and record the throughput of the
+   * buffer, the latency and the allocations per operation. An operation may
+   * be shorter than the resolution of the clock, so the operations are timed
+   * in batches of BATCH_SIZE, and the percentiles are of the mean latency of
+   * the batches, which hide the outliers inside a batch. Return the total ns.
+   */
+  template <typename F>
+  uint64_t run_bench(SampleType sample_type, const char *op,
+                     std::size_t buffer_size, F &&f) {
+    using clock = std::chrono::steady_clock;
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+      f();
+    }
+    std::vector<double> latencies;
+    latencies.reserve(ITERATIONS / BATCH_SIZE);
+    std::string bench_name =
+        name() + " " + op + " " + get_sample_name(sample_type);
+    auto allocs = alloc_count();
+    uint64_t ns = 0;
+    {
+      ScopedTimer timer(bench_name.data(), ns);
+      for (int i = 0; i < ITERATIONS / BATCH_SIZE; ++i) {
+        auto begin = clock::now();
+        for (int j = 0; j < BATCH_SIZE; ++j) {
+          f();
+        }
+        auto batch_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            clock::now() - begin)
+                            .count();
+        latencies.push_back(double(batch_ns) / BATCH_SIZE);
+      }
+    }
+    allocs = alloc_count() - allocs;
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+      auto i = static_cast<std::size_t>(p * (latencies.size() - 1) + 0.5);
+      return latencies[i];
+    };
+    double mean_ns = double(ns) / ITERATIONS;
+    results_.push_back(bench_result{
+        name(), get_sample_name(sample_type), op, buffer_size,
+        // bytes per ns is GB/s.
+        mean_ns > 0 ? buffer_size / mean_ns * 1000 : 0, mean_ns,
+        percentile(0.5), percentile(0.99), double(allocs) / ITERATIONS});
+    return ns;
+  }
+
+  std::vector<bench_result> results_;
   std::unordered_map<SampleType, size_t> buf_size_map_;
   std::unordered_map<SampleType, uint64_t> ser_time_elapsed_map_;
   std::unordered_map<SampleType, uint64_t> deser_time_elapsed_map_;
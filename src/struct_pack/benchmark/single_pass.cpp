@@ -0,0 +1,95 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+
+#include "no_op.h"
+
+// Compare the two pass serialization, which calculates the size before
+// writing, with the single pass serialization into a chunked buffer, which
+// back-patches the metainfo after writing.
+//
+// usage: struct_pack_benchmark_single_pass [count of messages]
+
+using namespace std::chrono;
+
+struct item {
+  std::string name;
+  std::vector<int32_t> values;
+  int64_t id;
+};
+
+struct message {
+  int64_t id;
+  std::string title;
+  std::vector<item> items;
+  std::map<std::string, std::string> tags;
+};
+
+message make_message(int item_count, int name_len) {
+  message m{42, std::string(64, 't')};
+  for (int i = 0; i < item_count; ++i) {
+    m.items.push_back(
+        {std::string(name_len, 'a' + i % 26), std::vector<int32_t>(4, i), i});
+  }
+  for (int i = 0; i < 20; ++i) {
+    m.tags.emplace(std::string(24, 'a' + i), std::string(40, 'v'));
+  }
+  return m;
+}
+
+template <typename Func>
+void bench(const char *name, std::size_t count, Func &&func) {
+  auto begin = steady_clock::now();
+  for (std::size_t i = 0; i < count; ++i) {
+    func();
+  }
+  auto ns = duration_cast<nanoseconds>(steady_clock::now() - begin).count();
+  std::cout << "  " << std::left << std::setw(36) << name << std::right
+            << std::fixed << std::setprecision(2) << std::setw(12)
+            << double(ns) / count << "\n";
+}
+
+void bench_message(const char *title, const message &m, std::size_t count) {
+  std::string buffer;
+  struct_pack::chunked_buffer chunks;
+  auto expected = struct_pack::serialize<std::string>(m);
+  struct_pack::single_pass_serialize_to(chunks, m);
+  std::string result;
+  chunks.append_to(result);
+  if (result != expected) {
+    std::abort();
+  }
+  std::cout << title << ", " << expected.size() << " bytes, ns/msg\n";
+  bench("two pass, std::string", count, [&] {
+    buffer.clear();
+    struct_pack::serialize_to(buffer, m);
+    no_op(buffer);
+  });
+  bench("two pass, chunked_buffer", count, [&] {
+    chunks.clear();
+    struct_pack::serialize_to(chunks, m);
+    no_op((char *)chunks.chunk(0).data());
+  });
+  bench("single pass, chunked_buffer", count, [&] {
+    struct_pack::single_pass_serialize_to(chunks, m);
+    no_op((char *)chunks.chunk(0).data());
+  });
+}
+
+int main(int argc, char **argv) {
+  std::size_t count = argc > 1 ? std::atoll(argv[1]) : 100000;
+  bench_message("small items", make_message(100, 16), count);
+  bench_message("many items", make_message(5000, 16), count / 50);
+  // the width of container length is found in the middle of serialization.
+  auto m = make_message(10, 16);
+  m.items.back().name = std::string(300, 'x');
+  bench_message("long nested string", m, count);
+  return 0;
+}
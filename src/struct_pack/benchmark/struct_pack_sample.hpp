@@ -122,22 +122,17 @@ struct struct_pack_sample : public base_sample {
   template <typename T>
   void serialize(SampleType sample_type, T &sample) {
     {
+      buffer_.clear();
       struct_pack::serialize_to(buffer_, sample);
+      auto size = buffer_.size();
       buffer_.clear();
 
-      uint64_t ns = 0;
-      std::string bench_name =
-          name() + " serialize " + get_sample_name(sample_type);
-
-      {
-        ScopedTimer timer(bench_name.data(), ns);
-        for (int i = 0; i < ITERATIONS; ++i) {
-          buffer_.clear();
-          struct_pack::serialize_to(buffer_, sample);
-          no_op(buffer_);
-          no_op((char *)&sample);
-        }
-      }
+      uint64_t ns = run_bench(sample_type, "serialize", size, [&] {
+        buffer_.clear();
+        struct_pack::serialize_to(buffer_, sample);
+        no_op(buffer_);
+        no_op((char *)&sample);
+      });
       ser_time_elapsed_map_.emplace(sample_type, ns);
     }
     buf_size_map_.emplace(sample_type, buffer_.size());
@@ -150,18 +145,11 @@ struct struct_pack_sample : public base_sample {
 
     U obj;
 
-    uint64_t ns = 0;
-    std::string bench_name =
-        name() + " deserialize " + get_sample_name(sample_type);
-
-    {
-      ScopedTimer timer(bench_name.data(), ns);
-      for (int i = 0; i < ITERATIONS; ++i) {
-        [[maybe_unused]] auto ec = struct_pack::deserialize_to(obj, buffer_);
-        no_op((char *)&obj);
-        no_op(buffer_);
-      }
-    }
+    uint64_t ns = run_bench(sample_type, "deserialize", buffer_.size(), [&] {
+      [[maybe_unused]] auto ec = struct_pack::deserialize_to(obj, buffer_);
+      no_op((char *)&obj);
+      no_op(buffer_);
+    });
     deser_time_elapsed_map_.emplace(sample_type, ns);
   }
 
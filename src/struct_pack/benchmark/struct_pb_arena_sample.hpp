@@ -0,0 +1,94 @@
+#pragma once
+#include <cassert>
+#include <string>
+
+#include "ScopedTimer.hpp"
+#include "data_def_arena.struct_pb.h"
+#include "no_op.h"
+#include "sample.hpp"
+#include "struct_pb_sample.hpp"
+
+namespace struct_pb_arena_sample {
+
+// The messages generated with the arena option. The buffers are serialized
+// from the struct_pb samples, and each deserialization decodes a fresh object
+// from the arena, which is reset after it.
+struct struct_pb_arena_sample_t : public base_sample {
+  static inline constexpr LibType lib_type = LibType::STRUCT_PB_ARENA;
+  std::string name() const override { return get_lib_name(lib_type); }
+
+  void create_samples() override {
+    auto rects = struct_pb_sample::create_rects(OBJECT_COUNT);
+    auto persons = struct_pb_sample::create_persons(OBJECT_COUNT);
+    auto monsters = struct_pb_sample::create_monsters(OBJECT_COUNT);
+    rect_buf_ = struct_pb::serialize<std::string>(rects.rect32_list[0]);
+    rects_buf_ = struct_pb::serialize<std::string>(rects);
+    person_buf_ = struct_pb::serialize<std::string>(persons.person_list[0]);
+    persons_buf_ = struct_pb::serialize<std::string>(persons);
+    monster_buf_ = struct_pb::serialize<std::string>(monsters.monsters[0]);
+    monsters_buf_ = struct_pb::serialize<std::string>(monsters);
+  }
+
+  void do_serialization() override {
+    serialize<rect32>(SampleType::RECT, rect_buf_);
+    serialize<rect32s>(SampleType::RECTS, rects_buf_);
+    serialize<person>(SampleType::PERSON, person_buf_);
+    serialize<persons>(SampleType::PERSONS, persons_buf_);
+    serialize<Monster>(SampleType::MONSTER, monster_buf_);
+    serialize<Monsters>(SampleType::MONSTERS, monsters_buf_);
+  }
+
+  void do_deserialization() override {
+    deserialize<rect32>(SampleType::RECT, rect_buf_);
+    deserialize<rect32s>(SampleType::RECTS, rects_buf_);
+    deserialize<person>(SampleType::PERSON, person_buf_);
+    deserialize<persons>(SampleType::PERSONS, persons_buf_);
+    deserialize<Monster>(SampleType::MONSTER, monster_buf_);
+    deserialize<Monsters>(SampleType::MONSTERS, monsters_buf_);
+  }
+
+ private:
+  template <typename T>
+  void serialize(SampleType sample_type, const std::string& buf) {
+    struct_pb::arena arena;
+    auto sample = arena.create<T>();
+    [[maybe_unused]] auto ok = struct_pb::deserialize_to(sample, buf, arena);
+    assert(ok);
+
+    uint64_t ns = run_bench(sample_type, "serialize", buf.size(), [&] {
+      buffer_.clear();
+      buffer_.resize(struct_pb::internal::get_needed_size(*sample));
+      struct_pb::internal::serialize_to(buffer_.data(), buffer_.size(),
+                                        *sample);
+      no_op(buffer_);
+      no_op((char*)sample.get());
+    });
+
+    ser_time_elapsed_map_.emplace(sample_type, ns);
+    buf_size_map_.emplace(sample_type, buffer_.size());
+  }
+
+  template <typename T>
+  void deserialize(SampleType sample_type, const std::string& buf) {
+    uint64_t ns = run_bench(sample_type, "deserialize", buf.size(), [&] {
+      {
+        auto obj = arena_.create<T>();
+        [[maybe_unused]] auto ok = struct_pb::deserialize_to(obj, buf, arena_);
+        assert(ok);
+        no_op((char*)obj.get());
+      }
+      arena_.reset();
+    });
+    deser_time_elapsed_map_.emplace(sample_type, ns);
+  }
+
+  std::string rect_buf_;
+  std::string rects_buf_;
+  std::string person_buf_;
+  std::string persons_buf_;
+  std::string monster_buf_;
+  std::string monsters_buf_;
+  struct_pb::arena arena_;
+  std::string buffer_;
+};
+}  // namespace struct_pb_arena_sample
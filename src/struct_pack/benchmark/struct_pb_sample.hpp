@@ -127,22 +127,13 @@ struct struct_pb_sample_t : public base_sample {
     buffer_.clear();
     buffer_.resize(sz);
 
-    uint64_t ns = 0;
-    std::string bench_name =
-        name() + " serialize " + get_sample_name(sample_type);
-
-    {
-      ScopedTimer timer(bench_name.data(), ns);
-      for (int i = 0; i < ITERATIONS; ++i) {
-        buffer_.clear();
-        auto sz = struct_pb::internal::get_needed_size(sample);
-        buffer_.resize(sz);
-        struct_pb::internal::serialize_to(buffer_.data(), buffer_.size(),
-                                          sample);
-        no_op(buffer_);
-        no_op((char*)&sample);
-      }
-    }
+    uint64_t ns = run_bench(sample_type, "serialize", sz, [&] {
+      buffer_.clear();
+      buffer_.resize(struct_pb::internal::get_needed_size(sample));
+      struct_pb::internal::serialize_to(buffer_.data(), buffer_.size(), sample);
+      no_op(buffer_);
+      no_op((char*)&sample);
+    });
 
     ser_time_elapsed_map_.emplace(sample_type, ns);
     buf_size_map_.emplace(sample_type, buffer_.size());
@@ -155,23 +146,15 @@ struct struct_pb_sample_t : public base_sample {
     buffer_.resize(sz);
     struct_pb::internal::serialize_to(buffer_.data(), buffer_.size(), sample);
 
-    T obj;
-    // vec.resize(ITERATIONS);
-
-    uint64_t ns = 0;
-    std::string bench_name =
-        name() + " deserialize " + get_sample_name(sample_type);
-
-    {
-      ScopedTimer timer(bench_name.data(), ns);
-      for (int i = 0; i < ITERATIONS; ++i) {
-        [[maybe_unused]] auto ok = struct_pb::internal::deserialize_to(
-            obj, buffer_.data(), buffer_.size());
-        assert(ok);
-        no_op((char*)&obj);
-        no_op(buffer_);
-      }
-    }
+    uint64_t ns = run_bench(sample_type, "deserialize", buffer_.size(), [&] {
+      // the repeated fields are appended to, so decode to a new object.
+      T obj;
+      [[maybe_unused]] auto ok = struct_pb::internal::deserialize_to(
+          obj, buffer_.data(), buffer_.size());
+      assert(ok);
+      no_op((char*)&obj);
+      no_op(buffer_);
+    });
     deser_time_elapsed_map_.emplace(sample_type, ns);
 
     buf_size_map_.emplace(sample_type, buffer_.size());
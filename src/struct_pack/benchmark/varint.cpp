@@ -0,0 +1,129 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+
+#include "no_op.h"
+
+// Compare the bulk varint coding of std::vector<var_uint64_t> with coding the
+// elements one by one, for the values of different byte widths.
+//
+// usage: struct_pack_benchmark_varint [count of values] [rounds]
+
+using namespace std::chrono;
+using struct_pack::var_int64_t;
+using struct_pack::var_uint64_t;
+
+template <typename T>
+std::vector<T> make_values(std::size_t count, int max_bits) {
+  std::mt19937_64 gen{42};
+  std::vector<T> ret;
+  ret.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    auto bits = gen() % max_bits + 1;
+    auto v = gen() >> (64 - bits);
+    if constexpr (std::is_same_v<T, var_int64_t>) {
+      ret.push_back(static_cast<int64_t>(gen() % 2 ? v : -v) >> 1);
+    }
+    else {
+      ret.push_back(v);
+    }
+  }
+  return ret;
+}
+
+template <typename Func>
+double measure_ns(std::size_t rounds, std::size_t count, Func &&func) {
+  auto begin = steady_clock::now();
+  for (std::size_t i = 0; i < rounds; ++i) {
+    func();
+  }
+  auto ns = duration_cast<nanoseconds>(steady_clock::now() - begin).count();
+  return double(ns) / rounds / count;
+}
+
+template <typename T>
+void bench(const char *name, std::size_t count, std::size_t rounds,
+           int max_bits) {
+  auto values = make_values<T>(count, max_bits);
+  std::string storage(count * 10, '\0');
+  std::size_t size = 0;
+
+  // one by one
+  auto scalar_encode = measure_ns(rounds, count, [&] {
+    struct_pack::detail::memory_writer writer{storage.data()};
+    for (auto &v : values) {
+      struct_pack::detail::serialize_varint(writer, v);
+    }
+    size = writer.buffer - storage.data();
+    no_op(storage);
+  });
+  std::vector<T> result(count);
+  auto scalar_decode = measure_ns(rounds, count, [&] {
+    struct_pack::detail::memory_reader reader{storage.data(),
+                                              storage.data() + size};
+    for (auto &v : result) {
+      if (struct_pack::detail::deserialize_varint(reader, v) !=
+          struct_pack::errc{}) {
+        std::abort();
+      }
+    }
+    no_op((char *)result.data());
+  });
+  if (result != values) {
+    std::abort();
+  }
+
+  // bulk, as std::vector<T> is serialized.
+  auto bulk_encode = measure_ns(rounds, count, [&] {
+    struct_pack::detail::memory_writer writer{storage.data()};
+    struct_pack::detail::serialize_varint_bulk(writer, values.data(),
+                                               values.size());
+    size = writer.buffer - storage.data();
+    no_op(storage);
+  });
+  auto bulk_decode = measure_ns(rounds, count, [&] {
+    const char *now = storage.data();
+    auto n = struct_pack::detail::deserialize_varint_bulk(
+        now, storage.data() + size, result.data(), result.size());
+    struct_pack::detail::memory_reader reader{now, storage.data() + size};
+    for (; n < result.size(); ++n) {
+      if (struct_pack::detail::deserialize_varint(reader, result[n]) !=
+          struct_pack::errc{}) {
+        std::abort();
+      }
+    }
+    no_op((char *)result.data());
+  });
+  if (result != values) {
+    std::abort();
+  }
+
+  std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+            << std::setprecision(2) << std::setw(10) << scalar_encode
+            << std::setw(10) << bulk_encode << std::setw(10) << scalar_decode
+            << std::setw(10) << bulk_decode << std::setw(10)
+            << double(size) / count << "\n";
+}
+
+int main(int argc, char **argv) {
+  std::size_t count = argc > 1 ? std::atoll(argv[1]) : 100000;
+  std::size_t rounds = argc > 2 ? std::atoll(argv[2]) : 100;
+  std::cout << "varint window: " << struct_pack::detail::varint_window_size
+            << " bytes, " << count << " values, ns per value\n";
+  std::cout << std::left << std::setw(28) << "values" << std::right
+            << std::setw(10) << "enc" << std::setw(10) << "bulk enc"
+            << std::setw(10) << "dec" << std::setw(10) << "bulk dec"
+            << std::setw(10) << "bytes" << "\n";
+  bench<var_uint64_t>("uint64 (7 bits)", count, rounds, 7);
+  bench<var_uint64_t>("uint64 (14 bits)", count, rounds, 14);
+  bench<var_uint64_t>("uint64 (28 bits)", count, rounds, 28);
+  bench<var_uint64_t>("uint64 (64 bits)", count, rounds, 64);
+  bench<var_int64_t>("int64 zigzag (14 bits)", count, rounds, 14);
+  return 0;
+}
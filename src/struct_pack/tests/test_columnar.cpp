@@ -0,0 +1,163 @@
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <optional>
+#include <string>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+
+#include "doctest.h"
+
+using namespace struct_pack;
+
+namespace test_columnar {
+struct point {
+  float x;
+  float y;
+  int32_t id;
+  static constexpr auto struct_pack_config = ENCODING_WITH_COLUMNAR;
+  bool operator==(const point &) const = default;
+};
+
+struct point_by_row {
+  float x;
+  float y;
+  int32_t id;
+};
+
+struct record {
+  std::string name;
+  int64_t timestamp;
+  std::vector<int32_t> values;
+  std::optional<point> location;
+  uint32_t count;
+  static constexpr auto struct_pack_config =
+      ENCODING_WITH_COLUMNAR | ENCODING_WITH_VARINT;
+  bool operator==(const record &) const = default;
+};
+
+struct batch {
+  std::string name;
+  std::vector<record> records;
+  std::list<point> points;
+  bool operator==(const batch &) const = default;
+};
+
+std::vector<record> make_records(std::size_t n) {
+  std::vector<record> ret;
+  for (std::size_t i = 0; i < n; ++i) {
+    ret.push_back(record{"record" + std::to_string(i), 1700000000 + (int64_t)i,
+                         std::vector<int32_t>(i % 5, (int32_t)i),
+                         i % 2 ? std::optional<point>{} : point{1, 2, (int)i},
+                         (uint32_t)i * 3});
+  }
+  return ret;
+}
+}  // namespace test_columnar
+
+using namespace test_columnar;
+
+TEST_CASE("test columnar encoding") {
+  std::vector<point> points;
+  for (int i = 0; i < 100; ++i) {
+    points.push_back({i * 1.0f, i * 2.0f, i});
+  }
+  auto buffer = serialize<DISABLE_ALL_META_INFO>(points);
+  std::vector<point_by_row> by_row;
+  for (auto &p : points) {
+    by_row.push_back({p.x, p.y, p.id});
+  }
+  auto row_buffer = serialize<DISABLE_ALL_META_INFO>(by_row);
+  REQUIRE(buffer.size() == row_buffer.size());
+  // the values of x are placed continuously after the length.
+  auto column = buffer.data() + buffer.size() - 100 * sizeof(point);
+  CHECK(memcmp(column, &points[0].x, sizeof(float)) == 0);
+  CHECK(memcmp(column + sizeof(float), &points[1].x, sizeof(float)) == 0);
+  CHECK(memcmp(column + 100 * sizeof(float), &points[0].y, sizeof(float)) ==
+        0);
+  CHECK(get_type_code<std::vector<point>>() !=
+        get_type_code<std::vector<point_by_row>>());
+
+  auto result = deserialize<std::vector<point>>(serialize(points));
+  REQUIRE(result.has_value());
+  CHECK(result.value() == points);
+
+  SUBCASE("other containers") {
+    std::deque<point> d{points.begin(), points.end()};
+    auto result = deserialize<std::deque<point>>(serialize(d));
+    REQUIRE(result.has_value());
+    CHECK(result.value() == d);
+    std::list<point> l{points.begin(), points.end()};
+    auto result2 = deserialize<std::list<point>>(serialize(l));
+    REQUIRE(result2.has_value());
+    CHECK(result2.value() == l);
+  }
+  SUBCASE("non-trivial members") {
+    auto records = make_records(300);
+    auto buffer = serialize(records);
+    CHECK(buffer.size() == get_needed_size(records).size());
+    auto result = deserialize<std::vector<record>>(buffer);
+    REQUIRE(result.has_value());
+    CHECK(result.value() == records);
+  }
+  SUBCASE("nested") {
+    batch b{"batch", make_records(10), {points.begin(), points.end()}};
+    auto buffer = serialize(b);
+    auto result = deserialize<batch>(buffer);
+    REQUIRE(result.has_value());
+    CHECK(result.value() == b);
+    auto name = get_field<batch, 0>(buffer);
+    REQUIRE(name.has_value());
+    CHECK(name.value() == b.name);
+    auto list = get_field<batch, 2>(buffer);
+    REQUIRE(list.has_value());
+    CHECK(list.value() == b.points);
+  }
+  SUBCASE("broken buffer") {
+    auto buffer = serialize(make_records(10));
+    buffer.resize(buffer.size() - 1);
+    auto result = deserialize<std::vector<record>>(buffer);
+    CHECK(!result.has_value());
+  }
+}
+
+TEST_CASE("test get column") {
+  auto records = make_records(100);
+  auto buffer = serialize(records);
+  auto names = get_column<std::vector<record>, 0>(buffer);
+  REQUIRE(names.has_value());
+  REQUIRE(names->size() == records.size());
+  CHECK(names.value()[99] == records[99].name);
+  auto counts = get_column<std::vector<record>, 4>(buffer);
+  REQUIRE(counts.has_value());
+  REQUIRE(counts->size() == records.size());
+  CHECK(counts.value()[99] == records[99].count);
+  auto locations = get_column<std::vector<record>, 3>(buffer);
+  REQUIRE(locations.has_value());
+  CHECK(locations.value()[0] == records[0].location);
+
+  std::vector<point> points;
+  for (int i = 0; i < 100; ++i) {
+    points.push_back({i * 1.0f, i * 2.0f, i});
+  }
+  auto buffer2 = serialize(points);
+  auto ys = get_column_view<std::vector<point>, 1>(buffer2);
+  REQUIRE(ys.has_value());
+  REQUIRE(ys->size() == points.size());
+  float sum = 0;
+  for (float y : ys.value()) {
+    sum += y;
+  }
+  CHECK(sum == 9900.0f);
+  auto ids = get_column_view<std::vector<point>, 2>(buffer2.data(),
+                                                    buffer2.size());
+  REQUIRE(ids.has_value());
+  CHECK(ids.value()[42] == 42);
+
+  buffer2.resize(buffer2.size() - 1);
+  auto broken = get_column_view<std::vector<point>, 2>(buffer2);
+  REQUIRE(!broken.has_value());
+  CHECK(broken.error() == errc::no_buffer_space);
+  auto bad_type = get_column<std::vector<record>, 0>(buffer2);
+  CHECK(!bad_type.has_value());
+}
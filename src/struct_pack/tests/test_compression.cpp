@@ -0,0 +1,149 @@
+#include <cstdint>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+
+#include "doctest.h"
+
+using namespace struct_pack;
+
+namespace test_compression {
+struct log_entry {
+  int64_t timestamp;
+  std::string level;
+  std::string message;
+  std::map<std::string, std::string> labels;
+  bool operator==(const log_entry &) const = default;
+};
+
+std::vector<log_entry> make_logs(std::size_t n) {
+  std::vector<log_entry> ret;
+  for (std::size_t i = 0; i < n; ++i) {
+    ret.push_back({1700000000 + (int64_t)i, i % 7 ? "INFO" : "WARN",
+                   "request " + std::to_string(i) + " finished in " +
+                       std::to_string(i % 100) + "ms",
+                   {{"host", "server-" + std::to_string(i % 3)},
+                    {"service", "struct_pack"}}});
+  }
+  return ret;
+}
+
+std::string compress(const std::string &raw) {
+  std::string ret(detail::lz_compress_bound(raw.size()), '\0');
+  ret.resize(detail::lz_compress(raw.data(), raw.size(), ret.data()));
+  return ret;
+}
+}  // namespace test_compression
+
+using namespace test_compression;
+
+TEST_CASE("test lz block codec") {
+  std::mt19937 gen{42};
+  std::vector<std::string> cases{"", "a", "abcdefghijklm", std::string(13, 'a'),
+                                 std::string(100000, 'x')};
+  std::string random(5000, '\0');
+  for (auto &c : random) {
+    c = (char)gen();
+  }
+  cases.push_back(random);
+  std::string text;
+  for (int i = 0; i < 2000; ++i) {
+    text += "struct_pack " + std::to_string(i % 37) + " ";
+  }
+  cases.push_back(text);
+  for (std::size_t size = 0; size < 40; ++size) {
+    cases.push_back(text.substr(0, size));
+  }
+  for (auto &raw : cases) {
+    auto compressed = compress(raw);
+    CHECK(compressed.size() <= detail::lz_compress_bound(raw.size()));
+    std::string result(raw.size(), '\0');
+    REQUIRE(detail::lz_decompress(compressed.data(), compressed.size(),
+                                  result.data(), result.size()));
+    CHECK(result == raw);
+  }
+  CHECK(compress(text).size() < text.size() / 4);
+  CHECK(compress(std::string(100000, 'x')).size() < 1000);
+
+  SUBCASE("corrupted block") {
+    auto compressed = compress(text);
+    std::string result(text.size(), '\0');
+    CHECK(!detail::lz_decompress(compressed.data(), compressed.size() - 1,
+                                 result.data(), result.size()));
+    CHECK(!detail::lz_decompress(compressed.data(), compressed.size(),
+                                 result.data(), result.size() - 1));
+    for (int i = 0; i < 1000; ++i) {
+      auto broken = compressed;
+      broken[gen() % broken.size()] = (char)gen();
+      // must not read or write out of bounds.
+      (void)detail::lz_decompress(broken.data(), broken.size(), result.data(),
+                                  result.size());
+    }
+  }
+}
+
+TEST_CASE("test compressed writer and reader") {
+  auto logs = make_logs(1000);
+  auto raw = serialize<std::string>(logs);
+  std::stringstream ss;
+  compressed_writer writer{ss};
+  serialize_to(writer, logs);
+  writer.flush();
+  auto compressed = ss.str();
+  CHECK(compressed.size() < raw.size() / 2);
+
+  compressed_reader reader{ss};
+  auto result = deserialize<std::vector<log_entry>>(reader);
+  REQUIRE(result.has_value());
+  CHECK(result.value() == logs);
+  CHECK(reader.tellg() == raw.size());
+
+  SUBCASE("small blocks and many objects") {
+    std::stringstream ss;
+    compressed_writer writer{ss, 100};
+    for (auto &log : logs) {
+      serialize_to(writer, log);
+    }
+    writer.flush();
+    compressed_reader reader{ss};
+    for (auto &log : logs) {
+      log_entry entry;
+      REQUIRE(deserialize_to(entry, reader) == errc{});
+      CHECK(entry == log);
+    }
+    log_entry entry;
+    CHECK(deserialize_to(entry, reader) != errc{});
+  }
+  SUBCASE("incompressible data") {
+    std::mt19937 gen{42};
+    std::string data(200000, '\0');
+    for (auto &c : data) {
+      c = (char)gen();
+    }
+    std::stringstream ss;
+    compressed_writer writer{ss};
+    serialize_to(writer, data);
+    writer.flush();
+    CHECK(ss.str().size() <
+          data.size() + 16 * (data.size() / writer.block_size() + 1));
+    compressed_reader reader{ss};
+    auto result = deserialize<std::string>(reader);
+    REQUIRE(result.has_value());
+    CHECK(result.value() == data);
+  }
+  SUBCASE("truncated stream") {
+    std::stringstream ss2(compressed.substr(0, compressed.size() - 10));
+    compressed_reader reader{ss2};
+    auto result = deserialize<std::vector<log_entry>>(reader);
+    CHECK(!result.has_value());
+  }
+  SUBCASE("block too large") {
+    std::stringstream ss2(compressed);
+    compressed_reader reader{ss2, 1024};
+    auto result = deserialize<std::vector<log_entry>>(reader);
+    CHECK(!result.has_value());
+  }
+}
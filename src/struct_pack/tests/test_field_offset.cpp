@@ -0,0 +1,194 @@
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+
+#include "doctest.h"
+
+using namespace struct_pack;
+
+namespace test_field_offset {
+struct address {
+  std::string city;
+  std::vector<std::string> streets;
+  int32_t zip;
+  static constexpr auto struct_pack_config = ENCODING_WITH_FIELD_OFFSET;
+  bool operator==(const address &) const = default;
+};
+
+struct person {
+  std::string name;
+  std::vector<int32_t> scores;
+  address addr;
+  std::map<std::string, std::string> tags;
+  std::optional<int64_t> id;
+  static constexpr auto struct_pack_config = ENCODING_WITH_FIELD_OFFSET;
+  bool operator==(const person &) const = default;
+};
+
+struct person_without_table {
+  std::string name;
+  std::vector<int32_t> scores;
+  address addr;
+  std::map<std::string, std::string> tags;
+  std::optional<int64_t> id;
+};
+
+struct varint_record {
+  std::string name;
+  int64_t a;
+  uint32_t b;
+  static constexpr auto struct_pack_config =
+      ENCODING_WITH_FIELD_OFFSET | ENCODING_WITH_VARINT;
+  bool operator==(const varint_record &) const = default;
+};
+
+person make_person() {
+  return person{"tom",
+                {1, 2, 3},
+                {"hangzhou", {"wensan road", "wener road"}, 310000},
+                {{"k1", "v1"}, {"k2", "v2"}},
+                42};
+}
+}  // namespace test_field_offset
+
+using namespace test_field_offset;
+
+TEST_CASE("test field offset table encoding") {
+  auto p = make_person();
+  auto buffer = serialize(p);
+  auto payload = serialize<DISABLE_ALL_META_INFO>(p);
+  auto plain = serialize<DISABLE_ALL_META_INFO>(
+      person_without_table{p.name, p.scores, p.addr, p.tags, p.id});
+  // the table of person has 5 entries, address has its table in both.
+  CHECK(payload.size() == plain.size() + 4 * 5);
+  CHECK(get_type_code<person>() != get_type_code<person_without_table>());
+
+  auto result = deserialize<person>(buffer);
+  REQUIRE(result.has_value());
+  CHECK(result.value() == p);
+
+  auto r2 = deserialize<person_without_table>(buffer);
+  CHECK(!r2.has_value());
+
+  SUBCASE("large container") {
+    p.scores.resize(100000, 7);
+    p.addr.streets.resize(300, std::string(300, 'a'));
+    auto buffer = serialize(p);
+    auto result = deserialize<person>(buffer);
+    REQUIRE(result.has_value());
+    CHECK(result.value() == p);
+    auto id = get_field<person, 4>(buffer);
+    REQUIRE(id.has_value());
+    CHECK(id.value() == 42);
+    auto zip = get_view<person>(buffer)->get_view<2>()->get<2>();
+    REQUIRE(zip.has_value());
+    CHECK(zip.value() == 310000);
+  }
+  SUBCASE("varint") {
+    varint_record r{"hello", -1, 300};
+    auto buffer = serialize(r);
+    auto result = deserialize<varint_record>(buffer);
+    REQUIRE(result.has_value());
+    CHECK(result.value() == r);
+    auto b = get_field<varint_record, 2>(buffer);
+    REQUIRE(b.has_value());
+    CHECK(b.value() == 300);
+    auto v = get_view<varint_record>(buffer);
+    REQUIRE(v.has_value());
+    auto a = v->get<1>();
+    REQUIRE(a.has_value());
+    CHECK(a.value() == -1);
+  }
+  SUBCASE("nested in container") {
+    std::vector<address> addrs{p.addr, p.addr, p.addr};
+    addrs[1].zip = 1;
+    auto buffer = serialize(addrs);
+    auto result = deserialize<std::vector<address>>(buffer);
+    REQUIRE(result.has_value());
+    CHECK(result.value() == addrs);
+  }
+  SUBCASE("stream writer") {
+    // the tables are calculated before writing instead of back-patched.
+    std::vector<person> persons{p, p};
+    persons[1].addr.streets.resize(100, std::string(100, 'a'));
+    std::ostringstream os;
+    serialize_to(os, persons);
+    CHECK(os.str() == serialize<std::string>(persons));
+  }
+}
+
+TEST_CASE("test get_field with field offset table") {
+  auto p = make_person();
+  auto buffer = serialize(p);
+  auto name = get_field<person, 0>(buffer);
+  REQUIRE(name.has_value());
+  CHECK(name.value() == p.name);
+  auto addr = get_field<person, 2>(buffer);
+  REQUIRE(addr.has_value());
+  CHECK(addr.value() == p.addr);
+  auto tags = get_field<person, 3>(buffer);
+  REQUIRE(tags.has_value());
+  CHECK(tags.value() == p.tags);
+
+  auto broken = buffer;
+  // cut off the id and the last bytes of tags
+  broken.resize(broken.size() - 12);
+  auto broken_tags = get_field<person, 3>(broken);
+  CHECK(!broken_tags.has_value());
+}
+
+TEST_CASE("test struct_pack::view") {
+  auto p = make_person();
+  auto buffer = serialize(p);
+  auto v = get_view<person>(buffer);
+  REQUIRE(v.has_value());
+  auto scores = v->get<1>();
+  REQUIRE(scores.has_value());
+  CHECK(scores.value() == p.scores);
+  auto id = v->get<4>();
+  REQUIRE(id.has_value());
+  CHECK(id.value() == p.id);
+
+  auto addr = v->get_view<2>();
+  REQUIRE(addr.has_value());
+  auto streets = addr->get<1>();
+  REQUIRE(streets.has_value());
+  CHECK(streets.value() == p.addr.streets);
+  auto city = addr->get<0>();
+  REQUIRE(city.has_value());
+  CHECK(city.value() == p.addr.city);
+
+  std::string tag_to;
+  auto ec = view<address>{}.get_to<0>(tag_to);
+  CHECK(ec == errc::no_buffer_space);
+
+  SUBCASE("without field offset table") {
+    person_without_table q{p.name, p.scores, p.addr, p.tags, p.id};
+    auto buffer = serialize(q);
+    auto v = get_view<person_without_table>(buffer);
+    REQUIRE(v.has_value());
+    auto tags = v->get<3>();
+    REQUIRE(tags.has_value());
+    CHECK(tags.value() == q.tags);
+  }
+  SUBCASE("bad hash") {
+    auto v = get_view<person_without_table>(buffer);
+    CHECK(!v.has_value());
+  }
+  SUBCASE("corrupted offset") {
+    auto broken = buffer;
+    // the first entry of the table is the end offset of name.
+    auto table = v->data() - buffer.data();
+    broken[table] = (char)0xff;
+    broken[table + 1] = (char)0xff;
+    auto v = get_view<person>(broken);
+    REQUIRE(v.has_value());
+    auto scores = v->get<1>();
+    REQUIRE(!scores.has_value());
+    CHECK(scores.error() == errc::invalid_buffer);
+  }
+}
@@ -0,0 +1,137 @@
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+
+#include "doctest.h"
+
+using namespace struct_pack;
+
+namespace test_member_runs {
+struct mixed {
+  int32_t a;
+  int32_t b;
+  int16_t c;
+  int16_t d;
+  std::string s;
+  float x;
+  double y;
+  std::array<char, 3> z;
+  std::vector<int32_t> v;
+  bool operator==(const mixed &) const = default;
+};
+
+struct padded {
+  int32_t a;
+  alignas(8) int32_t b;
+  std::string s;
+  bool operator==(const padded &) const = default;
+};
+
+struct reordered {
+  int32_t a;
+  int32_t b;
+  int32_t c;
+  std::string s;
+  bool operator==(const reordered &) const = default;
+};
+STRUCT_PACK_REFL(reordered, c, a, b, s);
+
+struct reordered_by_declaration {
+  int32_t c;
+  int32_t a;
+  int32_t b;
+  std::string s;
+};
+
+struct with_varint {
+  int32_t a;
+  int32_t b;
+  double d;
+  std::string s;
+  static constexpr auto struct_pack_config = ENCODING_WITH_VARINT;
+  bool operator==(const with_varint &) const = default;
+};
+
+struct nested {
+  mixed m;
+  int64_t id;
+  padded p;
+  int64_t count;
+  int64_t sum;
+  bool operator==(const nested &) const = default;
+};
+}  // namespace test_member_runs
+
+using namespace test_member_runs;
+
+TEST_CASE("test member runs layout") {
+  constexpr auto runs = detail::member_runs<mixed>;
+  static_assert(runs[0].length == 4 && runs[0].size == 12);
+  static_assert(runs[1].length == 0 && runs[3].length == 0);
+  static_assert(runs[4].length == 1);
+  // padding between x and y.
+  static_assert(runs[5].length == 1 && runs[6].length == 2);
+  static_assert(runs[6].size == sizeof(double) + 3);
+  static_assert(runs[8].length == 1);
+  static_assert(detail::member_runs<with_varint>[0].length == 1);
+  static_assert(detail::member_runs<with_varint>[1].length == 1);
+  static_assert(detail::member_runs<nested>[1].length == 1);
+  static_assert(detail::member_runs<nested>[3].length == 2);
+  static_assert(detail::member_runs<nested>[3].size == 16);
+}
+
+TEST_CASE("test serialize member runs") {
+  mixed m{1, 2, 3, 4, "hello", 5.5f, 6.5, {'a', 'b', 'c'}, {7, 8, 9}};
+  auto buffer = serialize(m);
+  auto result = deserialize<mixed>(buffer);
+  REQUIRE(result.has_value());
+  CHECK(result.value() == m);
+  // the wire format is the same as serializing members one by one.
+  CHECK(serialize<DISABLE_ALL_META_INFO>(m) ==
+        serialize<DISABLE_ALL_META_INFO>(
+            std::tuple{m.a, m.b, m.c, m.d, m.s, m.x, m.y, m.z, m.v}));
+  auto y = get_field<mixed, 6>(buffer);
+  REQUIRE(y.has_value());
+  CHECK(y.value() == m.y);
+  buffer.resize(buffer.size() - m.v.size() * sizeof(int32_t) - 5);
+  CHECK(!deserialize<mixed>(buffer).has_value());
+
+  SUBCASE("alignas") {
+    padded p{1, 2, "hello"};
+    CHECK(serialize<DISABLE_ALL_META_INFO>(p) ==
+          serialize<DISABLE_ALL_META_INFO>(std::tuple{p.a, p.b, p.s}));
+    auto result = deserialize<padded>(serialize(p));
+    REQUIRE(result.has_value());
+    CHECK(result.value() == p);
+  }
+  SUBCASE("reordered members") {
+    reordered r{1, 2, 3, "hello"};
+    auto buffer = serialize(r);
+    auto result = deserialize<reordered>(buffer);
+    REQUIRE(result.has_value());
+    CHECK(result.value() == r);
+    auto result2 = deserialize<reordered_by_declaration>(buffer);
+    REQUIRE(result2.has_value());
+    CHECK(result2->c == 3);
+    CHECK(result2->a == 1);
+    CHECK(result2->b == 2);
+  }
+  SUBCASE("varint") {
+    with_varint v{1, -2, 3.5, "hello"};
+    auto result = deserialize<with_varint>(serialize(v));
+    REQUIRE(result.has_value());
+    CHECK(result.value() == v);
+  }
+  SUBCASE("nested") {
+    nested n{m, 42, {1, 2, "world"}, 100, 200};
+    auto buffer = serialize(n);
+    auto result = deserialize<nested>(buffer);
+    REQUIRE(result.has_value());
+    CHECK(result.value() == n);
+    auto sum = get_field<nested, 4>(buffer);
+    REQUIRE(sum.has_value());
+    CHECK(sum.value() == 200);
+  }
+}
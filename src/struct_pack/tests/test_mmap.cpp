@@ -0,0 +1,167 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+#include <ylt/struct_pack/mmap.hpp>
+
+#include "doctest.h"
+
+using namespace struct_pack;
+
+namespace test_mmap {
+struct point {
+  int32_t x;
+  int32_t y;
+  bool operator==(const point &) const = default;
+};
+
+struct snapshot {
+  std::string name;
+  std::vector<int32_t> values;
+  point origin;
+  std::vector<point> points;
+  int64_t id;
+};
+
+struct snapshot_view {
+  std::string_view name;
+  std::span<const int32_t> values;
+  trivial_view<point> origin;
+  std::span<const point> points;
+  int64_t id;
+};
+
+struct indexed {
+  std::string name;
+  std::vector<std::string> tags;
+  int64_t id;
+  static constexpr auto struct_pack_config = ENCODING_WITH_FIELD_OFFSET;
+};
+
+snapshot make_snapshot(int64_t id) {
+  snapshot ret{"snapshot " + std::to_string(id), {}, {1, 2}, {}, id};
+  for (int i = 0; i < 1000; ++i) {
+    ret.values.push_back(i);
+    ret.points.push_back({i, -i});
+  }
+  return ret;
+}
+
+void write_file(const std::string &path, const std::string &data) {
+  std::ofstream ofs(path, std::ofstream::binary | std::ofstream::out);
+  ofs.write(data.data(), data.size());
+}
+
+bool in_file(const mmap_file &file, const void *p) {
+  return (const char *)p >= file.data() &&
+         (const char *)p < file.data() + file.size();
+}
+}  // namespace test_mmap
+
+using namespace test_mmap;
+
+TEST_CASE("test mmap file") {
+  static_assert(get_type_code<snapshot>() == get_type_code<snapshot_view>());
+  auto s = make_snapshot(42);
+  write_file("mmap.save", serialize<std::string>(s));
+
+  mmap_file file;
+  REQUIRE(!file.open("mmap.save"));
+  REQUIRE(file.is_open());
+  CHECK(file.view() == serialize<std::string>(s));
+  auto result = deserialize<snapshot_view>(file);
+  REQUIRE(result.has_value());
+  auto &view = result.value();
+  CHECK(view.name == s.name);
+  CHECK(in_file(file, view.name.data()));
+  CHECK(view.values.size() == s.values.size());
+  CHECK(view.values[999] == 999);
+  CHECK(in_file(file, view.values.data()));
+  CHECK(view.origin.get() == s.origin);
+  CHECK(in_file(file, &view.origin.get()));
+  CHECK(view.points[10] == point{10, -10});
+  CHECK(in_file(file, view.points.data()));
+  CHECK(view.id == 42);
+
+  auto id = get_field<snapshot, 4>(file);
+  REQUIRE(id.has_value());
+  CHECK(id.value() == 42);
+
+  SUBCASE("move") {
+    auto data = file.data();
+    mmap_file file2 = std::move(file);
+    CHECK(!file.is_open());
+    CHECK(file2.data() == data);
+    CHECK(view.name == s.name);
+  }
+  SUBCASE("lazy view") {
+    indexed idx{"index", {"a", "b", "c"}, 7};
+    write_file("mmap2.save", serialize<std::string>(idx));
+    mmap_file file2;
+    REQUIRE(!file2.open("mmap2.save"));
+    auto lazy = get_view<indexed>(file2);
+    REQUIRE(lazy.has_value());
+    auto id = lazy->get<2>();
+    REQUIRE(id.has_value());
+    CHECK(id.value() == 7);
+    file2.close();
+    CHECK(!file2.is_open());
+    std::filesystem::remove("mmap2.save");
+  }
+  SUBCASE("errors") {
+    mmap_file missing;
+    auto ec = missing.open("no_such_file.save");
+    CHECK(ec == std::errc::no_such_file_or_directory);
+    CHECK(!missing.is_open());
+    write_file("mmap3.save", "");
+    mmap_file empty;
+    REQUIRE(!empty.open("mmap3.save"));
+    CHECK(empty.is_open());
+    CHECK(empty.size() == 0);
+    CHECK(!deserialize<snapshot_view>(empty).has_value());
+    auto data = serialize<std::string>(s);
+    write_file("mmap3.save", data.substr(0, data.size() - 1));
+    REQUIRE(!empty.open("mmap3.save"));
+    CHECK(deserialize<snapshot_view>(empty).error() ==
+          struct_pack::errc::no_buffer_space);
+    std::filesystem::remove("mmap3.save");
+  }
+  file.close();
+  std::filesystem::remove("mmap.save");
+}
+
+TEST_CASE("test mmap reader") {
+  std::string data;
+  for (int i = 0; i < 10; ++i) {
+    serialize_to(data, make_snapshot(i));
+  }
+  write_file("mmap4.save", data);
+  mmap_reader reader;
+  REQUIRE(!reader.open("mmap4.save"));
+  std::vector<snapshot_view> views;
+  while (!reader.eof()) {
+    snapshot_view view;
+    REQUIRE(deserialize_to(view, reader) == struct_pack::errc{});
+    views.push_back(view);
+  }
+  REQUIRE(views.size() == 10);
+  for (int i = 0; i < 10; ++i) {
+    CHECK(views[i].id == i);
+    CHECK(views[i].name == "snapshot " + std::to_string(i));
+    CHECK(in_file(reader.file(), views[i].points.data()));
+  }
+  CHECK(reader.tellg() == data.size());
+  snapshot_view view;
+  CHECK(deserialize_to(view, reader) != struct_pack::errc{});
+
+  REQUIRE(reader.seekg(0));
+  auto first = deserialize<snapshot>(reader);
+  REQUIRE(first.has_value());
+  CHECK(first->values == make_snapshot(0).values);
+  CHECK(!reader.seekg(data.size() + 1));
+  std::filesystem::remove("mmap4.save");
+}
@@ -0,0 +1,167 @@
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+
+#include "doctest.h"
+
+using namespace struct_pack;
+
+namespace test_parallel {
+struct item {
+  int64_t id;
+  std::string name;
+  std::vector<int32_t> values;
+  std::optional<std::string> note;
+  bool operator==(const item &) const = default;
+};
+
+struct varint_item {
+  int64_t id;
+  uint32_t count;
+  std::string name;
+  static constexpr auto struct_pack_config = ENCODING_WITH_VARINT;
+  bool operator==(const varint_item &) const = default;
+};
+
+struct compatible_item {
+  int32_t id;
+  struct_pack::compatible<std::string> name;
+  bool operator==(const compatible_item &) const = default;
+};
+
+std::vector<item> make_items(std::size_t n, std::size_t max_len) {
+  std::vector<item> ret;
+  for (std::size_t i = 0; i < n; ++i) {
+    ret.push_back({(int64_t)i, std::string(i % max_len, 'a' + i % 26),
+                   std::vector<int32_t>(i % 7, (int32_t)i),
+                   i % 3 ? std::optional<std::string>{}
+                         : std::to_string(i * 1000)});
+  }
+  return ret;
+}
+
+// Schedule each task on a new detached thread, and refuse the task sometimes.
+struct test_executor {
+  std::size_t scheduled = 0;
+  bool schedule(std::function<void()> func) {
+    if (scheduled++ % 5 == 4) {
+      return false;
+    }
+    std::thread(std::move(func)).detach();
+    return true;
+  }
+};
+}  // namespace test_parallel
+
+using namespace test_parallel;
+
+TEST_CASE("test parallel serialize") {
+  static_assert(detail::is_parallel_serializable_container<std::vector<item>>());
+  static_assert(detail::is_parallel_serializable_container<std::deque<item>>());
+  static_assert(!detail::is_parallel_serializable_container<std::list<item>>());
+  static_assert(!detail::is_parallel_serializable_container<std::string>());
+  static_assert(
+      !detail::is_parallel_serializable_container<std::vector<int32_t>>());
+  static_assert(!detail::is_parallel_serializable_container<
+                std::vector<compatible_item>>());
+
+  for (std::size_t max_len : {10, 1000, 70000}) {
+    auto items = make_items(1000, max_len);
+    auto buffer = serialize(items);
+    for (std::size_t parallelism : {1, 2, 3, 8}) {
+      CHECK(parallel_serialize(items, parallelism) == buffer);
+    }
+    CHECK(parallel_serialize(items) == buffer);
+    auto result = deserialize<std::vector<item>>(buffer);
+    REQUIRE(result.has_value());
+    CHECK(result.value() == items);
+  }
+
+  SUBCASE("append to buffer") {
+    auto items = make_items(100, 300);
+    std::string buffer = "head", expected = "head";
+    parallel_serialize_to(buffer, items, 4);
+    serialize_to(expected, items);
+    CHECK(buffer == expected);
+  }
+  SUBCASE("executor") {
+    auto items = make_items(1000, 300);
+    test_executor executor;
+    std::vector<char> buffer;
+    parallel_serialize_to(buffer, items, executor, 4);
+    // the caller is one of the 4 tasks of each of the two phases
+    CHECK(executor.scheduled == 2 * 3);
+    CHECK(buffer == serialize(items));
+  }
+  SUBCASE("thread executor") {
+    auto items = make_items(1000, 300);
+    std::vector<char> buffer;
+    {
+      detail::thread_executor executor(3);
+      parallel_serialize_to(buffer, items, executor, 3);
+      std::mutex mutex;
+      std::set<std::thread::id> threads;
+      for (int phase = 0; phase < 2; ++phase) {
+        detail::parallel_for_each_chunk(executor, 3, 100, [&](std::size_t) {
+          std::lock_guard lock(mutex);
+          threads.insert(std::this_thread::get_id());
+        });
+      }
+      // the threads are reused by both phases
+      CHECK(threads.size() <= 3);
+    }
+    CHECK(buffer == serialize(items));
+  }
+  SUBCASE("called on a thread of the executor") {
+    auto items = make_items(1000, 300);
+    std::vector<char> buffer;
+    {
+      detail::thread_executor executor(1);
+      std::promise<void> done;
+      executor.schedule([&] {
+        parallel_serialize_to(buffer, items, executor, 4);
+        done.set_value();
+      });
+      // the only thread of the executor doesn't wait for the tasks scheduled
+      // after the caller
+      done.get_future().get();
+    }
+    CHECK(buffer == serialize(items));
+  }
+  SUBCASE("config") {
+    auto items = make_items(100, 300);
+    CHECK(parallel_serialize<DISABLE_ALL_META_INFO>(items, 4) ==
+          serialize<DISABLE_ALL_META_INFO>(items));
+    CHECK(parallel_serialize<ENABLE_TYPE_INFO, std::string>(items, 4) ==
+          serialize<ENABLE_TYPE_INFO, std::string>(items));
+  }
+  SUBCASE("small and fallback containers") {
+    std::vector<item> empty;
+    CHECK(parallel_serialize(empty, 4) == serialize(empty));
+    auto one = make_items(1, 10);
+    CHECK(parallel_serialize(one, 4) == serialize(one));
+    std::deque<item> d{one.begin(), one.end()};
+    CHECK(parallel_serialize(d, 4) == serialize(d));
+    auto items = make_items(100, 10);
+    std::list<item> l{items.begin(), items.end()};
+    CHECK(parallel_serialize(l, 4) == serialize(l));
+    std::vector<varint_item> varints;
+    for (int i = 0; i < 100; ++i) {
+      varints.push_back({i * 100000, (uint32_t)i, std::to_string(i)});
+    }
+    CHECK(parallel_serialize(varints, 4) == serialize(varints));
+    std::vector<compatible_item> compatibles(10, {1, std::string{"hello"}});
+    CHECK(parallel_serialize(compatibles, 4) == serialize(compatibles));
+    std::vector<int32_t> ints(1000, 42);
+    CHECK(parallel_serialize(ints, 4) == serialize(ints));
+  }
+}
@@ -0,0 +1,149 @@
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+
+#include "doctest.h"
+
+#if __cpp_lib_memory_resource >= 201603L
+#include <memory_resource>
+
+using namespace struct_pack;
+
+namespace test_pmr {
+struct item {
+  std::pmr::string name;
+  std::pmr::vector<int32_t> values;
+  bool operator==(const item &) const = default;
+};
+
+struct message {
+  int64_t id;
+  std::pmr::string title;
+  std::pmr::vector<item> items;
+  std::pmr::map<std::pmr::string, std::pmr::string> tags;
+  std::optional<std::pmr::vector<std::pmr::string>> notes;
+  bool operator==(const message &) const = default;
+};
+
+struct std_item {
+  std::string name;
+  std::vector<int32_t> values;
+};
+
+struct std_message {
+  int64_t id;
+  std::string title;
+  std::vector<std_item> items;
+  std::map<std::string, std::string> tags;
+  std::optional<std::vector<std::string>> notes;
+};
+
+message make_message(std::pmr::memory_resource *resource) {
+  message m{0, std::pmr::string{resource}, std::pmr::vector<item>{resource},
+            std::pmr::map<std::pmr::string, std::pmr::string>{resource}};
+  m.id = 42;
+  m.title = "a title which is longer than the small string buffer";
+  for (int i = 0; i < 5; ++i) {
+    auto &it = m.items.emplace_back();
+    it.name = "item name which is longer than the small string buffer";
+    it.values.assign(10, i);
+  }
+  m.tags.emplace("a key which is longer than the small string buffer",
+                 "a value which is longer than the small string buffer");
+  m.notes.emplace(3, std::pmr::string(100, 'n'));
+  return m;
+}
+
+// Records the allocations which fall back to the upstream resource.
+class counting_resource : public std::pmr::memory_resource {
+ public:
+  std::size_t count = 0;
+
+ private:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    ++count;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void *p, std::size_t bytes,
+                     std::size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    return this == &other;
+  }
+};
+
+// Sets the default resource, and restores the previous one when it leaves the
+// scope, even if a REQUIRE fails.
+class default_resource_guard {
+ public:
+  explicit default_resource_guard(std::pmr::memory_resource *resource)
+      : previous_(std::pmr::set_default_resource(resource)) {}
+  ~default_resource_guard() { std::pmr::set_default_resource(previous_); }
+  default_resource_guard(const default_resource_guard &) = delete;
+  default_resource_guard &operator=(const default_resource_guard &) = delete;
+
+ private:
+  std::pmr::memory_resource *previous_;
+};
+}  // namespace test_pmr
+
+using namespace test_pmr;
+
+TEST_CASE("test deserialize with memory resource") {
+  auto m = make_message(std::pmr::get_default_resource());
+  auto buffer = serialize(m);
+  CHECK(get_type_code<message>() == get_type_code<std_message>());
+
+  counting_resource upstream;
+  std::pmr::monotonic_buffer_resource arena(64 * 1024, &upstream);
+  counting_resource fallback;
+  default_resource_guard guard(&fallback);
+
+  message result;
+  auto ec = deserialize_to(result, buffer, &arena);
+  REQUIRE(ec == errc{});
+  CHECK(result == m);
+  // the whole message graph is allocated from the arena.
+  CHECK(fallback.count == 0);
+  CHECK(upstream.count == 1);
+  CHECK(result.title.get_allocator().resource() == &arena);
+  CHECK(result.items.get_allocator().resource() == &arena);
+  CHECK(result.items[0].name.get_allocator().resource() == &arena);
+  CHECK(result.items[0].values.get_allocator().resource() == &arena);
+  CHECK(result.tags.get_allocator().resource() == &arena);
+  CHECK(result.tags.begin()->first.get_allocator().resource() == &arena);
+  CHECK(result.notes->get_allocator().resource() == &arena);
+  CHECK((*result.notes)[0].get_allocator().resource() == &arena);
+
+  SUBCASE("deserialize") {
+    auto ret = deserialize<message>(buffer.data(), buffer.size(), &arena);
+    REQUIRE(ret.has_value());
+    CHECK(ret.value() == m);
+    CHECK(ret->items.get_allocator().resource() == &arena);
+  }
+  SUBCASE("reuse the object") {
+    std::pmr::monotonic_buffer_resource arena2(64 * 1024, &upstream);
+    message reused;
+    REQUIRE(deserialize_to(reused, buffer, &arena) == errc{});
+    auto ec = deserialize_to(reused, buffer.data(), buffer.size(), &arena2);
+    REQUIRE(ec == errc{});
+    CHECK(reused == m);
+    CHECK(reused.items[0].name.get_allocator().resource() == &arena2);
+    CHECK(reused.tags.get_allocator().resource() == &arena2);
+  }
+  SUBCASE("std containers") {
+    auto ret = deserialize<std_message>(buffer, &arena);
+    REQUIRE(ret.has_value());
+    CHECK(std::string_view{ret->title} == m.title);
+    CHECK(ret->items.size() == m.items.size());
+  }
+  SUBCASE("broken buffer") {
+    buffer.resize(buffer.size() / 2);
+    message result;
+    CHECK(deserialize_to(result, buffer, &arena) != errc{});
+  }
+}
+#endif
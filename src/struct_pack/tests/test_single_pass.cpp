@@ -0,0 +1,165 @@
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+
+#include "doctest.h"
+
+using namespace struct_pack;
+
+namespace test_single_pass {
+struct item {
+  int64_t id;
+  std::string name;
+  std::vector<int32_t> values;
+  std::optional<std::string> note;
+  bool operator==(const item &) const = default;
+};
+
+struct document {
+  int32_t version;
+  std::vector<item> items;
+  std::map<std::string, std::string> tags;
+  bool operator==(const document &) const = default;
+};
+
+struct point {
+  int32_t x;
+  int32_t y;
+};
+
+struct with_compatible {
+  int32_t id;
+  std::vector<std::string> names;
+  struct_pack::compatible<std::string> note;
+  bool operator==(const with_compatible &) const = default;
+};
+
+struct with_field_offset {
+  std::string name;
+  std::vector<int32_t> values;
+  static constexpr auto struct_pack_config = ENCODING_WITH_FIELD_OFFSET;
+};
+
+struct with_fast_varint {
+  int64_t a;
+  uint32_t b;
+  std::string name;
+  static constexpr auto struct_pack_config = USE_FAST_VARINT;
+};
+
+std::vector<item> make_items(std::size_t n, std::size_t max_len) {
+  std::vector<item> ret;
+  for (std::size_t i = 0; i < n; ++i) {
+    ret.push_back({(int64_t)i, std::string(i % max_len, 'a' + i % 26),
+                   std::vector<int32_t>(i % 7, (int32_t)i),
+                   i % 3 ? std::optional<std::string>{}
+                         : std::to_string(i * 1000)});
+  }
+  return ret;
+}
+
+template <uint64_t conf = sp_config::DEFAULT, typename... Args>
+std::string single_pass(chunked_buffer &buffer, const Args &...args) {
+  single_pass_serialize_to<conf>(buffer, args...);
+  std::string ret;
+  buffer.append_to(ret);
+  return ret;
+}
+}  // namespace test_single_pass
+
+using namespace test_single_pass;
+
+TEST_CASE("test chunked buffer") {
+  chunked_buffer buffer{64};
+  CHECK(buffer.empty());
+  CHECK(buffer.chunk_count() == 0);
+  std::string expected;
+  for (int i = 0; i < 100; ++i) {
+    auto data = std::to_string(i) + std::string(i % 10, 'x');
+    buffer.write(data.data(), data.size());
+    expected += data;
+  }
+  std::string big(1000, 'b');
+  buffer.write(big.data(), big.size());
+  expected += big;
+  CHECK(buffer.size() == expected.size());
+  CHECK(buffer.chunk_count() > 1);
+  std::string result;
+  for (std::size_t i = 0; i < buffer.chunk_count(); ++i) {
+    result += buffer.chunk(i);
+  }
+  CHECK(result == expected);
+
+  buffer.clear();
+  CHECK(buffer.empty());
+  buffer.reserve_front(8);
+  buffer.write("world", 5);
+  buffer.write_front("hello ", 6);
+  std::string s = "> ";
+  buffer.append_to(s);
+  CHECK(s == "> hello world");
+}
+
+TEST_CASE("test single pass serialize") {
+  chunked_buffer buffer;
+  // the width of container length is known from the top level container.
+  auto items = make_items(1000, 100);
+  CHECK(single_pass(buffer, items) == serialize<std::string>(items));
+  // a long string is found during serialization.
+  auto long_items = make_items(10, 10);
+  long_items[9].name = std::string(70000, 'x');
+  CHECK(single_pass(buffer, long_items) == serialize<std::string>(long_items));
+  document doc{1, make_items(100, 300), {{"a", "b"}, {"c", std::string(300, 'd')}}};
+  auto doc_buffer = single_pass(buffer, doc);
+  CHECK(doc_buffer == serialize<std::string>(doc));
+  auto result = deserialize<document>(doc_buffer);
+  REQUIRE(result.has_value());
+  CHECK(result.value() == doc);
+
+  SUBCASE("reuse the buffer") {
+    chunked_buffer buffer{256};
+    for (std::size_t n : {1000, 10, 0, 500}) {
+      auto items = make_items(n, 50);
+      CHECK(single_pass(buffer, items) == serialize<std::string>(items));
+    }
+  }
+  SUBCASE("elements longer than a chunk") {
+    // each element of a container is written into a continuous span.
+    chunked_buffer buffer{64};
+    auto items = make_items(100, 300);
+    CHECK(single_pass(buffer, items) == serialize<std::string>(items));
+    CHECK(buffer.chunk_count() > 1);
+    std::vector<with_fast_varint> varints(50, {-100000, 3, "varint"});
+    CHECK(single_pass(buffer, varints) == serialize<std::string>(varints));
+    std::vector<with_field_offset> fields(50, {"field", {1, 2, 3}});
+    CHECK(single_pass(buffer, fields) == serialize<std::string>(fields));
+  }
+  SUBCASE("types and configs") {
+    point p{1, 2};
+    CHECK(single_pass(buffer, p) == serialize<std::string>(p));
+    CHECK(single_pass(buffer, 42, std::string(300, 'a'), p) ==
+          serialize<std::string>(42, std::string(300, 'a'), p));
+    std::vector<int32_t> ints(100000, 7);
+    CHECK(single_pass(buffer, ints) == serialize<std::string>(ints));
+    CHECK(single_pass<DISABLE_ALL_META_INFO>(buffer, items) ==
+          serialize<DISABLE_ALL_META_INFO, std::string>(items));
+    CHECK(single_pass<ENABLE_TYPE_INFO>(buffer, doc) ==
+          serialize<ENABLE_TYPE_INFO, std::string>(doc));
+    with_compatible c{1, {"a", std::string(1000, 'b')}, std::string{"note"}};
+    CHECK(single_pass(buffer, c) == serialize<std::string>(c));
+    with_compatible big{2, std::vector<std::string>(1000, std::string(100, 'x')),
+                        std::string{"note"}};
+    auto big_buffer = single_pass(buffer, big);
+    CHECK(big_buffer == serialize<std::string>(big));
+    auto big_result = deserialize<with_compatible>(big_buffer);
+    REQUIRE(big_result.has_value());
+    CHECK(big_result.value() == big);
+    with_field_offset f{std::string(300, 'f'), {1, 2, 3}};
+    CHECK(single_pass(buffer, f) == serialize<std::string>(f));
+    with_fast_varint v{-100000, 3, "varint"};
+    CHECK(single_pass(buffer, v) == serialize<std::string>(v));
+  }
+}
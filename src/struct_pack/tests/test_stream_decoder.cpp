@@ -0,0 +1,180 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ylt/struct_pack.hpp>
+
+#include "doctest.h"
+
+using namespace struct_pack;
+
+namespace test_stream_decoder {
+struct record {
+  int64_t id;
+  std::string name;
+  std::vector<int32_t> values;
+  bool operator==(const record &) const = default;
+};
+
+std::vector<record> make_records(std::size_t n) {
+  std::vector<record> records;
+  for (std::size_t i = 0; i < n; ++i) {
+    records.push_back(record{(int64_t)i, std::string(i % 37, 'x'),
+                             std::vector<int32_t>(i % 13, (int32_t)i)});
+  }
+  return records;
+}
+
+template <typename T, uint64_t conf = sp_config::DEFAULT, typename Buffer>
+std::vector<T> decode_in_chunks(const Buffer &buffer, std::size_t chunk_size,
+                                std::size_t &max_buffered) {
+  stream_decoder<T, conf> decoder;
+  std::vector<T> result;
+  max_buffered = 0;
+  for (std::size_t pos = 0; pos < buffer.size(); pos += chunk_size) {
+    auto len = (std::min)(chunk_size, buffer.size() - pos);
+    auto ec = decoder.feed(buffer.data() + pos, len, [&](T &&e) {
+      result.push_back(std::move(e));
+    });
+    REQUIRE(ec == errc::ok);
+    max_buffered = (std::max)(max_buffered, decoder.buffered_size());
+  }
+  auto ec = decoder.finish([&](T &&e) {
+    result.push_back(std::move(e));
+  });
+  CHECK(ec == errc::ok);
+  CHECK(decoder.is_finished());
+  CHECK(decoder.size() == result.size());
+  CHECK(decoder.decoded_size() == result.size());
+  return result;
+}
+}  // namespace test_stream_decoder
+
+using namespace test_stream_decoder;
+
+TEST_CASE("test stream decoder") {
+  auto records = make_records(1000);
+  auto buffer = serialize(records);
+  for (std::size_t chunk_size : {1, 7, 64, 4096, 1 << 20}) {
+    std::size_t max_buffered;
+    auto result = decode_in_chunks<record>(buffer, chunk_size, max_buffered);
+    CHECK(result == records);
+    if (chunk_size <= 4096) {
+      // the incomplete element, plus at most one chunk
+      CHECK(max_buffered < 2 * chunk_size + 200);
+    }
+  }
+  SUBCASE("large container length") {
+    auto values = std::vector<int32_t>(100000);
+    for (std::size_t i = 0; i < values.size(); ++i) values[i] = i;
+    auto buffer = serialize(values);
+    std::size_t max_buffered;
+    auto result = decode_in_chunks<int32_t>(buffer, 1000, max_buffered);
+    CHECK(result == values);
+    CHECK(max_buffered < 1000);
+  }
+  SUBCASE("large element") {
+    // an element of 20000 strings fed in chunks of 16 bytes.
+    auto values = std::vector<std::vector<std::string>>{
+        std::vector<std::string>(20000, "hello"), {"a", "b"}};
+    auto buffer = serialize(values);
+    std::size_t max_buffered;
+    auto result =
+        decode_in_chunks<std::vector<std::string>>(buffer, 16, max_buffered);
+    CHECK(result == values);
+    CHECK(max_buffered < 2 * buffer.size());
+  }
+  SUBCASE("complete element is not held back") {
+    auto values = std::vector<std::vector<std::string>>{
+        std::vector<std::string>(1000, "hello")};
+    auto buffer = serialize(values);
+    stream_decoder<std::vector<std::string>> decoder;
+    std::size_t cnt = 0;
+    for (std::size_t pos = 0; pos < buffer.size(); pos += 16) {
+      auto len = (std::min<std::size_t>)(16, buffer.size() - pos);
+      auto ec = decoder.feed(buffer.data() + pos, len,
+                             [&](std::vector<std::string> &&e) {
+                               CHECK(e == values[0]);
+                               ++cnt;
+                             });
+      REQUIRE(ec == errc::ok);
+    }
+    // the element is passed on by the last chunk, without finish.
+    CHECK(cnt == 1);
+    CHECK(decoder.is_finished());
+  }
+  SUBCASE("without metainfo") {
+    auto buffer = serialize<DISABLE_ALL_META_INFO>(make_records(10));
+    std::size_t max_buffered;
+    auto result = decode_in_chunks<record, DISABLE_ALL_META_INFO>(
+        buffer, 3, max_buffered);
+    CHECK(result == make_records(10));
+  }
+  SUBCASE("empty vector") {
+    auto buffer = serialize(std::vector<record>{});
+    stream_decoder<record> decoder;
+    auto ec = decoder.feed(buffer, [](record &&) {
+      FAIL("no element");
+    });
+    CHECK(ec == errc::ok);
+    CHECK(decoder.is_finished());
+  }
+}
+
+TEST_CASE("test stream decoder with invalid data") {
+  auto buffer = serialize(make_records(10));
+  SUBCASE("hash conflict") {
+    stream_decoder<int32_t> decoder;
+    auto ec = decoder.feed(buffer, [](int32_t &&) {
+    });
+    CHECK(ec == errc::invalid_buffer);
+    ec = decoder.feed(buffer, [](int32_t &&) {
+    });
+    CHECK(ec == errc::invalid_buffer);
+    decoder.reset();
+    auto int_buffer = serialize(std::vector<int32_t>{1, 2, 3});
+    int sum = 0;
+    ec = decoder.feed(int_buffer, [&](int32_t &&i) {
+      sum += i;
+    });
+    CHECK(ec == errc::ok);
+    CHECK(sum == 6);
+  }
+  SUBCASE("truncated") {
+    stream_decoder<record> decoder;
+    std::size_t cnt = 0;
+    auto ec = decoder.feed(buffer.data(), buffer.size() - 1, [&](record &&) {
+      ++cnt;
+    });
+    CHECK(ec == errc::ok);
+    CHECK(!decoder.is_finished());
+    CHECK(cnt == 9);
+    ec = decoder.finish([&](record &&) {
+      ++cnt;
+    });
+    CHECK(ec == errc::no_buffer_space);
+    CHECK(cnt == 9);
+  }
+  SUBCASE("element exceeds max buffer size") {
+    auto buffer = serialize(std::vector<std::string>{std::string(100, 'a')});
+    stream_decoder<std::string> decoder(64);
+    auto ec = decoder.feed(buffer.data(), 32, [](std::string &&) {
+    });
+    CHECK(ec == errc::invalid_buffer);
+  }
+  SUBCASE("corrupted length") {
+    auto buffer = serialize(std::vector<std::string>{"abc"});
+    // the length of the string is before its 3 chars.
+    buffer[buffer.size() - 4] = (char)200;
+    stream_decoder<std::string> decoder(64);
+    auto ec = decoder.feed(buffer, [](std::string &&) {
+    });
+    CHECK(ec == errc::invalid_buffer);
+  }
+  SUBCASE("trailing bytes") {
+    stream_decoder<record> decoder;
+    buffer.push_back('\0');
+    auto ec = decoder.feed(buffer, [](record &&) {
+    });
+    CHECK(ec == errc::invalid_buffer);
+  }
+}
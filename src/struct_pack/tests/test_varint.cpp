@@ -1,4 +1,6 @@
 #include <cstdint>
+#include <list>
+#include <random>
 #include <ylt/struct_pack.hpp>
 
 #include "doctest.h"
@@ -865,4 +867,58 @@ TEST_CASE("test varint by normal int") {
   REQUIRE(result.has_value());
   CHECK(result == v);
   CHECK(buffer.size() == 4);
-}
\ No newline at end of file
+}
+template <typename T>
+void test_bulk_varint(std::mt19937_64 &gen) {
+  using value_type = typename T::value_type;
+  std::vector<T> vec;
+  for (int i = 0; i < 1000; ++i) {
+    // mix of 1 byte and longer varints, and runs of small values.
+    auto bits = (i / 64) % 2 ? gen() % 64 : gen() % 7;
+    vec.push_back(static_cast<value_type>(gen() >> (63 - bits)));
+  }
+  vec.push_back((std::numeric_limits<value_type>::max)());
+  vec.push_back((std::numeric_limits<value_type>::min)());
+  auto buffer = struct_pack::serialize<sp_config::DISABLE_ALL_META_INFO>(vec);
+  // the same as the encoding of elements one by one.
+  std::list<T> list(vec.begin(), vec.end());
+  auto expected = struct_pack::serialize<sp_config::DISABLE_ALL_META_INFO>(list);
+  CHECK(buffer == expected);
+  CHECK(detail::calculate_payload_size(vec).total ==
+        detail::calculate_payload_size(list).total);
+  auto result =
+      struct_pack::deserialize<sp_config::DISABLE_ALL_META_INFO, std::vector<T>>(
+          buffer);
+  REQUIRE(result.has_value());
+  CHECK(result.value() == vec);
+  for (std::size_t sz = 0; sz < 40; ++sz) {
+    std::vector<T> small(vec.begin(), vec.begin() + sz);
+    auto buffer = struct_pack::serialize(small);
+    auto result = struct_pack::deserialize<std::vector<T>>(buffer);
+    REQUIRE(result.has_value());
+    CHECK(result.value() == small);
+    buffer.pop_back();
+    CHECK(struct_pack::deserialize<std::vector<T>>(buffer).error() ==
+          struct_pack::errc::no_buffer_space);
+  }
+}
+
+TEST_CASE("test bulk varint") {
+  std::mt19937_64 gen{42};
+  test_bulk_varint<var_uint64_t>(gen);
+  test_bulk_varint<var_uint32_t>(gen);
+  test_bulk_varint<var_int64_t>(gen);
+  test_bulk_varint<var_int32_t>(gen);
+
+  SUBCASE("too long varint") {
+    std::vector<var_uint64_t> vec(100, 1);
+    auto buffer = struct_pack::serialize(vec);
+    auto pos = buffer.size() - 50;
+    // 11 bytes with continuation bit
+    for (std::size_t i = 0; i < 11; ++i) {
+      buffer[pos + i] = (char)0x81;
+    }
+    CHECK(struct_pack::deserialize<std::vector<var_uint64_t>>(buffer).error() ==
+          struct_pack::errc::invalid_buffer);
+  }
+}
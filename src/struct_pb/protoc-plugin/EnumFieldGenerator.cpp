@@ -129,7 +129,8 @@ RepeatedEnumFieldGenerator::RepeatedEnumFieldGenerator(
     const FieldDescriptor *descriptor, const Options &options)
     : FieldGenerator(descriptor, options) {}
 std::string RepeatedEnumFieldGenerator::cpp_type_name() const {
-  return "std::vector<" + qualified_enum_name(d_->enum_type(), options_) + ">";
+  return vector_type_name(options_) + "<" +
+         qualified_enum_name(d_->enum_type(), options_) + ">";
 }
 
 void RepeatedEnumFieldGenerator::generate_calculate_size(
@@ -274,13 +275,9 @@ case $tag$: {
   if (cur_max_sz > size) {
     return false;
   }
-  while (pos < cur_max_sz) {
-    uint64_t enum_val_tmp{};
-    ok = deserialize_varint(data, pos, cur_max_sz, enum_val_tmp);
-    if (!ok) {
-      return false;
-    }
-    $value$.push_back(static_cast<$enum_name$>(enum_val_tmp));
+  ok = deserialize_packed_varint(data, pos, cur_max_sz, $value$);
+  if (!ok) {
+    return false;
   }
   break;
 }
@@ -210,13 +210,13 @@ std::string FieldGenerator::get_type_name() const {
       return "bool";
     case google::protobuf::FieldDescriptor::TYPE_STRING:
     case google::protobuf::FieldDescriptor::TYPE_BYTES:
-      return "std::string";
+      return string_type_name(options_);
     case google::protobuf::FieldDescriptor::TYPE_MESSAGE: {
       auto m = d_->message_type();
       if (d_->is_map()) {
         auto key = m->field(0);
         auto value = m->field(1);
-        std::string type_name = "std::map<";
+        std::string type_name = map_type_name(options_) + "<";
         type_name += FieldGenerator(key, options_).get_type_name();
         type_name += ", ";
         type_name += FieldGenerator(value, options_).get_type_name();
@@ -237,7 +237,7 @@ std::string FieldGenerator::get_type_name() const {
           return m->name();
         }
         else {
-          return "std::unique_ptr<" +
+          return message_ptr_type_name(options_) + "<" +
                  qualified_class_name(d_->message_type(), options_) + ">";
         }
       }
@@ -384,7 +384,7 @@ void OneofGenerator::generate_definition(google::protobuf::io::Printer *p) {
     std::string type_name = fg.get_type_name();
     if (is_message(f)) {
       type_name = qualified_class_name(f->message_type(), options_);
-      type_name = "std::unique_ptr<" + type_name + ">";
+      type_name = message_ptr_type_name(options_) + "<" + type_name + ">";
     }
     else if (is_enum(f)) {
       type_name = qualified_enum_name(f->enum_type(), options_);
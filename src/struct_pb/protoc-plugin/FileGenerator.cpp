@@ -14,9 +14,11 @@ FileGenerator::FileGenerator(const google::protobuf::FileDescriptor *file,
                              Options options)
     : GeneratorBase(options), file_(file) {
   //  std::vector<const Descriptor*> msgs = flatten_messages_in_file(file);
-  for (int i = 0; i < file_->message_type_count(); ++i) {
-    message_generators_.push_back(
-        std::make_unique<MessageGenerator>(file_->message_type(i), options));
+  for (const auto &message_options : all_message_options()) {
+    for (int i = 0; i < file_->message_type_count(); ++i) {
+      message_generators_.push_back(std::make_unique<MessageGenerator>(
+          file_->message_type(i), message_options));
+    }
   }
   for (int i = 0; i < file->enum_type_count(); ++i) {
     enum_generators_.push_back(
@@ -24,6 +26,14 @@ FileGenerator::FileGenerator(const google::protobuf::FileDescriptor *file,
   }
 }
 
+std::vector<Options> FileGenerator::all_message_options() const {
+  std::vector<Options> ret{options_};
+  if (options_.generate_view) {
+    ret.push_back(options_);
+    ret.back().view = true;
+  }
+  return ret;
+}
 void FileGenerator::generate_enum_definitions(
     google::protobuf::io::Printer *p) {
   for (int i = 0; i < enum_generators_.size(); ++i) {
@@ -53,6 +63,7 @@ void FileGenerator::generate_header(google::protobuf::io::Printer *p) {
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <variant>
 #include <vector>
@@ -70,9 +81,11 @@ void FileGenerator::generate_header(google::protobuf::io::Printer *p) {
 
 void FileGenerator::generate_fwd_decls(google::protobuf::io::Printer *p) {
   Formatter format(p);
-  for (int i = 0; i < file_->message_type_count(); ++i) {
-    auto m = file_->message_type(i);
-    format("struct $1$;\n", resolve_keyword(m->name()));
+  for (const auto &message_options : all_message_options()) {
+    for (int i = 0; i < file_->message_type_count(); ++i) {
+      auto m = file_->message_type(i);
+      format("struct $1$;\n", struct_name(m, message_options.view));
+    }
   }
 }
 void FileGenerator::generate_dependency_includes(
@@ -94,31 +107,33 @@ void FileGenerator::generate_message_struct_pb_func_definitions(
   Formatter format(p);
   format("namespace struct_pb {\n");
   format("namespace internal {\n");
-  for (auto msg : msgs) {
-    auto name = qualified_class_name(msg, options_);
-    format("// $1$\n", name);
-    format(
-        "template<>\n"
-        "std::size_t get_needed_size<$1$>(const $1$& t, const "
-        "::struct_pb::UnknownFields& unknown_fields);\n",
-        name);
-    format(
-        "template<>\n"
-        "void serialize_to<$1$>(char* data, std::size_t size, const $1$& t, "
-        "const "
-        "::struct_pb::UnknownFields& unknown_fields);\n",
-        name);
-    format(
-        "template<>\n"
-        "bool deserialize_to<$1$>($1$& t, const char* data, std::size_t size, "
-        "::struct_pb::UnknownFields& unknown_fields);\n",
-        name);
-    format(
-        "template<>\n"
-        "bool deserialize_to<$1$>($1$& t, const char* data, std::size_t "
-        "size);\n",
-        name);
-    format("\n");
+  for (const auto &message_options : all_message_options()) {
+    for (auto msg : msgs) {
+      auto name = qualified_class_name(msg, message_options);
+      format("// $1$\n", name);
+      format(
+          "template<>\n"
+          "std::size_t get_needed_size<$1$>(const $1$& t, const "
+          "::struct_pb::UnknownFields& unknown_fields);\n",
+          name);
+      format(
+          "template<>\n"
+          "void serialize_to<$1$>(char* data, std::size_t size, const $1$& t, "
+          "const "
+          "::struct_pb::UnknownFields& unknown_fields);\n",
+          name);
+      format(
+          "template<>\n"
+          "bool deserialize_to<$1$>($1$& t, const char* data, "
+          "std::size_t size, ::struct_pb::UnknownFields& unknown_fields);\n",
+          name);
+      format(
+          "template<>\n"
+          "bool deserialize_to<$1$>($1$& t, const char* data, std::size_t "
+          "size);\n",
+          name);
+      format("\n");
+    }
   }
   format("} // internal\n");
   format("} // struct_pb\n");
@@ -129,60 +144,61 @@ void FileGenerator::generate_message_struct_pb_func_source(
   Formatter format(p);
   format("namespace struct_pb {\n");
   format("namespace internal {\n");
-  for (auto msg : msgs) {
-    auto name = qualified_class_name(msg, options_);
-    MessageGenerator g(msg, options_);
-    format("// $1$\n", name);
-    format(
-        "template<>\n"
-        "std::size_t get_needed_size<$1$>(const $1$& t, const "
-        "::struct_pb::UnknownFields& unknown_fields) {\n",
-        name);
-    format.indent();
-    g.generate_get_needed_size(p);
-    format.outdent();
-    format(
-        "} // std::size_t get_needed_size<$1$>(const $1$& t, const "
-        "::struct_pb::UnknownFields& unknown_fields)\n",
-        name);
+  for (const auto &message_options : all_message_options()) {
+    for (auto msg : msgs) {
+      auto name = qualified_class_name(msg, message_options);
+      MessageGenerator g(msg, message_options);
+      format("// $1$\n", name);
+      format(
+          "template<>\n"
+          "std::size_t get_needed_size<$1$>(const $1$& t, const "
+          "::struct_pb::UnknownFields& unknown_fields) {\n",
+          name);
+      format.indent();
+      g.generate_get_needed_size(p);
+      format.outdent();
+      format(
+          "} // std::size_t get_needed_size<$1$>(const $1$& t, const "
+          "::struct_pb::UnknownFields& unknown_fields)\n",
+          name);
 
-    format(
-        "template<>\n"
-        "void serialize_to<$1$>(char* data, std::size_t size, const $1$& t, "
-        "const ::struct_pb::UnknownFields& unknown_fields) {\n",
-        name);
-    format.indent();
-    g.generate_serialize_to(p);
-    format.outdent();
-    format(
-        "} // void serialize_to<$1$>(char* data, std::size_t size, const $1$& "
-        "t, "
-        "const ::struct_pb::UnknownFields& unknown_fields)\n",
-        name);
+      format(
+          "template<>\n"
+          "void serialize_to<$1$>(char* data, std::size_t size, const $1$& t, "
+          "const ::struct_pb::UnknownFields& unknown_fields) {\n",
+          name);
+      format.indent();
+      g.generate_serialize_to(p);
+      format.outdent();
+      format(
+          "} // void serialize_to<$1$>(char* data, std::size_t size, "
+          "const $1$& t, const ::struct_pb::UnknownFields& unknown_fields)\n",
+          name);
 
-    format(
-        "template<>\n"
-        "bool deserialize_to<$1$>($1$& t, const char* data, std::size_t size, "
-        "::struct_pb::UnknownFields& unknown_fields) {\n",
-        name);
-    format.indent();
-    g.generate_deserialize_to(p);
-    format.outdent();
-    format("return true;\n");
-    format("} // bool deserialize_to<$1$>($1$&, const char*, std::size_t)\n",
-           name);
-    format("// end of $1$\n", name);
-    format(
-        "template<>\n"
-        "bool deserialize_to<$1$>($1$& t, const char* data, std::size_t size) "
-        "{\n",
-        name);
-    format.indent();
-    format("::struct_pb::UnknownFields unknown_fields{};\n");
-    format("return deserialize_to(t,data,size,unknown_fields);\n");
-    format.outdent();
-    format("}\n");
-    format("\n");
+      format(
+          "template<>\n"
+          "bool deserialize_to<$1$>($1$& t, const char* data, "
+          "std::size_t size, ::struct_pb::UnknownFields& unknown_fields) {\n",
+          name);
+      format.indent();
+      g.generate_deserialize_to(p);
+      format.outdent();
+      format("return true;\n");
+      format("} // bool deserialize_to<$1$>($1$&, const char*, std::size_t)\n",
+             name);
+      format("// end of $1$\n", name);
+      format(
+          "template<>\n"
+          "bool deserialize_to<$1$>($1$& t, const char* data, "
+          "std::size_t size) {\n",
+          name);
+      format.indent();
+      format("::struct_pb::UnknownFields unknown_fields{};\n");
+      format("return deserialize_to(t,data,size,unknown_fields);\n");
+      format.outdent();
+      format("}\n");
+      format("\n");
+    }
   }
   format("} // internal\n");
   format("} // struct_pb\n");
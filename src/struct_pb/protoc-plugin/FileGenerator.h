@@ -15,6 +15,8 @@ class FileGenerator : public GeneratorBase {
   void generate_source(google::protobuf::io::Printer *p);
 
  private:
+  // the options of the messages, and of the view messages if generate_view.
+  std::vector<Options> all_message_options() const;
   void generate_shared_header_code(google::protobuf::io::Printer *p);
   void generate_fwd_decls(google::protobuf::io::Printer *p);
   void generate_enum_definitions(google::protobuf::io::Printer *p);
@@ -10,7 +10,8 @@ MapFieldGenerator::MapFieldGenerator(const FieldDescriptor *field,
                                      const Options &options)
     : FieldGenerator(field, options) {}
 
-static std::string get_type_name_help(FieldDescriptor::Type type) {
+static std::string get_type_name_help(FieldDescriptor::Type type,
+                                      const Options &options) {
   switch (type) {
     case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
       return "double";
@@ -34,7 +35,7 @@ static std::string get_type_name_help(FieldDescriptor::Type type) {
       return "bool";
     case google::protobuf::FieldDescriptor::TYPE_STRING:
     case google::protobuf::FieldDescriptor::TYPE_BYTES:
-      return "std::string";
+      return string_type_name(options);
     case google::protobuf::FieldDescriptor::TYPE_GROUP:
       // workaround for group
       return "std::string";
@@ -44,7 +45,8 @@ static std::string get_type_name_help(FieldDescriptor::Type type) {
   }
 }
 std::string MapFieldGenerator::cpp_type_name() const {
-  return "std::map<" + get_key_type_name() + ", " + get_value_type_name() + ">";
+  return map_type_name(options_) + "<" + get_key_type_name() + ", " +
+         get_value_type_name() + ">";
 }
 std::string MapFieldGenerator::get_value_type_name() const {
   return get_kv_type_name_helper(d_->message_type()->field(1));
@@ -61,7 +63,7 @@ std::string MapFieldGenerator::get_kv_type_name_helper(
     return qualified_enum_name(f->enum_type(), options_);
   }
   else {
-    return get_type_name_help(f->type());
+    return get_type_name_help(f->type(), options_);
   }
 }
 void MapFieldGenerator::generate_calculate_size(
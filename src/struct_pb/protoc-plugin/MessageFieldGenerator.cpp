@@ -5,10 +5,20 @@ namespace compiler {
 MessageFieldGenerator::MessageFieldGenerator(const FieldDescriptor *field,
                                              const Options &options)
     : FieldGenerator(field, options) {}
+bool MessageFieldGenerator::is_lazy() const { return d_->options().lazy(); }
 void MessageFieldGenerator::generate_calculate_size(
     google::protobuf::io::Printer *p, const std::string &value,
     bool can_ignore_default_value) const {
-  if (can_ignore_default_value) {
+  if (is_lazy()) {
+    // the raw bytes of an untouched lazy field are copied back.
+    p->Print({{"tag_sz", calculate_tag_size(d_)}, {"value", value}}, R"(
+if ($value$) {
+  auto sz = $value$.get_needed_size();
+  total += $tag_sz$ + calculate_varint_size(sz) + sz;
+}
+)");
+  }
+  else if (can_ignore_default_value) {
     p->Print({{"tag_sz", calculate_tag_size(d_)}, {"value", value}}, R"(
 if ($value$) {
   auto sz = get_needed_size(*$value$);
@@ -26,6 +36,18 @@ total += $tag_sz$ + calculate_varint_size(sz) + sz;
 void MessageFieldGenerator::generate_serialization(
     google::protobuf::io::Printer *p, const std::string &value,
     bool can_ignore_default_value) const {
+  if (is_lazy()) {
+    p->Print({{"value", value}, {"tag", calculate_tag_str(d_)}}, R"(
+if ($value$) {
+  serialize_varint(data, pos, size, $tag$);
+  auto sz = $value$.get_needed_size();
+  serialize_varint(data, pos, size, sz);
+  $value$.serialize_to(data + pos, sz);
+  pos += sz;
+}
+)");
+    return;
+  }
   p->Print({{"value", value}, {"tag", calculate_tag_str(d_)}}, R"(
 if ($value$) {
   serialize_varint(data, pos, size, $tag$);
@@ -38,12 +60,35 @@ if ($value$) {
 }
 void MessageFieldGenerator::generate_deserialization(
     google::protobuf::io::Printer *p, const std::string &value) const {
+  if (is_lazy()) {
+    // keep the raw bytes, they are decoded on first access.
+    p->Print({{"value", value}, {"tag", calculate_tag_str(d_)}},
+             R"(case $tag$: {
+  uint64_t sz = 0;
+  ok = deserialize_varint(data, pos, size, sz);
+  if (!ok) {
+    return false;
+  }
+  if (sz > size - pos) {
+    return false;
+  }
+  ok = $value$.deserialize_from(data + pos, sz);
+  if (!ok) {
+    return false;
+  }
+  pos += sz;
+  break;
+}
+)");
+    return;
+  }
   p->Print({{"value", value},
             {"tag", calculate_tag_str(d_)},
-            {"classname", qualified_class_name(d_->message_type(), options_)}},
+            {"classname", qualified_class_name(d_->message_type(), options_)},
+            {"make_ptr", make_message_ptr_name(options_)}},
            R"(case $tag$: {
   if (!$value$) {
-    $value$ = std::make_unique<$classname$>();
+    $value$ = $make_ptr$<$classname$>();
   }
   uint64_t sz = 0;
   ok = deserialize_varint(data, pos, size, sz);
@@ -60,7 +105,15 @@ void MessageFieldGenerator::generate_deserialization(
 )");
 }
 std::string MessageFieldGenerator::cpp_type_name() const {
-  return "std::unique_ptr<" +
+  if (is_lazy()) {
+    std::string type_name = "::struct_pb::lazy<" +
+                            qualified_class_name(d_->message_type(), options_);
+    if (options_.view || options_.arena) {
+      type_name += ", " + string_type_name(options_);
+    }
+    return type_name + ">";
+  }
+  return message_ptr_type_name(options_) + "<" +
          qualified_class_name(d_->message_type(), options_) + ">";
 }
 
@@ -120,8 +173,8 @@ void RepeatedMessageFieldGenerator::generate_deserialization(
 )");
 }
 std::string RepeatedMessageFieldGenerator::cpp_type_name() const {
-  return "std::vector<" + qualified_class_name(d_->message_type(), options_) +
-         ">";
+  return vector_type_name(options_) + "<" +
+         qualified_class_name(d_->message_type(), options_) + ">";
 }
 void RepeatedMessageFieldGenerator::generate_calculate_size_only(
     google::protobuf::io::Printer *p, const std::string &value) const {
@@ -15,6 +15,10 @@ class MessageFieldGenerator : public FieldGenerator {
   void generate_deserialization(google::protobuf::io::Printer *p,
                                 const std::string &value) const override;
   std::string cpp_type_name() const override;
+
+ private:
+  // the field is declared with [lazy = true].
+  bool is_lazy() const;
 };
 class RepeatedMessageFieldGenerator : public FieldGenerator {
  public:
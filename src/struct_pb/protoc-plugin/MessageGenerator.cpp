@@ -49,11 +49,18 @@ void MessageGenerator::generate_struct_definition(
     google::protobuf::io::Printer *p) {
   //  auto v = p->WithVars(ClassVars(d_, options_));
   Formatter format(p);
-  format("struct $1$ {\n", resolve_keyword(d_->name()));
+  format("struct $1$ {\n", struct_name(d_, options_.view));
   format.indent();
   for (int i = 0; i < d_->enum_type_count(); ++i) {
     auto e = d_->enum_type(i);
-    EnumGenerator(e, options_).generate_definition(p);
+    if (options_.view) {
+      // the view message shares the enums with the message.
+      format("using $1$ = $2$;\n", resolve_keyword(e->name()),
+             qualified_enum_name(e, options_));
+    }
+    else {
+      EnumGenerator(e, options_).generate_definition(p);
+    }
   }
   for (int i = 0; i < d_->oneof_decl_count(); ++i) {
     auto oneof = d_->oneof_decl(i);
@@ -115,7 +122,8 @@ void MessageGenerator::generate_struct_definition(
     }
   }
   if (options_.generate_eq_op) {
-    format("bool operator==(const $1$&) const = default;\n", class_name(d_));
+    format("bool operator==(const $1$&) const = default;\n",
+           class_name(d_, options_.view));
   }
   // format("std::size_t get_needed_size() const;\n");
   // format("std::string SerializeAsString() const;\n");
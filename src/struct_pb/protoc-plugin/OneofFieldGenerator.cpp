@@ -155,11 +155,12 @@ void OneofFieldGenerator::generate_deserialization_only(
            {"tag", std::to_string(calculate_tag(d_))},
            {"max_size", max_size},
            {"oneof_value", oneof_value},
-           {"index", index()}},
+           {"index", index()},
+           {"make_ptr", make_message_ptr_name(options_)}},
 
           R"(
 if ($value$.index() != $index$) {
-  $value$.emplace<$index$>(new $type_name$());
+  $value$.emplace<$index$>($make_ptr$<$type_name$>());
 }
 uint64_t msg_sz = 0;
 ok = deserialize_varint(data, pos, $max_size$, msg_sz);
@@ -227,6 +228,7 @@ void MessageOneofFieldGenerator::generate_setter_and_getter(
   type_name = qualified_class_name(d_->message_type(), options_);
   p->Print({{"name", resolve_keyword(d_->name())},
             {"type_name", type_name},
+            {"ptr_type", message_ptr_type_name(options_)},
             {"field_name", resolve_keyword(oneof->name())},
             {"index", index()}},
            R"(
@@ -237,7 +239,7 @@ void set_allocated_$name$($type_name$* p) {
   assert(p);
   $field_name$.emplace<$index$>(p);
 }
-const std::unique_ptr<$type_name$>& $name$() const {
+const $ptr_type$<$type_name$>& $name$() const {
   assert($field_name$.index() == $index$);
   return std::get<$index$>($field_name$);
 }
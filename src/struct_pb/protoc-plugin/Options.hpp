@@ -5,6 +5,13 @@
 struct Options {
   Options(const google::protobuf::FileDescriptor* f) : f(f) {}
   bool generate_eq_op = false;
+  // generate the view messages (FooView) besides the messages, whose string
+  // and bytes fields are std::string_view borrowed from the input buffer.
+  bool generate_view = false;
+  // whether the view messages are being generated.
+  bool view = false;
+  // allocate the strings, containers and submessages from struct_pb::arena.
+  bool arena = false;
   std::string ns;
   const google::protobuf::FileDescriptor* f;
 };
\ No newline at end of file
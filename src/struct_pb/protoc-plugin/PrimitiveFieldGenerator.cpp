@@ -275,7 +275,8 @@ bool RepeatedPrimitiveFieldGenerator::is_packed() const {
   return d_->is_packable() && d_->is_packed();
 }
 std::string RepeatedPrimitiveFieldGenerator::cpp_type_name() const {
-  return "std::vector<" + get_type_name_help(d_->type()) + ">";
+  return vector_type_name(options_) + "<" + get_type_name_help(d_->type()) +
+         ">";
 }
 void RepeatedPrimitiveFieldGenerator::generate_calculate_packed_size_only(
     google::protobuf::io::Printer *p, const std::string &value) const {
@@ -397,15 +398,18 @@ void RepeatedPrimitiveFieldGenerator::generate_deserialization_packed_only(
     google::protobuf::io::Printer *p, const std::string &value,
     const std::string &max_size) const {
   if (is_varint(d_)) {
-    Formatter format(p);
-    format("while (pos < $1$) {\n", max_size);
-    format.indent();
-    format("$1$ e{};\n", get_type_name_help(d_->type()));
-    PrimitiveFieldGenerator g(d_, options_);
-    g.generate_deserialization_only(p, "e");
-    format("$1$.push_back(e);\n", value);
-    format.outdent();
-    format("}\n");
+    // decode the varints in bulk, see deserialize_packed_varint.
+    p->Print({{"value", value},
+              {"max_size", max_size},
+              {"zigzag", is_sint(d_) ? "true" : "false"}},
+             R"(if ($max_size$ > size) {
+  return false;
+}
+ok = deserialize_packed_varint<$zigzag$>(data, pos, $max_size$, $value$);
+if (!ok) {
+  return false;
+}
+)");
   }
   else if (is_i64(d_) || is_i32(d_)) {
     auto sz = is_i64(d_) ? 8 : 4;
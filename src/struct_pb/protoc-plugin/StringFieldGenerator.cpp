@@ -72,13 +72,29 @@ void StringFieldGenerator::generate_serialization_only(
 }
 std::string StringFieldGenerator::cpp_type_name() const {
   if (d_->has_presence()) {
-    return "std::optional<std::string>";
+    return "std::optional<" + string_type_name(options_) + ">";
   }
-  return "std::string";
+  return string_type_name(options_);
 }
 void StringFieldGenerator::generate_deserialization_only(
     google::protobuf::io::Printer *p, const std::string &output,
     const std::string &sz, const std::string &max_size) const {
+  if (options_.view) {
+    // borrow the data from the input buffer.
+    p->Print({{"output", output}, {"sz", sz}, {"max_size", max_size}},
+             R"(uint64_t $sz$ = 0;
+ok = deserialize_varint(data, pos, $max_size$, $sz$);
+if (!ok) {
+  return false;
+}
+if (pos + $sz$ > $max_size$) {
+  return false;
+}
+$output$ = std::string_view(data + pos, $sz$);
+pos += $sz$;
+)");
+    return;
+  }
   p->Print({{"output", output}, {"sz", sz}, {"max_size", max_size}},
            R"(uint64_t $sz$ = 0;
 ok = deserialize_varint(data, pos, $max_size$, $sz$);
@@ -101,7 +117,7 @@ void StringFieldGenerator::generate_deserialization(
   if (is_optional()) {
     format("if (!$1$.has_value()) {\n", value);
     format.indent();
-    format("$1$ = std::string();\n", value);
+    format("$1$ = $2$();\n", value, string_type_name(options_));
     format.outdent();
     format("}\n");
     generate_deserialization_only(p, value + ".value()");
@@ -117,7 +133,7 @@ RepeatedStringFieldGenerator::RepeatedStringFieldGenerator(
     const FieldDescriptor *field, const Options &options)
     : FieldGenerator(field, options) {}
 std::string RepeatedStringFieldGenerator::cpp_type_name() const {
-  return "std::vector<std::string>";
+  return vector_type_name(options_) + "<" + string_type_name(options_) + ">";
 }
 void RepeatedStringFieldGenerator::generate_calculate_size(
     google::protobuf::io::Printer *p, const std::string &value,
@@ -174,7 +190,7 @@ void RepeatedStringFieldGenerator::generate_deserialization(
   Formatter format(p);
   format("case $1$: {\n", calculate_tag_str(d_));
   format.indent();
-  format("std::string tmp_str;\n");
+  format("$1$ tmp_str;\n", string_type_name(options_));
   g.generate_deserialization_only(p, "tmp_str");
   format("$1$.push_back(std::move(tmp_str));\n", value);
   format("break;\n");
@@ -21,6 +21,12 @@ bool StructGenerator::Generate(
     if (key == "generate_eq_op") {
       struct_pb_options.generate_eq_op = true;
     }
+    else if (key == "generate_view") {
+      struct_pb_options.generate_view = true;
+    }
+    else if (key == "arena") {
+      struct_pb_options.arena = true;
+    }
     else if (key == "namespace") {
       struct_pb_options.ns = value;
     }
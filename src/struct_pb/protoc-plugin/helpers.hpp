@@ -167,14 +167,22 @@ inline std::string resolve_keyword(const std::string &name) {
   }
   return name + "_";
 }
-inline std::string class_name(const google::protobuf::Descriptor *descriptor) {
+inline std::string struct_name(const google::protobuf::Descriptor *descriptor,
+                               bool view = false) {
+  if (view) {
+    return resolve_keyword(descriptor->name() + "View");
+  }
+  return resolve_keyword(descriptor->name());
+}
+inline std::string class_name(const google::protobuf::Descriptor *descriptor,
+                              bool view = false) {
   //  assert(descriptor);
   auto parent = descriptor->containing_type();
   std::string ret;
   if (parent) {
-    ret += class_name(parent) + "::";
+    ret += class_name(parent, view) + "::";
   }
-  ret += resolve_keyword(descriptor->name());
+  ret += struct_name(descriptor, view);
   return resolve_keyword(ret);
 }
 inline std::string enum_name(
@@ -229,7 +237,32 @@ inline std::string qualified_file_level_symbol(
 
 inline std::string qualified_class_name(const google::protobuf::Descriptor *d,
                                         const Options &options) {
-  return qualified_file_level_symbol(d->file(), class_name(d), options);
+  return qualified_file_level_symbol(d->file(), class_name(d, options.view),
+                                     options);
+}
+
+inline std::string string_type_name(const Options &options) {
+  if (options.view) {
+    return "std::string_view";
+  }
+  return options.arena ? "::struct_pb::arena_string" : "std::string";
+}
+
+inline std::string vector_type_name(const Options &options) {
+  return options.arena ? "::struct_pb::arena_vector" : "std::vector";
+}
+
+inline std::string map_type_name(const Options &options) {
+  return options.arena ? "::struct_pb::arena_map" : "std::map";
+}
+
+// the owning pointer of the submessages.
+inline std::string message_ptr_type_name(const Options &options) {
+  return options.arena ? "::struct_pb::arena_ptr" : "std::unique_ptr";
+}
+
+inline std::string make_message_ptr_name(const Options &options) {
+  return options.arena ? "::struct_pb::make_arena_ptr" : "std::make_unique";
 }
 
 inline std::string qualified_enum_name(
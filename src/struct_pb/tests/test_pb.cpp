@@ -848,4 +848,119 @@ TEST_CASE("testing all") {
   check_with_protobuf(t, pb_t);
 #endif
 }
+TEST_CASE("testing packed varint") {
+  // the values cross the windows of the bulk decoding, with runs of one byte
+  // varints and varints of all lengths.
+  test_struct_pb::MyTestInt32 t32{};
+  test_struct_pb::MyTestInt64 t64{};
+  for (int i = 0; i < 1000; ++i) {
+    t32.b.push_back(i % 100 < 70 ? i % 128 : i * (i % 2 ? -7919 : 7919));
+    t64.b.push_back(i % 100 < 70 ? i % 128 : (int64_t)i << (i % 56));
+  }
+  check_self(t32);
+  check_self(t64);
+#ifdef HAVE_PROTOBUF
+  MyTestInt32 pb_t32;
+  pb_t32.ParseFromString(struct_pb::serialize<std::string>(t32));
+  CHECK(std::equal(t32.b.begin(), t32.b.end(), pb_t32.b().begin(),
+                   pb_t32.b().end()));
+  MyTestInt64 pb_t64;
+  pb_t64.ParseFromString(struct_pb::serialize<std::string>(t64));
+  CHECK(std::equal(t64.b.begin(), t64.b.end(), pb_t64.b().begin(),
+                   pb_t64.b().end()));
+#endif
+
+  SUBCASE("zigzag") {
+    std::vector<int32_t> values{0, -1, 1, -64, 64, INT32_MIN, INT32_MAX};
+    std::string buf;
+    for (auto v : values) {
+      auto z = struct_pb::internal::encode_zigzag(v);
+      std::size_t pos = buf.size();
+      buf.resize(pos + struct_pb::internal::calculate_varint_size(z));
+      struct_pb::internal::serialize_varint(buf.data(), pos, buf.size(), z);
+    }
+    std::vector<int32_t> out{42};
+    std::size_t pos = 0;
+    CHECK(struct_pb::internal::deserialize_packed_varint<true>(
+        buf.data(), pos, buf.size(), out));
+    CHECK(pos == buf.size());
+    values.insert(values.begin(), 42);
+    CHECK(out == values);
+  }
+  SUBCASE("bad data") {
+    std::vector<uint64_t> out;
+    std::size_t pos = 0;
+    std::string buf(40, 0x01);
+    buf.back() = (char)0x80;
+    CHECK(!struct_pb::internal::deserialize_packed_varint(
+        buf.data(), pos, buf.size(), out));
+    pos = 0;
+    std::string too_long(40, (char)0x80);
+    too_long.back() = 0x01;
+    CHECK(!struct_pb::internal::deserialize_packed_varint(
+        too_long.data(), pos, too_long.size(), out));
+  }
+}
+TEST_CASE("testing lazy submessage") {
+  test_struct_pb::MyTestLazy t{};
+  t.id = 1;
+  t.payload = test_struct_pb::MyTestAll{};
+  t.payload->n = "lazy payload";
+  t.payload->h = -23234;
+  test_struct_pb::MyTestRepeatedMessage items{};
+  items.fs = {{1, 2, 3}, {4, 5, 6}};
+  t.items = std::move(items);
+  auto buf = struct_pb::serialize<std::string>(t);
+#ifdef HAVE_PROTOBUF
+  MyTestLazy pb_t;
+  REQUIRE(pb_t.ParseFromString(buf));
+  CHECK(pb_t.id() == 1);
+  CHECK(pb_t.payload().n() == "lazy payload");
+  CHECK(pb_t.items().fs_size() == 2);
+  CHECK(buf == pb_t.SerializeAsString());
+#endif
+
+  test_struct_pb::MyTestLazy d_t{};
+  REQUIRE(struct_pb::deserialize_to(d_t, buf));
+  CHECK(d_t.id == 1);
+  CHECK(d_t.payload.has_raw());
+  CHECK(!d_t.payload.is_parsed());
+  CHECK(d_t.items.has_raw());
+  // the untouched fields are copied back.
+  CHECK(struct_pb::serialize<std::string>(d_t) == buf);
+
+  const auto& c_t = d_t;
+  CHECK(c_t.payload->n == "lazy payload");
+  CHECK(c_t.payload->h == -23234);
+  CHECK(d_t.payload.is_parsed());
+  CHECK(d_t.payload.has_raw());
+  CHECK(d_t == t);
+
+  d_t.payload->n = "modified";
+  CHECK(!d_t.payload.has_raw());
+  t.payload->n = "modified";
+  CHECK(struct_pb::serialize<std::string>(d_t) ==
+        struct_pb::serialize<std::string>(t));
+
+  SUBCASE("bad submessage") {
+    std::string bad_buf{0x12, 0x02, 0x08, (char)0x80};
+    test_struct_pb::MyTestLazy b_t{};
+    REQUIRE(struct_pb::deserialize_to(b_t, bad_buf));
+    CHECK(!b_t.payload.parse());
+    // the failure is remembered, and the raw bytes are kept.
+    CHECK(!b_t.payload.parse());
+    CHECK(!b_t.payload.is_parsed());
+    const auto& c_b_t = b_t;
+    CHECK(c_b_t.payload->n.empty());
+    CHECK(b_t.payload.has_raw());
+    CHECK(struct_pb::serialize<std::string>(b_t) == bad_buf);
+    // the modified message replaces the raw bytes.
+    b_t.payload->n = "fixed";
+    CHECK(!b_t.payload.has_raw());
+    test_struct_pb::MyTestLazy r_t{};
+    REQUIRE(struct_pb::deserialize_to(
+        r_t, struct_pb::serialize<std::string>(b_t)));
+    CHECK(r_t.payload->n == "fixed");
+  }
+}
 TEST_SUITE_END;
\ No newline at end of file
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string>
+#include <string_view>
+
+#include "data_def.struct_pb.h"
+#include "doctest.h"
+#include "struct_pb_sample.hpp"
+#include "test_pb_arena.struct_pb.h"
+using namespace doctest;
+
+namespace {
+template <typename T>
+constexpr bool can_deserialize_with_arena =
+    requires(T& t, const std::string& buf, struct_pb::arena& arena) {
+      struct_pb::deserialize_to(t, buf, arena);
+    };
+}  // namespace
+
+TEST_SUITE_BEGIN("test pb arena");
+
+TEST_CASE("testing arena") {
+  auto my_ms = struct_pb_sample::create_monsters(OBJECT_COUNT);
+  auto buf = struct_pb::serialize<std::string>(my_ms);
+
+  struct_pb::arena arena;
+  auto ms = arena.create<struct_pb_arena_sample::Monsters>();
+  REQUIRE(struct_pb::deserialize_to(ms, buf, arena));
+  REQUIRE(ms->monsters.size() == my_ms.monsters.size());
+  CHECK(ms->monsters.get_allocator().resource() == arena.resource());
+  for (std::size_t i = 0; i < ms->monsters.size(); ++i) {
+    auto& m = ms->monsters[i];
+    auto& my_m = my_ms.monsters[i];
+    // the nested strings, containers and submessages are from the arena.
+    CHECK(m.name.get_allocator().resource() == arena.resource());
+    CHECK(m.weapons.get_allocator().resource() == arena.resource());
+    CHECK(m.weapons[0].name.get_allocator().resource() == arena.resource());
+    REQUIRE(m.pos);
+    CHECK(m.pos.get_deleter().resource == arena.resource());
+    CHECK(m.pos->x == my_m.pos->x);
+    CHECK(m.mana == my_m.mana);
+    CHECK(std::string_view{m.name} == my_m.name);
+    CHECK(std::string_view{m.inventory} == my_m.inventory);
+    REQUIRE(m.weapons.size() == my_m.weapons.size());
+    CHECK(std::string_view{m.weapons[1].name} == my_m.weapons[1].name);
+    CHECK(m.weapons[1].damage == my_m.weapons[1].damage);
+    REQUIRE(m.equipped);
+    CHECK(std::string_view{m.equipped->name} == my_m.equipped->name);
+    CHECK(m.path.size() == my_m.path.size());
+  }
+  CHECK(struct_pb::serialize<std::string>(*ms) == buf);
+
+  SUBCASE("without arena") {
+    // the messages are allocated from the default resource out of a scope.
+    struct_pb_arena_sample::Monsters heap_ms;
+    REQUIRE(struct_pb::deserialize_to(heap_ms, buf));
+    CHECK(heap_ms.monsters.get_allocator().resource() ==
+          std::pmr::get_default_resource());
+    CHECK(struct_pb::serialize<std::string>(heap_ms) == buf);
+  }
+  SUBCASE("message out of the arena") {
+    // the top level members of a message on the stack aren't allocated from
+    // the arena, so it can't be deserialized with the arena.
+    static_assert(
+        !can_deserialize_with_arena<struct_pb_arena_sample::Monsters>);
+    static_assert(can_deserialize_with_arena<
+                  struct_pb::arena_ptr<struct_pb_arena_sample::Monsters>>);
+    struct_pb::arena other;
+    auto other_ms = other.create<struct_pb_arena_sample::Monsters>();
+    CHECK(!struct_pb::deserialize_to(other_ms, buf, arena));
+    CHECK(other_ms->monsters.empty());
+    struct_pb::arena_ptr<struct_pb_arena_sample::Monsters> null_ms;
+    CHECK(!struct_pb::deserialize_to(null_ms, buf, arena));
+  }
+}
+TEST_CASE("testing arena lazy submessage") {
+  struct_pb::arena arena;
+  auto m = arena.create<struct_pb_arena_sample::LazyMonster>();
+  {
+    struct_pb::arena::scope scope(arena);
+    m->id = 1;
+    struct_pb_arena_sample::Monster monster{};
+    monster.name = std::string(100, 'm');
+    m->monster = std::move(monster);
+  }
+  CHECK(m->monster->name.get_allocator().resource() == arena.resource());
+  auto buf = struct_pb::serialize<std::string>(*m);
+
+  auto d = arena.create<struct_pb_arena_sample::LazyMonster>();
+  REQUIRE(struct_pb::deserialize_to(d, buf, arena));
+  CHECK(d->monster.has_raw());
+  // decoded out of the scope of the arena.
+  const auto& c = *d;
+  CHECK(std::string_view{c.monster->name} == std::string(100, 'm'));
+  CHECK(c.monster->name.get_allocator().resource() == arena.resource());
+  CHECK(struct_pb::serialize<std::string>(*d) == buf);
+}
+TEST_SUITE_END;
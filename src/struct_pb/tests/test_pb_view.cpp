@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023, Alibaba Group Holding Limited;
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "doctest.h"
+#include "helper.hpp"
+using namespace doctest;
+
+namespace {
+bool in_buffer(const std::string& buffer, std::string_view view) {
+  return view.data() >= buffer.data() &&
+         view.data() + view.size() <= buffer.data() + buffer.size();
+}
+}  // namespace
+
+TEST_SUITE_BEGIN("test pb view");
+TEST_CASE("testing view messages") {
+  static_assert(std::is_same_v<decltype(test_struct_pb::Test2View::b),
+                               std::string_view>);
+  static_assert(
+      std::is_same_v<decltype(test_struct_pb::MyTestEnumView::color),
+                     decltype(test_struct_pb::MyTestEnum::color)>);
+  SUBCASE("string and bytes") {
+    test_struct_pb::MyTestAll t{};
+    t.c = 42;
+    t.n = "hello struct_pb";
+    t.o = std::string("\0\1\2bytes", 8);
+    auto buffer = struct_pb::serialize<std::string>(t);
+    test_struct_pb::MyTestAllView v{};
+    REQUIRE(struct_pb::deserialize_to(v, buffer));
+    CHECK(v.c == 42);
+    CHECK(v.n == t.n);
+    CHECK(v.o == t.o);
+    CHECK(in_buffer(buffer, v.n));
+    CHECK(in_buffer(buffer, v.o));
+    // forward the view without copying the strings.
+    CHECK(struct_pb::serialize<std::string>(v) == buffer);
+  }
+  SUBCASE("repeated field") {
+    test_struct_pb::Test4 t4{"nested", {1, 2, 3}};
+    auto buffer = struct_pb::serialize<std::string>(t4);
+    test_struct_pb::Test4View v{};
+    REQUIRE(struct_pb::deserialize_to(v, buffer));
+    CHECK(v.d == "nested");
+    CHECK(in_buffer(buffer, v.d));
+    CHECK(v.e == t4.e);
+    CHECK(struct_pb::serialize<std::string>(v) == buffer);
+  }
+  SUBCASE("map") {
+    test_struct_pb::MyTestMap t{};
+    t.e["a"] = 1;
+    t.e["bb"] = 2;
+    auto buffer = struct_pb::serialize<std::string>(t);
+    test_struct_pb::MyTestMapView v{};
+    REQUIRE(struct_pb::deserialize_to(v, buffer));
+    REQUIRE(v.e.size() == 2);
+    CHECK(v.e["bb"] == 2);
+    for (const auto& [key, value] : v.e) {
+      CHECK(in_buffer(buffer, key));
+    }
+    CHECK(struct_pb::serialize<std::string>(v) == buffer);
+  }
+  SUBCASE("oneof") {
+    test_struct_pb::SampleMessageOneof t{};
+    t.set_name("oneof");
+    auto buffer = struct_pb::serialize<std::string>(t);
+    test_struct_pb::SampleMessageOneofView v{};
+    REQUIRE(struct_pb::deserialize_to(v, buffer));
+    REQUIRE(v.has_name());
+    CHECK(v.name() == "oneof");
+    CHECK(in_buffer(buffer, v.name()));
+    CHECK(struct_pb::serialize<std::string>(v) == buffer);
+  }
+  SUBCASE("lazy submessage occurs twice") {
+    test_struct_pb::MyTestLazy first{};
+    first.payload = test_struct_pb::MyTestAll{};
+    first.payload->n = "first";
+    test_struct_pb::MyTestLazy second{};
+    second.payload = test_struct_pb::MyTestAll{};
+    second.payload->h = -23234;
+    // the occurrences are merged like the eager fields.
+    auto buffer = struct_pb::serialize<std::string>(first) +
+                  struct_pb::serialize<std::string>(second);
+    test_struct_pb::MyTestLazyView v{};
+    REQUIRE(struct_pb::deserialize_to(v, buffer));
+    CHECK(!v.payload.has_raw());
+    CHECK(v.payload->n == "first");
+    CHECK(in_buffer(buffer, v.payload->n));
+    CHECK(v.payload->h == -23234);
+  }
+  SUBCASE("truncated") {
+    test_struct_pb::Test2 t{"truncated"};
+    auto buffer = struct_pb::serialize<std::string>(t);
+    buffer.pop_back();
+    test_struct_pb::Test2View v{};
+    CHECK(!struct_pb::deserialize_to(v, buffer));
+  }
+}
+TEST_SUITE_END;